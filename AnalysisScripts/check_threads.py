@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+
+# Checks that the analysis step gives the same results with one and with several threads.
+#
+# The datacard is run with fitter.py once with --nThreads 1 and once with --nThreads N. The files written by
+# each job (histograms, workspace, counters, event lists) are moved to check_threads_1 and check_threads_N and then 
+# compared: histograms bin by bin, datasets by number of entries and sum of weights, text files line by line and 
+# number by number. The event lists written by the worker threads must have been merged back and deleted.
+# The number of entries must agree exactly, sums of weights within the tolerance, since the worker results
+# are summed in a different order than in the single-threaded job.
+#
+# Usage:
+#   ./check_threads.py -i <datacard> [--nThreads N] [--tolerance t] [-- <other fitter.py options>]
+#   ./check_threads.py --compare <reference_dir> <test_dir>
+
+import os, sys, time, shutil, commands
+from optparse import OptionParser
+
+parser = OptionParser()
+parser.add_option("-i","--inputDat",dest="inputDat")
+parser.add_option("-n","--nThreads",dest="nThreads",type="int",default=4)
+parser.add_option("-t","--tolerance",dest="tolerance",type="float",default=1.e-5)
+parser.add_option("","--compare",dest="compare",action="store_true",default=False,help="only compare the files in two folders")
+(options,args)=parser.parse_args()
+
+import ROOT
+ROOT.gROOT.SetBatch(1)
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+def run(nthreads,extra):
+  "runs fitter.py and moves the files it wrote to check_threads_<nthreads>"
+  outdir = "check_threads_%d" % nthreads
+  if os.path.isdir(outdir):
+    shutil.rmtree(outdir)
+  start = time.time()-1.
+  cmd = "./fitter.py -i %s --nThreads %d %s" % ( options.inputDat, nthreads, " ".join(extra) )
+  print cmd
+  status, output = commands.getstatusoutput(cmd)
+  log = open("%s.log" % outdir,"w")
+  log.write(output)
+  log.close()
+  if status != 0:
+    sys.exit("%s failed. See %s.log" % (cmd,outdir))
+  leftover = []
+  for dirpath, dirnames, filenames in os.walk("."):
+    dirnames[:] = [ d for d in dirnames if not d.startswith("check_threads_") ]
+    for f in filenames:
+      path = os.path.join(dirpath,f)
+      if ".worker" in os.path.splitext(f)[1] and os.path.getmtime(path) >= start:
+        leftover.append(path)
+      if os.path.splitext(f)[1] in [".root",".txt",".json"] and os.path.getmtime(path) >= start:
+        dest = os.path.join(outdir,os.path.relpath(path,"."))
+        if not os.path.isdir(os.path.dirname(dest)):
+          os.makedirs(os.path.dirname(dest))
+        shutil.move(path,dest)
+  if leftover:
+    sys.exit("Output of the worker threads not merged: %s" % " ".join(leftover))
+  return outdir
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+def close(a,b):
+  return abs(a-b) <= options.tolerance*max(1.,abs(a),abs(b))
+
+def compareHistos(name,ref,test):
+  if ref.GetEntries() != test.GetEntries():
+    return ["%s: %d entries, %d with threads" % (name,ref.GetEntries(),test.GetEntries())]
+  if ref.GetNbinsX() != test.GetNbinsX() or ref.GetNbinsY() != test.GetNbinsY() or ref.GetNbinsZ() != test.GetNbinsZ():
+    return ["%s: different binning" % name]
+  for ibin in range(ref.GetSize()):
+    if not close(ref.GetBinContent(ibin),test.GetBinContent(ibin)) or not close(ref.GetBinError(ibin),test.GetBinError(ibin)):
+      return ["%s: bin %d is %g +- %g, %g +- %g with threads" % (name,ibin,ref.GetBinContent(ibin),ref.GetBinError(ibin),
+                                                                 test.GetBinContent(ibin),test.GetBinError(ibin))]
+  return []
+
+def compareWorkspaces(name,ref,test):
+  diffs = []
+  refdata = dict( (d.GetName(),d) for d in ref.allData() )
+  testdata = dict( (d.GetName(),d) for d in test.allData() )
+  for dname in sorted(set(refdata.keys()+testdata.keys())):
+    if dname not in refdata or dname not in testdata:
+      diffs.append("%s/%s: only in one of the files" % (name,dname))
+      continue
+    r, t = refdata[dname], testdata[dname]
+    if r.numEntries() != t.numEntries() or not close(r.sumEntries(),t.sumEntries()):
+      diffs.append("%s/%s: %d entries with weight %g, %d with weight %g with threads" % (name,dname,r.numEntries(),r.sumEntries(),
+                                                                                         t.numEntries(),t.sumEntries()))
+  return diffs
+
+def compareDirectories(name,ref,test):
+  diffs = []
+  refkeys = set( k.GetName() for k in ref.GetListOfKeys() )
+  testkeys = set( k.GetName() for k in test.GetListOfKeys() )
+  for k in sorted(refkeys ^ testkeys):
+    diffs.append("%s/%s: only in one of the files" % (name,k))
+  for k in sorted(refkeys & testkeys):
+    r, t = ref.Get(k), test.Get(k)
+    path = "%s/%s" % (name,k)
+    if r.InheritsFrom("TDirectory"):
+      diffs += compareDirectories(path,r,t)
+    elif r.InheritsFrom("TH1"):
+      diffs += compareHistos(path,r,t)
+    elif r.InheritsFrom("RooWorkspace"):
+      diffs += compareWorkspaces(path,r,t)
+    elif r.InheritsFrom("TTree") and r.GetEntries() != t.GetEntries():
+      diffs.append("%s: %d entries, %d with threads" % (path,r.GetEntries(),t.GetEntries()))
+  return diffs
+
+def compareText(name,ref,test):
+  reflines, testlines = open(ref).read().splitlines(), open(test).read().splitlines()
+  if len(reflines) != len(testlines):
+    return ["%s: %d lines, %d with threads" % (name,len(reflines),len(testlines))]
+  for iline,(refline,testline) in enumerate(zip(reflines,testlines)):
+    reftok, testtok = refline.split(), testline.split()
+    same = ( len(reftok) == len(testtok) )
+    for r,t in zip(reftok,testtok):
+      try:
+        same = same and close(float(r),float(t))
+      except ValueError:
+        same = same and ( r == t )
+    if not same:
+      return ["%s: line %d is\n  %s\n  %s\nwith threads" % (name,iline+1,refline,testline)]
+  return []
+
+def compare(refdir,testdir):
+  diffs = []
+  nfiles = 0
+  for dirpath, dirnames, filenames in os.walk(refdir):
+    for f in filenames:
+      ref = os.path.join(dirpath,f)
+      name = os.path.relpath(ref,refdir)
+      test = os.path.join(testdir,name)
+      if not os.path.isfile(test):
+        diffs.append("%s: missing from %s" % (name,testdir))
+        continue
+      nfiles += 1
+      if f.endswith(".root"):
+        reffile, testfile = ROOT.TFile.Open(ref), ROOT.TFile.Open(test)
+        diffs += compareDirectories(name,reffile,testfile)
+        reffile.Close(), testfile.Close()
+      else:
+        diffs += compareText(name,ref,test)
+  return nfiles, diffs
+
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+if options.compare:
+  if len(args) != 2:
+    sys.exit("--compare needs the reference and the test folders")
+  refdir, testdir = args
+else:
+  if not options.inputDat or options.nThreads < 2:
+    sys.exit("Usage: check_threads.py -i <datacard> --nThreads N (N > 1) [-- <other fitter.py options>]")
+  refdir = run(1,args)
+  testdir = run(options.nThreads,args)
+
+nfiles, diffs = compare(refdir,testdir)
+for d in diffs:
+  print d
+if nfiles == 0:
+  sys.exit("No output files found in %s" % refdir)
+if diffs:
+  sys.exit("%d differences found between %s and %s" % (len(diffs),refdir,testdir))
+print "%d files identical in %s and %s" % (nfiles,refdir,testdir)
@@ -8,6 +8,7 @@ import sys
 from python.runOptions import parser
 parser.add_option("-f","--files",dest="files",type="string",action="store",default="")
 parser.add_option("-o","--output",dest="output",type="string",action="store",default="")
+parser.add_option("","--prefetchBytes",dest="prefetchBytes",type="float",action="store",default=0,help="maximum size of the files read ahead (with --prefetchFiles)")
 (options,args)=parser.parse_args()
 if (int(options.nJobs) > 0) and (int(options.jobId) >= int(options.nJobs)):
   sys.exit("Job id's must run from 0 -> %d when splitting into %d jobs"%(int(options.nJobs)-1,int(options.nJobs)))
@@ -33,6 +34,10 @@ if options.files != "":
 ut = ROOT.LoopAll();
 cfg = configProducer(ut,config_file,0,int(options.nJobs),int(options.jobId),files=fnames,histfile=options.output,mountEos=options.mountEos,debug=options.verbose)
 #cfg = configProducer(ut,config_file,0,-1,0)
+if options.prefetchFiles > 0:
+  ut.prefetchFiles = options.prefetchFiles
+if options.prefetchBytes > 0:
+  ut.prefetchBytes = long(options.prefetchBytes)
 
 if not options.dryRun:
   ut.MergeContainers()
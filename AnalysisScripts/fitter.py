@@ -37,6 +37,12 @@ ROOT.gROOT.cd()
 if not options.dryRun:
   if options.watchDutyCycle:
     ut.checkDuty(1000,options.minDutyCycle,options.watchDutyCycleAfter)
+  if options.nThreads > 1:
+    ut.nThreads = options.nThreads
+  if options.prefetchFiles > 0:
+    ut.prefetchFiles = options.prefetchFiles
+  if options.checkCompiledMvas:
+    ut.checkCompiledMvas = 1
   ut.LoopAndFillHistos();
   ROOT.gBenchmark.Show("Analysis");
 
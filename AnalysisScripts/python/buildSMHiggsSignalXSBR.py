@@ -58,3 +58,16 @@ def getXS(mh,prod):
  funcXS = SM.modelBuilder.out.function("SM_XS_%s_%s"%(prod,options.funcXSext))
  return funcXS.getVal()
 
+
+def writeTable(fname,source,mhmin,npoints,step):
+ # one line per mass point, read back by Normalization_8TeV.
+ # The first line identifies what the table was made from, so that a stale table is not used
+ out = open(fname,"w")
+ out.write("# source %s\n" % source)
+ out.write("# mH BR ggH qqH ttH WH ZH\n")
+ funcsXS = [ SM.modelBuilder.out.function("SM_XS_%s_%s"%(prod,options.funcXSext)) for prod in ["ggH","qqH","ttH","WH","ZH"] ]
+ for i in range(npoints):
+  mh = round(mhmin+i*step,6)
+  mhVar.setVal(mh)
+  out.write("%.6f %.17g %s\n" % (mh, funcBR.getVal(), " ".join(["%.17g" % f.getVal() for f in funcsXS])))
+ out.close()
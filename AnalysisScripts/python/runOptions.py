@@ -14,5 +14,8 @@ parser.add_option("-w","--watchDutyCycle",dest="watchDutyCycle",action="store_tr
 parser.add_option("--minDutyCycle",dest="minDutyCycle",action="store",type="int",default=0.5)
 parser.add_option("--watchDutyCycleAfter",dest="watchDutyCycleAfter",action="store",type="int",default=15)
 parser.add_option("--mountEos",dest="mountEos",action="store_true",default=False)
+parser.add_option("--nThreads",dest="nThreads",action="store",type="int",default=1)
+parser.add_option("--prefetchFiles",dest="prefetchFiles",action="store",type="int",default=0)
+parser.add_option("--checkCompiledMvas",dest="checkCompiledMvas",action="store_true",default=False)
 
 
@@ -22,5 +22,9 @@ cfg = configProducer(ut,config_file,1,int(options.nJobs),int(options.jobId),debu
 if not options.dryRun:
     if options.watchDutyCycle:
         ut.checkDuty(1000,options.minDutyCycle,options.watchDutyCycleAfter)
+    if options.prefetchFiles > 0:
+        ut.prefetchFiles = options.prefetchFiles
+    if options.checkCompiledMvas:
+        ut.checkCompiledMvas = 1
     ut.LoopAndFillHistos()
 ROOT.gBenchmark.Show("Reduction")
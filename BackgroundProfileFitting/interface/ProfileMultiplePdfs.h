@@ -24,6 +24,11 @@ class ProfileMultiplePdfs {
     void addPdf(RooAbsPdf *pdf, float penaltyTerm=0.);
     void clearPdfs();
     void printPdfs();
+    // number of worker processes sharing the fits of the likelihood scans (default 1: scan in this process)
+    void setNWorkers(int nWorkers);
+    // number of consecutive points of a scan fitted from the nominal fit onwards, each point starting from the previous one.
+    // It sets the scan results, which do not depend on the number of workers (default 50)
+    void setScanPieceSize(int scanPieceSize);
 
     pair<double,map<string,TGraph*> > profileLikelihood(RooAbsData *data, RooRealVar *obs_var, RooRealVar *var, float low, float high, float stepsize);
     map<string,TGraph*> profileLikelihoodEnvelope(RooAbsData *data, RooRealVar *var, float low, float high, float stepsize);
@@ -60,12 +65,18 @@ class ProfileMultiplePdfs {
     void addToResultMap(float var, float minNll, RooAbsPdf* pdf);
     void saveValues(map<string,double> &vals, RooArgSet* params);
     void setValues(map<string,double> vals, RooArgSet *params);
+
+    vector<float> scanPoints(float low, float high, float stepsize, bool includeHigh);
+    void scanPdf(RooAbsData *data, RooRealVar *var, RooAbsPdf *pdf, map<string,double> &startValues, const vector<float> &points, int first, int last, double *twiceMinNll);
+    vector<vector<double> > runScan(RooAbsData *data, RooRealVar *var, vector<map<string,double> > &startValues, const vector<float> &points);
     
     map<string,pair<RooAbsPdf*,float> > listOfPdfs;
     map<float,pair<float,RooAbsPdf*> > chosenPdfs;
     RooAbsPdf *bestFitPdf;
     double bestFitVal;
     double globalMinNLL;
+    int nWorkers_;
+    int scanPieceSize_;
 
     static TGraph* getMinPoints(TGraph *graph);
     static TGraph* getCrossingPointHigh(TGraph *graph, float crossing);
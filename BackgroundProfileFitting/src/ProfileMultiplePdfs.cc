@@ -1,4 +1,9 @@
 #include <map>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "TCanvas.h"
 #include "TMath.h"
@@ -9,7 +14,19 @@
 
 #include "../interface/ProfileMultiplePdfs.h"
 
-ProfileMultiplePdfs::ProfileMultiplePdfs(){
+namespace {
+  // one fitted point of a likelihood scan, as sent back by the scan workers
+  struct scan_result_t {
+    int pdf;
+    int point;
+    double twiceMinNll;
+  };
+}
+
+ProfileMultiplePdfs::ProfileMultiplePdfs():
+  nWorkers_(1),
+  scanPieceSize_(50)
+{
   listOfPdfs.clear();
   //listOfPdfs = new RooArgList();
 }
@@ -104,6 +121,148 @@ void ProfileMultiplePdfs::setValues(map<string,double> vals, RooArgSet *params){
   }
 }
 
+void ProfileMultiplePdfs::setNWorkers(int nWorkers){
+  nWorkers_ = (nWorkers<1 ? 1 : nWorkers);
+}
+
+void ProfileMultiplePdfs::setScanPieceSize(int scanPieceSize){
+  scanPieceSize_ = (scanPieceSize<1 ? 1 : scanPieceSize);
+}
+
+vector<float> ProfileMultiplePdfs::scanPoints(float low, float high, float stepsize, bool includeHigh){
+  // same float accumulation as the scan loops always used, so the points (and result map keys) do not move
+  vector<float> points;
+  if (includeHigh) for (float v=low; v<(high+stepsize); v+=stepsize) points.push_back(v);
+  else for (float v=low; v<high; v+=stepsize) points.push_back(v);
+  return points;
+}
+
+void ProfileMultiplePdfs::scanPdf(RooAbsData *data, RooRealVar *var, RooAbsPdf *pdf, map<string,double> &startValues, const vector<float> &points, int first, int last, double *twiceMinNll){
+  // each point starts from the parameters fitted at the previous one
+  RooArgSet *params = pdf->getParameters(*var);
+  setValues(startValues,params);
+  delete params;
+  for (int p=first; p<last; p++){
+    var->setConstant(false);
+    var->setVal(points[p]);
+    var->setConstant(true);
+    RooFitResult *scan = pdf->fitTo(*data,PrintLevel(-1),PrintEvalErrors(-1),Warnings(false),Save(true));
+    twiceMinNll[p] = 2*scan->minNll();
+    delete scan;
+  }
+}
+
+vector<vector<double> > ProfileMultiplePdfs::runScan(RooAbsData *data, RooRealVar *var, vector<map<string,double> > &startValues, const vector<float> &points){
+
+  // the scan of every pdf is cut in contiguous pieces of scanPieceSize_ points, each started from the nominal fit.
+  // The pieces do not depend on the number of workers, which only changes how they are scheduled, not the curves
+  int npdfs = listOfPdfs.size();
+  int npoints = points.size();
+  vector<vector<double> > twiceMinNlls(npdfs,vector<double>(npoints,0.));
+  if (npdfs==0 || npoints==0) return twiceMinNlls;
+  vector<RooAbsPdf*> pdfs;
+  for (map<string,pair<RooAbsPdf*,float> >::iterator m=listOfPdfs.begin(); m!=listOfPdfs.end(); m++) pdfs.push_back(m->second.first);
+  vector<pair<int,pair<int,int> > > tasks;
+  for (int i=0; i<npdfs; i++){
+    for (int first=0; first<npoints; first+=scanPieceSize_){
+      tasks.push_back(make_pair(i,make_pair(first,(first+scanPieceSize_<npoints ? first+scanPieceSize_ : npoints))));
+    }
+  }
+
+  int nProc = (nWorkers_<(int)tasks.size() ? nWorkers_ : (int)tasks.size());
+  if (nProc<=1) {
+    for (unsigned int t=0; t<tasks.size(); t++){
+      int i = tasks[t].first;
+      cout << "\t pdf " << i << "/" << npdfs << " (" << pdfs[i]->GetName() << ")" << endl;
+      scanPdf(data,var,pdfs[i],startValues[i],points,tasks[t].second.first,tasks[t].second.second,&twiceMinNlls[i][0]);
+    }
+    return twiceMinNlls;
+  }
+
+  // RooFit and Minuit are not thread safe: the workers are forked processes, each fitting its own copy of the pdfs and data,
+  // and sending back (pdf, point, 2*minNll) through a pipe
+  cout << "\t " << tasks.size() << " pieces of " << npdfs << " pdfs on " << nProc << " workers" << endl;
+  cout.flush();
+  fflush(stdout);
+  vector<pid_t> pids;
+  vector<int> fds;
+  for (int w=0; w<nProc; w++){
+    int fd[2];
+    if (pipe(fd)!=0) {
+      cerr << "ERROR -- cannot create pipe for scan worker " << w << endl;
+      exit(1);
+    }
+    pid_t pid = fork();
+    if (pid<0) {
+      cerr << "ERROR -- cannot fork scan worker " << w << endl;
+      exit(1);
+    }
+    if (pid==0) {
+      close(fd[0]);
+      for (int f=0; f<(int)fds.size(); f++) close(fds[f]);
+      for (unsigned int t=w; t<tasks.size(); t+=nProc){
+        int i = tasks[t].first;
+        int first = tasks[t].second.first;
+        int last = tasks[t].second.second;
+        scanPdf(data,var,pdfs[i],startValues[i],points,first,last,&twiceMinNlls[i][0]);
+        for (int p=first; p<last; p++){
+          scan_result_t res;
+          res.pdf = i;
+          res.point = p;
+          res.twiceMinNll = twiceMinNlls[i][p];
+          const char *buf = (const char*)&res;
+          size_t done = 0;
+          while (done<sizeof(res)){
+            ssize_t n = write(fd[1],buf+done,sizeof(res)-done);
+            if (n<=0) _exit(1);
+            done += n;
+          }
+        }
+      }
+      close(fd[1]);
+      cout.flush();
+      fflush(stdout);
+      _exit(0);
+    }
+    close(fd[1]);
+    pids.push_back(pid);
+    fds.push_back(fd[0]);
+  }
+
+  // a worker blocked on a full pipe simply waits for its turn to be read
+  vector<vector<bool> > filled(npdfs,vector<bool>(npoints,false));
+  for (int w=0; w<nProc; w++){
+    scan_result_t res;
+    char *buf = (char*)&res;
+    size_t done = 0;
+    ssize_t n;
+    while ((n = read(fds[w],buf+done,sizeof(res)-done))>0){
+      done += n;
+      if (done<sizeof(res)) continue;
+      if (res.pdf>=0 && res.pdf<npdfs && res.point>=0 && res.point<npoints){
+        twiceMinNlls[res.pdf][res.point] = res.twiceMinNll;
+        filled[res.pdf][res.point] = true;
+      }
+      done = 0;
+    }
+    close(fds[w]);
+  }
+  bool failed = false;
+  for (int w=0; w<nProc; w++){
+    int status = 0;
+    if (waitpid(pids[w],&status,0)<0 || !WIFEXITED(status) || WEXITSTATUS(status)!=0) {
+      cerr << "ERROR -- scan worker " << w << " did not finish" << endl;
+      failed = true;
+    }
+  }
+  for (int i=0; i<npdfs; i++) for (int p=0; p<npoints; p++) if (!filled[i][p]) failed = true;
+  if (failed) {
+    cerr << "ERROR -- likelihood scan incomplete" << endl;
+    exit(1);
+  }
+  return twiceMinNlls;
+}
+
 // no penalty
 pair<double,map<string,TGraph*> > ProfileMultiplePdfs::profileLikelihood(RooAbsData *data, RooRealVar *obs_var, RooRealVar *var, float low, float high, float stepsize){
  
@@ -130,27 +289,19 @@ pair<double,map<string,TGraph*> > ProfileMultiplePdfs::profileLikelihood(RooAbsD
   cout << "\tmu  = " << bestFitVal << endl;
   cout << "\tpdf = " << bestFitPdf->GetName() << endl;
 
-  // now perform the scan
+  // now perform the scan, every pdf starting from the nominal values
   cout << "Scanning...." << endl;
+  vector<float> points = scanPoints(low,high,stepsize,true);
+  vector<map<string,double> > startValues(listOfPdfs.size(),mapOfValues);
+  vector<vector<double> > twiceMinNlls = runScan(data,var,startValues,points);
   for (map<string,pair<RooAbsPdf*,float> >::iterator m=listOfPdfs.begin(); m!=listOfPdfs.end(); m++) { 
     RooAbsPdf *pdf = m->second.first;
-    cout << "\t pdf " << distance(listOfPdfs.begin(),m) << "/" << listOfPdfs.size() << " (" << pdf->GetName() << ")" << endl;
+    int i = distance(listOfPdfs.begin(),m);
     TGraph *thisNLL = new TGraph();
-    int p=0;
-    for (float v=low; v<(high+stepsize); v+=stepsize){
-      cout << Form("\t%5.1f%%\r",100.*(v-low)/(high-low)) << flush;
-      RooArgSet *params = (RooArgSet*)pdf->getParameters(*var);
-      setValues(mapOfValues,params);
-      var->setConstant(false);
-      var->setVal(v);
-      var->setConstant(true);
-      RooFitResult *scan = pdf->fitTo(*data,PrintLevel(-1),PrintEvalErrors(-1),Warnings(false),Save(true));
-      thisNLL->SetPoint(p,v,TMath::Min(25.,(2*scan->minNll()-globalMinNLL)));
-      addToResultMap(v,TMath::Min(25.,(2*scan->minNll()-globalMinNLL)),pdf);
-      p++;
-      delete scan;
+    for (unsigned int p=0; p<points.size(); p++){
+      thisNLL->SetPoint(p,points[p],TMath::Min(25.,(twiceMinNlls[i][p]-globalMinNLL)));
+      addToResultMap(points[p],TMath::Min(25.,(twiceMinNlls[i][p]-globalMinNLL)),pdf);
     }
-    cout << endl;
     thisNLL->SetName(Form("minnll_%s_%s",pdf->GetName(),data->GetName()));
     minNlls.insert(pair<string,TGraph*>(pdf->GetName(),thisNLL));
   }
@@ -251,11 +402,15 @@ map<string,TGraph*> ProfileMultiplePdfs::profileLikelihoodEnvelope(RooAbsData *d
   map<string,TGraph*> minNlls;
   TGraph *globalNLL = new TGraph();
   globalMinNLL=1.e6;
+  vector<map<string,double> > startValues(listOfPdfs.size());
   // first find global minNll for reference point
   for (map<string,pair<RooAbsPdf*,float> >::iterator m=listOfPdfs.begin(); m!=listOfPdfs.end(); m++) { 
     RooAbsPdf *pdf = m->second.first;
     float penalty = m->second.second;
     RooFitResult *nom = pdf->fitTo(*data,PrintLevel(-1),PrintEvalErrors(-1),Warnings(false),Save(true));
+    RooArgSet *params = pdf->getParameters(*var);
+    saveValues(startValues[distance(listOfPdfs.begin(),m)],params);
+    delete params;
     if (2*nom->minNll()+penalty<globalMinNLL){
       globalMinNLL = 2*nom->minNll()+penalty;
       bestFitVal = var->getVal();
@@ -266,24 +421,17 @@ map<string,TGraph*> ProfileMultiplePdfs::profileLikelihoodEnvelope(RooAbsData *d
   cout << "\tnll = " << globalMinNLL << endl;
   cout << "\tmu  = " << bestFitVal << endl;
   cout << "\tpdf = " << bestFitPdf->GetName() << endl;
-  // now perform the scan
+  // now perform the scan, every pdf starting from its own nominal fit
+  vector<float> points = scanPoints(low,high,stepsize,false);
+  vector<vector<double> > twiceMinNlls = runScan(data,var,startValues,points);
   for (map<string,pair<RooAbsPdf*,float> >::iterator m=listOfPdfs.begin(); m!=listOfPdfs.end(); m++) { 
     RooAbsPdf *pdf = m->second.first;
     float penalty = m->second.second;
+    int i = distance(listOfPdfs.begin(),m);
     TGraph *thisNLL = new TGraph();
-    int p=0;
-    for (float v=low; v<high; v+=stepsize){
-      var->setConstant(false);
-      var->setVal(v);
-      var->setConstant(true);
-      RooFitResult *scan = pdf->fitTo(*data,PrintLevel(-1),PrintEvalErrors(-1),Warnings(false),Save(true));
-      //RooFitResult *scan = pdf->fitTo(*data,Save(true));
-      thisNLL->SetPoint(p,v,(2*scan->minNll()-globalMinNLL+penalty));
-      addToResultMap(v,2*scan->minNll()-globalMinNLL+penalty,pdf);
-      //thisNLL->SetPoint(p,v,(scan->minNll()+penalty));
-      //addToResultMap(v,scan->minNll()+penalty,pdf);
-      p++;
-      delete scan;
+    for (unsigned int p=0; p<points.size(); p++){
+      thisNLL->SetPoint(p,points[p],(twiceMinNlls[i][p]-globalMinNLL+penalty));
+      addToResultMap(points[p],twiceMinNlls[i][p]-globalMinNLL+penalty,pdf);
     }
     thisNLL->SetName(Form("minnll_%s_%s",pdf->GetName(),data->GetName()));
     minNlls.insert(pair<string,TGraph*>(thisNLL->GetName(),thisNLL));
@@ -118,6 +118,8 @@ int main(int argc, char* argv[]){
   int expectSignalMass;
   bool skipPlots=false;
   int verbosity;
+  int nWorkers;
+  int scanPieceSize;
   bool throwHybridToys=false;
   vector<float> switchMass;
   vector<string> switchFunc;
@@ -143,6 +145,8 @@ int main(int argc, char* argv[]){
     ("expectSignalMass", po::value<int>(&expectSignalMass)->default_value(125),                 "Inject signal at this mass")
     ("skipPlots",                                                                               "Skip full profile and toy plots")                        
     ("verbosity,v", po::value<int>(&verbosity)->default_value(0),                               "Verbosity level")
+    ("nWorkers", po::value<int>(&nWorkers)->default_value(1),                                   "Number of processes sharing the likelihood scan fits")
+    ("scanPieceSize", po::value<int>(&scanPieceSize)->default_value(50),                        "Number of scan points fitted in a row from the nominal fit")
   ;    
   
   po::variables_map vm;
@@ -318,6 +322,8 @@ int main(int argc, char* argv[]){
   for (map<string,RooAbsPdf*>::iterator pdf=fabianSBPdfs.begin(); pdf!=fabianSBPdfs.end(); pdf++){
     fabianProfiler.addPdf(pdf->second);
   }
+  fabianProfiler.setNWorkers(nWorkers);
+  fabianProfiler.setScanPieceSize(scanPieceSize);
   cout << "Fabian profiler pdfs:" << endl;
   fabianProfiler.printPdfs();
 
@@ -326,6 +332,8 @@ int main(int argc, char* argv[]){
   for (map<string,RooAbsPdf*>::iterator pdf=paulSBPdfs.begin(); pdf!=paulSBPdfs.end(); pdf++){
     paulProfiler.addPdf(pdf->second);
   }
+  paulProfiler.setNWorkers(nWorkers);
+  paulProfiler.setScanPieceSize(scanPieceSize);
   cout << "Paul profiler pdfs:" << endl;
   paulProfiler.printPdfs();
 
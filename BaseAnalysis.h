@@ -54,6 +54,15 @@ public:
 	
 	// ! Implemement your final analysis here
 	virtual bool Analysis(LoopAll&, Int_t) = 0;
+
+	// ! Copy of the configured (not yet initialized) analysis, used by LoopAll worker threads. 
+	// ! Return 0 if the analysis cannot be run in multiple threads.
+	virtual BaseAnalysis * Clone() const { return 0; };
+	// ! Add the internal state accumulated by a worker clone. Called before Term.
+	virtual void MergeClone(BaseAnalysis &) {};
+	// ! Append what a worker clone wrote to text files. Called after each input file, in worker order,
+	// ! so that the events are listed in the same order as in a single-threaded job.
+	virtual void MergeCloneOutput(BaseAnalysis &) {};
 	
 };
 
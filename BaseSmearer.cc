@@ -33,5 +33,15 @@ BaseGenLevelSmearer::BaseGenLevelSmearer()
 BaseGenLevelSmearer::~BaseGenLevelSmearer() 
 {}
 
+bool BaseGenLevelSmearer::smearEventShifts( const TLorentzVector & p4, const int nPu, const int sample_type, 
+					    int nshifts, const float * syst_shifts, float * weights ) const
+{
+	bool ret = true;
+	for(int ishift=0; ishift<nshifts; ++ishift) {
+		ret = smearEvent(weights[ishift], p4, nPu, sample_type, syst_shifts[ishift]) && ret;
+	}
+	return ret;
+}
+
 bool operator == (BaseGenLevelSmearer * a, const std::string & b) { return a->name() == b; };
 
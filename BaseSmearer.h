@@ -32,6 +32,14 @@ public:
 	// ! return smeared photon informations
 	virtual bool smearPhoton( PhotonReducedInfo & pho, float & weight, int run, float syst_shift=0. ) const = 0;
 
+	// ! smear the photon for several values of syst_shift at once, filling the resulting energies and weights.
+	// ! returns false if the smearer cannot do it, in which case smearPhoton has to be called for every shift
+	virtual bool smearPhotonShifts( PhotonReducedInfo & pho, int run, int nshifts, const float * syst_shifts, 
+					float * energies, float * weights ) const { return false; };
+
+	// ! true if smearPhoton modifies other smearers, i.e. if the smearer cannot be skipped when re-running a chain of smearers
+	virtual bool hasSideEffects() const { return false; };
+
 	int  smearerId()    const  { return smearerId_; };
 	bool amRegistered() const  { return smearerId_ > -1; };
 
@@ -67,6 +75,12 @@ public:
 	
 	virtual bool smearDiPhoton( TLorentzVector & p4, TVector3 & selVtx, float & weight, const int & category, 
 				    const int & genMassPoint, const TVector3 & trueVtx, float & idMVA1, float & idMVA2, float syst_shift=0.) const = 0 ;
+
+	// ! evaluate the smearing for several values of syst_shift at once. p4 and selVtx are not modified.
+	// ! returns false if the smearer cannot do it, in which case smearDiPhoton has to be called for every shift
+	virtual bool smearDiPhotonShifts( const TLorentzVector & p4, const TVector3 & selVtx, const int & category, const int & genMassPoint, 
+					  const TVector3 & trueVtx, int nshifts, const float * syst_shifts, 
+					  float * weights, float * idMVA1, float * idMVA2 ) const { return false; };
 };
 
 // ! Used to search analyzers by name 
@@ -89,6 +103,10 @@ public:
 	operator const std::string & () const { return this->name(); };
 	
 	virtual bool smearEvent(  float & weight, const TLorentzVector & p4, const int nPu, const int sample_type, float syst_shift=0.) const = 0 ;
+
+	// ! evaluate the weights for several values of syst_shift at once
+	virtual bool smearEventShifts( const TLorentzVector & p4, const int nPu, const int sample_type, 
+				       int nshifts, const float * syst_shifts, float * weights ) const;
 };
 
 // ! Used to search analyzers by name 
@@ -48,6 +48,15 @@ void CounterContainer::Fill(std::string name, int category, float weight) {
     std::cout << "Wrong counter name: " <<name<< std::endl;
 }
 
+void CounterContainer::Merge(const CounterContainer & other) {
+  assert( other.c.size() == c.size() );
+  for (unsigned int i=0; i<c.size(); i++) {
+    for (unsigned int cat=0; cat<c[i].size(); cat++) {
+      c[i][cat] += other.c[i][cat];
+    }
+  }
+}
+
 unsigned int CounterContainer::ncat(unsigned int length) {
   return c[length].size();
 }
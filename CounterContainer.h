@@ -17,6 +17,7 @@ class CounterContainer {
   void Fill(std::string, int);
   void Fill(std::string, int, float);
   void Save();
+  void Merge(const CounterContainer &);
   unsigned int size() { return c.size(); }
   unsigned int ncat(unsigned int);
   std::string name(unsigned int);
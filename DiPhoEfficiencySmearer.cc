@@ -56,7 +56,46 @@ bool DiPhoEfficiencySmearer::smearDiPhoton( TLorentzVector & p4, TVector3 & selV
   return true;
 }
 
+bool DiPhoEfficiencySmearer::smearDiPhotonShifts( const TLorentzVector & p4, const TVector3 & selVtx, const int & category, 
+						  const int & genMassPoint, const TVector3 & trueVtx, int nshifts, const float * syst_shifts, 
+						  float * weights, float * idMVA1, float * idMVA2 ) const
+{
+  if (doMvaIdEff_){
+    
+      float frac_idvary = 0.025;
+      for(int ishift=0; ishift<nshifts; ++ishift) {
+	idMVA1[ishift] += syst_shifts[ishift]*frac_idvary; 
+	idMVA2[ishift] += syst_shifts[ishift]*frac_idvary;
+      }
+      return true;
+  }
 
+  // category and interpolation point do not depend on the shift
+  std::string cat=Form("cat%d", category);
+  float sign = 1.;
+  assert( ! smearing_eff_graph_.empty() );
+  if( doVtxEff_ ) {
+    if( (selVtx - trueVtx).Mag() < 1. ) {
+      cat += "_pass"; 
+    }
+    else {
+      cat += "_fail";
+      sign = -1.;
+    }
+  }
+
+  double theWeight, theErrorUp, theErrorDown;
+  // let smearDiPhoton complain about unknown categories
+  if( ! interpolate( p4.Pt(), cat, theWeight, theErrorUp, theErrorDown ) ) { return false; }
+  for(int ishift=0; ishift<nshifts; ++ishift) {
+    float syst_shift = sign*syst_shifts[ishift];
+    double theError = ( syst_shift>0 ? theErrorUp : theErrorDown );
+    float ret = theWeight + theError*syst_shift; 
+    weights[ishift] = ret<0 ? 0 : ret;
+  }
+  
+  return true;
+}
 
 bool DiPhoEfficiencySmearer::init() 
 {
@@ -103,56 +142,9 @@ bool DiPhoEfficiencySmearer::init()
 
 double DiPhoEfficiencySmearer::getWeight(double pt, std::string theCategory, float syst_shift) const
 {
-    static int nwarnings = 10;
-  std::map<std::string,TGraphAsymmErrors*>::const_iterator theIter = smearing_eff_graph_.find(theCategory);
-  if( theIter != smearing_eff_graph_.end()  ) {
-
-    // determine the pair of bins between which  you interpolate
-    int numPoints = ( theIter->second )->GetN();
-    double x, y, xPrevious;
-    int myBin = -1;
-    xPrevious =-1e9;
-    for (int bin=0; bin<numPoints; bin++ ){
-      ( theIter->second )->GetPoint(bin, x, y);
-      assert( xPrevious < x ) ;     // points in TGraphAsymmErrors must be in increasing order
-      xPrevious=x;
-      if(pt > x) {
-	myBin = bin; }
-      else break;
-    }
-    int binLow, binHigh; bool atBoundary(false);
-    if      (myBin == -1)               {binHigh = 0; binLow=0; atBoundary=true;}
-    else if (myBin == (numPoints-1))    {binHigh = numPoints-1; binLow=numPoints-1; atBoundary=true;}
-    else                                {binLow=myBin; binHigh=myBin+1;}
-
-    // get hold of efficiency ratio and error at either points
-    // low-high refer to the points ; up-down refers to the errors 
-    double xLow, yLow;    double xHigh, yHigh;
-    ( theIter->second )->GetPoint(binLow, xLow, yLow);
-    ( theIter->second )->GetPoint(binHigh, xHigh, yHigh);
-
-    double errLowYup    = ( theIter->second )->GetErrorYhigh(binLow);
-    double errLowYdown  = ( theIter->second )->GetErrorYlow(binLow);
-    double errHighYup   = ( theIter->second )->GetErrorYhigh(binHigh);
-    double errHighYdown = ( theIter->second )->GetErrorYlow(binHigh);
-
-    double theErrorLow, theErrorHigh;
-    if(syst_shift>0) {theErrorLow = errLowYup;   theErrorHigh = errHighYup;}
-    else             {theErrorLow = errLowYdown; theErrorHigh = errHighYdown;}
-    
-    double theWeight, theError;
-    //           if you're NOT at the boundaris of TGraphAsymmErrors, linearly interpolate values and errors
-    if(!atBoundary) {
-      theWeight = yLow + (yHigh-yLow) / (xHigh-xLow) * (pt-xLow);
-      theError  = theErrorLow + (theErrorHigh-theErrorLow) / (xHigh-xLow) * (pt-xLow); 
-    } else { 
-	//  if instead you ARE at the boundaris of TGraphAsymmErrors, collapse on first or last of its points  
-	if(myBin == (numPoints-1)) {
-	  theWeight = yHigh; 	  theError  = theErrorHigh;	}
-	else if (myBin == -1) 	  {
-	  theWeight = yLow; 	  theError  = theErrorLow;  	}
-	else  {   std::cout <<  effName_ << " ** you claim to be at boundaries of TGraphAsymmErrors but your not! This is a problem " << std::endl;}
-    }
+  double theWeight, theErrorUp, theErrorDown;
+  if( interpolate(pt, theCategory, theWeight, theErrorUp, theErrorDown) ) {
+    double theError = ( syst_shift>0 ? theErrorUp : theErrorDown );
     float ret = theWeight + theError*syst_shift; 
     return ret;
   }
@@ -162,3 +154,53 @@ double DiPhoEfficiencySmearer::getWeight(double pt, std::string theCategory, flo
   }
   
 }
+
+bool DiPhoEfficiencySmearer::interpolate(double pt, const std::string & theCategory, double & theWeight, double & theErrorUp, double & theErrorDown) const
+{
+  std::map<std::string,TGraphAsymmErrors*>::const_iterator theIter = smearing_eff_graph_.find(theCategory);
+  if( theIter == smearing_eff_graph_.end()  ) { return false; }
+
+  // determine the pair of bins between which  you interpolate
+  int numPoints = ( theIter->second )->GetN();
+  double x, y, xPrevious;
+  int myBin = -1;
+  xPrevious =-1e9;
+  for (int bin=0; bin<numPoints; bin++ ){
+    ( theIter->second )->GetPoint(bin, x, y);
+    assert( xPrevious < x ) ;     // points in TGraphAsymmErrors must be in increasing order
+    xPrevious=x;
+    if(pt > x) {
+      myBin = bin; }
+    else break;
+  }
+  int binLow, binHigh; bool atBoundary(false);
+  if      (myBin == -1)               {binHigh = 0; binLow=0; atBoundary=true;}
+  else if (myBin == (numPoints-1))    {binHigh = numPoints-1; binLow=numPoints-1; atBoundary=true;}
+  else                                {binLow=myBin; binHigh=myBin+1;}
+
+  // get hold of efficiency ratio and error at either points
+  // low-high refer to the points ; up-down refers to the errors 
+  double xLow, yLow;    double xHigh, yHigh;
+  ( theIter->second )->GetPoint(binLow, xLow, yLow);
+  ( theIter->second )->GetPoint(binHigh, xHigh, yHigh);
+
+  double errLowYup    = ( theIter->second )->GetErrorYhigh(binLow);
+  double errLowYdown  = ( theIter->second )->GetErrorYlow(binLow);
+  double errHighYup   = ( theIter->second )->GetErrorYhigh(binHigh);
+  double errHighYdown = ( theIter->second )->GetErrorYlow(binHigh);
+
+  //           if you're NOT at the boundaris of TGraphAsymmErrors, linearly interpolate values and errors
+  if(!atBoundary) {
+    theWeight    = yLow + (yHigh-yLow) / (xHigh-xLow) * (pt-xLow);
+    theErrorUp   = errLowYup   + (errHighYup-errLowYup)     / (xHigh-xLow) * (pt-xLow); 
+    theErrorDown = errLowYdown + (errHighYdown-errLowYdown) / (xHigh-xLow) * (pt-xLow); 
+  } else { 
+      //  if instead you ARE at the boundaris of TGraphAsymmErrors, collapse on first or last of its points  
+      if(myBin == (numPoints-1)) {
+	theWeight = yHigh;     theErrorUp = errHighYup;   theErrorDown = errHighYdown; }
+      else if (myBin == -1)      {
+	theWeight = yLow;      theErrorUp = errLowYup;    theErrorDown = errLowYdown;  }
+      else  {   std::cout <<  effName_ << " ** you claim to be at boundaries of TGraphAsymmErrors but your not! This is a problem " << std::endl;}
+  }
+  return true;
+}
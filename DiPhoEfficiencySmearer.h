@@ -45,6 +45,9 @@ public:
   
   virtual bool smearDiPhoton( TLorentzVector & p4, TVector3 & selVtx, float & weight, const int & category, const int & genMassPoint, 
 			      const TVector3 & trueVtx, float & idMVA1,float & idMVA2 ,float syst_shift) const ;
+  virtual bool smearDiPhotonShifts( const TLorentzVector & p4, const TVector3 & selVtx, const int & category, const int & genMassPoint, 
+				    const TVector3 & trueVtx, int nshifts, const float * syst_shifts, 
+				    float * weights, float * idMVA1, float * idMVA2 ) const;
 
   void name(const std::string & x) { name_ = x; };
 
@@ -60,6 +63,8 @@ public:
  protected:
 
   double getWeight(double pt, std::string theCategory, float syst_shift) const;
+  // efficiency ratio and its up/down errors interpolated at pt; false if the category is unknown
+  bool interpolate(double pt, const std::string & theCategory, double & theWeight, double & theErrorUp, double & theErrorDown) const;
 
   bool passFailWeights_, doVtxEff_, doMvaIdEff_;
   
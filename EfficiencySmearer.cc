@@ -88,7 +88,33 @@ bool EfficiencySmearer::smearPhoton(PhotonReducedInfo & aPho, float & weight, in
   return true;
 }
 
+bool EfficiencySmearer::smearPhotonShifts(PhotonReducedInfo & aPho, int run, int nshifts, const float * syst_shifts, 
+					  float * energies, float * weights) const
+{
+  std::string category=photonCategory(aPho);
+  // let smearPhoton complain about unknown categories
+  if (category == "") { return false; }
+
+  for(int ishift=0; ishift<nshifts; ++ishift) { energies[ishift] = aPho.energy(); }
+
+  assert( !smearing_eff_graph_.empty() );
+  if( doPhoId_ && ! aPho.passId() && ! doR9_ ) { return true; }
 
+  // the category and the interpolation along the efficiency graph are the same for all shifts
+  double theWeight, theErrorUp, theErrorDown;
+  if( ! interpolate( ( aPho.energy() / cosh(aPho.caloPosition().PseudoRapidity()) ), category, theWeight, theErrorUp, theErrorDown ) ) {
+    return false;
+  }
+  // same correlation between R9 and !R9 as in smearPhoton
+  float sign = ( doR9_ && ! (aPho.r9()>0.94) ) ? -1. : 1.;
+  for(int ishift=0; ishift<nshifts; ++ishift) {
+    float syst_shift = sign*syst_shifts[ishift];
+    double theError = ( syst_shift>0 ? theErrorUp : theErrorDown );
+    weights[ishift] = ( theWeight + (theError*syst_shift));
+  }
+  
+  return true;
+}
 
 bool EfficiencySmearer::init() 
 {
@@ -166,60 +192,60 @@ bool EfficiencySmearer::init()
 
 double EfficiencySmearer::getWeight(double pt, std::string theCategory, float syst_shift) const
 {
-  std::map<std::string,TGraphAsymmErrors*>::const_iterator theIter = smearing_eff_graph_.find(theCategory);
-  if( theIter != smearing_eff_graph_.end()  ) {
-
-    // determine the pair of bins between which  you interpolate
-    int numPoints = ( theIter->second )->GetN();
-    double x, y;
-    int myBin = -1;
-    double xPrevious = -1e9;
-    for (int bin=0; bin<numPoints; bin++ ){
-      ( theIter->second )->GetPoint(bin, x, y);
-      assert( xPrevious < x );
-      if(pt > x) {
-	myBin = bin; }
-      else break;
-    }
-    int binLow, binHigh;  bool atBoundary(false);
-    if      (myBin == -1)              {binHigh = 0; binLow=0; atBoundary=true;}
-    else if (myBin == (numPoints-1))   {binHigh = numPoints-1; binLow=numPoints-1; atBoundary=true;}
-    else                               {binLow=myBin; binHigh=myBin+1;}
-//    if(myBin == -1)                      {binHigh = 0; binLow=0;}
-//    else if (myBin == (numPoints-1))     {binHigh = numPoints-1; binLow=numPoints-1;}
-//    else {binLow=myBin; binHigh=myBin+1;}
-
-
-    // get hold of efficiency ratio and error at either points
-    // low-high refer to the points ; up-down refers to the errors 
-    double xLow, yLow;    double xHigh, yHigh;
-    ( theIter->second )->GetPoint(binLow, xLow, yLow);
-    ( theIter->second )->GetPoint(binHigh, xHigh, yHigh);
-
-    double errLowYup    = ( theIter->second )->GetErrorYhigh(binLow);
-    double errLowYdown  = ( theIter->second )->GetErrorYlow(binLow);
-    double errHighYup   = ( theIter->second )->GetErrorYhigh(binHigh);
-    double errHighYdown = ( theIter->second )->GetErrorYlow(binHigh);
-
-    double theErrorLow, theErrorHigh;
-    if(syst_shift>0) {theErrorLow = errLowYup;   theErrorHigh = errHighYup;}
-    else             {theErrorLow = errLowYdown; theErrorHigh = errHighYdown;}
-    
-    double theWeight, theError;
-    if(!atBoundary) {
-      theWeight = yLow + (yHigh-yLow) / (xHigh-xLow) * (pt-xLow);
-      theError  = theErrorLow + (theErrorHigh-theErrorLow) / (xHigh-xLow) * (pt-xLow);}
-    else     // if instead you ARE at the boundaris of TGraphAsymmErrors, collapse on first or last of its points  
-      { 
-	if(myBin == (numPoints-1)) {
-	  theWeight = yHigh; 	  theError  = theErrorHigh;	}
-	else if (myBin == -1) 	  {
-	  theWeight = yLow; 	  theError  = theErrorLow; 	}
-	else  {   std::cout <<  effName_ << " ** you claim to be at boundaries of TGraphAsymmErrors but your not! This is a problem " << std::endl;}
-      }     
+  double theWeight, theErrorUp, theErrorDown;
+  if( interpolate(pt, theCategory, theWeight, theErrorUp, theErrorDown) ) {
+    double theError = ( syst_shift>0 ? theErrorUp : theErrorDown );
     return  ( theWeight + (theError*syst_shift));
   }
   else {     std::cout << effName_ << " - category asked: " << theCategory << " was not found - which is a problem. Returning weight 1. " << std::endl;
     return 1.;   }
   
 }
+
+bool EfficiencySmearer::interpolate(double pt, const std::string & theCategory, double & theWeight, double & theErrorUp, double & theErrorDown) const
+{
+  std::map<std::string,TGraphAsymmErrors*>::const_iterator theIter = smearing_eff_graph_.find(theCategory);
+  if( theIter == smearing_eff_graph_.end()  ) { return false; }
+
+  // determine the pair of bins between which  you interpolate
+  int numPoints = ( theIter->second )->GetN();
+  double x, y;
+  int myBin = -1;
+  double xPrevious = -1e9;
+  for (int bin=0; bin<numPoints; bin++ ){
+    ( theIter->second )->GetPoint(bin, x, y);
+    assert( xPrevious < x );
+    if(pt > x) {
+      myBin = bin; }
+    else break;
+  }
+  int binLow, binHigh;  bool atBoundary(false);
+  if      (myBin == -1)              {binHigh = 0; binLow=0; atBoundary=true;}
+  else if (myBin == (numPoints-1))   {binHigh = numPoints-1; binLow=numPoints-1; atBoundary=true;}
+  else                               {binLow=myBin; binHigh=myBin+1;}
+
+  // get hold of efficiency ratio and error at either points
+  // low-high refer to the points ; up-down refers to the errors 
+  double xLow, yLow;    double xHigh, yHigh;
+  ( theIter->second )->GetPoint(binLow, xLow, yLow);
+  ( theIter->second )->GetPoint(binHigh, xHigh, yHigh);
+
+  double errLowYup    = ( theIter->second )->GetErrorYhigh(binLow);
+  double errLowYdown  = ( theIter->second )->GetErrorYlow(binLow);
+  double errHighYup   = ( theIter->second )->GetErrorYhigh(binHigh);
+  double errHighYdown = ( theIter->second )->GetErrorYlow(binHigh);
+
+  if(!atBoundary) {
+    theWeight    = yLow + (yHigh-yLow) / (xHigh-xLow) * (pt-xLow);
+    theErrorUp   = errLowYup   + (errHighYup-errLowYup)     / (xHigh-xLow) * (pt-xLow);
+    theErrorDown = errLowYdown + (errHighYdown-errLowYdown) / (xHigh-xLow) * (pt-xLow);}
+  else     // if instead you ARE at the boundaris of TGraphAsymmErrors, collapse on first or last of its points  
+    { 
+      if(myBin == (numPoints-1)) {
+	theWeight = yHigh;     theErrorUp = errHighYup;   theErrorDown = errHighYdown; }
+      else if (myBin == -1)      {
+	theWeight = yLow;      theErrorUp = errLowYup;    theErrorDown = errLowYdown;  }
+      else  {   std::cout <<  effName_ << " ** you claim to be at boundaries of TGraphAsymmErrors but your not! This is a problem " << std::endl;}
+    }     
+  return true;
+}
@@ -34,6 +34,8 @@ public:
   virtual const std::string & name() const { return name_; };
   
   virtual bool smearPhoton( PhotonReducedInfo & pho, float & weight, int run, float syst_shift=0. ) const;
+  virtual bool smearPhotonShifts( PhotonReducedInfo & pho, int run, int nshifts, const float * syst_shifts, 
+				  float * energies, float * weights ) const;
   
   void name(const std::string & x) { name_ = x; };
 
@@ -49,6 +51,8 @@ public:
   std::string photonCategory(PhotonReducedInfo &) const;
 
   double getWeight(double pt, std::string theCategory, float syst_shift) const;
+  // efficiency ratio and its up/down errors interpolated at pt; false if the category is unknown
+  bool interpolate(double pt, const std::string & theCategory, double & theWeight, double & theErrorUp, double & theErrorDown) const;
   
   std::string   name_;
   TRandom3     *rgen_;
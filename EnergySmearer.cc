@@ -36,6 +36,7 @@ EnergySmearer::EnergySmearer(const energySmearingParameters& par, const std::vec
     assert( myParameters_.n_categories == myParameters_.scale_offset.size() );
     assert( myParameters_.n_categories == myParameters_.scale_offset_error.size() );
   }
+  compileParameters();
   
   registerMe();
 }
@@ -54,65 +55,103 @@ EnergySmearer::~EnergySmearer()
   delete rgen_;
 }
 
-std::string EnergySmearer::photonCategory(const energySmearingParameters & myParameters, const PhotonReducedInfo & aPho)
+namespace {
+	const char * twoCatR9EBEENames[] = { "EBHighR9", "EBLowR9", "EEHighR9", "EELowR9" };
+	const char * twoCatR9EBEBm4EENames[] = { "EBHighR9", "EBLowR9", "EBm4HighR9", "EBm4LowR9", "EEHighR9", "EELowR9" };
+	const char * EBEENames[] = { "EB", "EE" };
+}
+
+int EnergySmearer::categoryTypeId(const std::string & categoryType)
+{
+  if (categoryType=="Automagic")       { return automagicCategories; }
+  if (categoryType=="2CatR9_EBEE")     { return twoCatR9EBEECategories; }
+  if (categoryType=="2CatR9_EBEBm4EE") { return twoCatR9EBEBm4EECategories; }
+  if (categoryType=="EBEE")            { return EBEECategories; }
+  return unknownCategories;
+}
+
+std::vector<std::string> EnergySmearer::categoryNames(const energySmearingParameters & myParameters)
 {
-  std::string myCategory="";
-  if (myParameters.categoryType=="Automagic") 
+  std::vector<std::string> names;
+  switch( categoryTypeId(myParameters.categoryType) ) {
+  case automagicCategories:
+    for(energySmearingParameters::phoCatVectorConstIt it=myParameters.photon_categories.begin(); it!=myParameters.photon_categories.end(); ++it) {
+      names.push_back(it->name);
+    }
+    break;
+  case twoCatR9EBEECategories:
+    names.assign(twoCatR9EBEENames, twoCatR9EBEENames+4);
+    break;
+  case twoCatR9EBEBm4EECategories:
+    names.assign(twoCatR9EBEBm4EENames, twoCatR9EBEBm4EENames+6);
+    break;
+  case EBEECategories:
+    names.assign(EBEENames, EBEENames+2);
+    break;
+  }
+  return names;
+}
+
+int EnergySmearer::photonCategoryIndex(int categoryType, const energySmearingParameters::phoCatVector & categories, 
+				       const PhotonReducedInfo & aPho)
+{
+  int icat = -1;
+  if (categoryType==automagicCategories) 
     {
 	    EnergySmearer::energySmearingParameters::phoCatVectorConstIt vit = 
-		find(myParameters.photon_categories.begin(), 
-		     myParameters.photon_categories.end(),
+		find(categories.begin(), 
+		     categories.end(),
 		     PhotonCategory::photon_coord_t(
 			     aPho.energy()/cosh(fabs((float)aPho.caloPosition().PseudoRapidity())),
 			     fabs((float)aPho.caloPosition().PseudoRapidity()),(float)aPho.r9(),
 			     aPho.isSphericalPhoton())
 			);
-	    if( vit ==  myParameters.photon_categories.end() ) {
+	    if( vit ==  categories.end() ) {
 		    std::cerr << "Could not find energy categoty for this photon " << 
 		      aPho.isSphericalPhoton() << " " << (float)aPho.caloPosition().PseudoRapidity() << " " <<  (float)aPho.r9() << std::endl;
 		    assert( 0 );
 	    }
-	    myCategory = vit->name;
+	    icat = vit - categories.begin();
     } 
-  else if (myParameters.categoryType=="2CatR9_EBEE")
+  else if (categoryType==twoCatR9EBEECategories)
     {
-      if (aPho.iDet()==1)
-	myCategory+="EB";
-      else
-	myCategory+="EE";
-      
-      if (aPho.r9()>=0.94)
-	myCategory+="HighR9";
-      else
-	myCategory+="LowR9";
+      icat = ( aPho.iDet()==1 ? 0 : 2 ) + ( aPho.r9()>=0.94 ? 0 : 1 );
     }
-  else if (myParameters.categoryType=="2CatR9_EBEBm4EE")
+  else if (categoryType==twoCatR9EBEBm4EECategories)
     {
       if (aPho.iDet()==1 && fabs(aPho.caloPosition().PseudoRapidity())      < 1.)
-	myCategory+="EB";
+	icat = 0;
       else if (aPho.iDet()==1 && fabs(aPho.caloPosition().PseudoRapidity()) > 1.)
-	myCategory+="EBm4";
+	icat = 2;
       else
-	myCategory+="EE";
+	icat = 4;
       
-      if (aPho.r9()>=0.94)
-	myCategory+="HighR9";
-      else
-	myCategory+="LowR9";
+      icat += ( aPho.r9()>=0.94 ? 0 : 1 );
     }
-  else if (myParameters.categoryType=="EBEE")
+  else if (categoryType==EBEECategories)
     {
-      if (aPho.iDet()==1)
-	myCategory+="EB";
-      else
-	myCategory+="EE";
+      icat = ( aPho.iDet()==1 ? 0 : 1 );
     }
   else
     {
       std::cout << "Unknown categorization. No category name is returned" << std::endl;
     }
   
-  return myCategory;
+  return icat;
+}
+
+std::string EnergySmearer::photonCategory(const energySmearingParameters & myParameters, const PhotonReducedInfo & aPho)
+{
+  int categoryType = categoryTypeId(myParameters.categoryType);
+  int icat = photonCategoryIndex(categoryType, myParameters.photon_categories, aPho);
+  if( icat < 0 ) { return ""; }
+  switch( categoryType ) {
+  case automagicCategories:        return myParameters.photon_categories[icat].name;
+  case twoCatR9EBEECategories:     return twoCatR9EBEENames[icat];
+  case twoCatR9EBEBm4EECategories: return twoCatR9EBEBm4EENames[icat];
+  case EBEECategories:             return EBEENames[icat];
+  }
+  return "";
 }
 
 float EnergySmearer::getSmearingSigma(const energySmearingParameters & myParameters, const std::string & category, 
@@ -124,15 +163,30 @@ float EnergySmearer::getSmearingSigma(const energySmearingParameters & myParamet
   float err_sigma= myParameters.smearing_sigma_error.find(category)->second;
   energySmearingParameters::parameterMapConstIt ipivot = myParameters.smearing_stocastic_pivot.find(category);
   
-  if( myParameters.etStocastic ) {
+  return combineSmearingSigma(smearing_sigma, err_sigma, smearing_stocastic_sigma, smearing_stocastic_sigma_error,
+			      ( ipivot != myParameters.smearing_stocastic_pivot.end() ? &ipivot->second : 0 ),
+			      myParameters.etStocastic, energy, eta, syst_shift);
+}
+
+float EnergySmearer::getSmearingSigma(int icat, float energy, float eta, float syst_shift) const
+{
+  return combineSmearingSigma(smearingSigma_[icat], smearingSigmaError_[icat], smearingStocasticSigma_[icat], smearingStocasticSigmaError_[icat],
+			      ( hasStocasticPivot_[icat] ? &smearingStocasticPivot_[icat] : 0 ),
+			      myParameters_.etStocastic, energy, eta, syst_shift);
+}
+
+float EnergySmearer::combineSmearingSigma(float smearing_sigma, float err_sigma, float smearing_stocastic_sigma, float smearing_stocastic_sigma_error, 
+					  const float * pivot, bool etStocastic, float energy, float eta, float syst_shift)
+{
+  if( etStocastic ) {
 	  energy /= cosh(eta);
   }
   smearing_sigma           += syst_shift * err_sigma;
   smearing_stocastic_sigma += syst_shift * smearing_stocastic_sigma_error;
-  if( ipivot != myParameters.smearing_stocastic_pivot.end() ) {
+  if( pivot != 0 ) {
 	  float phi = std::max((float)0.,std::min((float)(TMath::Pi()*0.5),smearing_stocastic_sigma));
 	  float rho = smearing_sigma;
-	  smearing_stocastic_sigma = rho*sqrt(ipivot->second)*sin(phi);
+	  smearing_stocastic_sigma = rho*sqrt(*pivot)*sin(phi);
 	  smearing_sigma = rho * cos(phi);
   }
   smearing_stocastic_sigma = (smearing_stocastic_sigma * smearing_stocastic_sigma) / energy;
@@ -146,26 +200,80 @@ float EnergySmearer::getSmearingSigma(const energySmearingParameters & myParamet
 
 std::string EnergySmearer::photonCategory(PhotonReducedInfo & aPho) const
 {
-  return photonCategory(myParameters_,aPho);
+  int icat = photonCategoryIndex(aPho);
+  return ( icat < 0 ? "" : categoryNames_[icat] );
+}
+
+int EnergySmearer::photonCategoryIndex(const PhotonReducedInfo & aPho) const
+{
+  return photonCategoryIndex(categoryType_, myParameters_.photon_categories, aPho);
 }
 
+void EnergySmearer::compileParameter(const std::map<std::string,float> & par, std::vector<float> & values, std::vector<char> * found) const
+{
+  values.assign(ncat_,0.);
+  if( found ) { found->assign(ncat_,0); }
+  for(int icat=0; icat<ncat_; ++icat) {
+    energySmearingParameters::parameterMapConstIt it=par.find(categoryNames_[icat]);
+    if( it == par.end() ) { continue; }
+    values[icat] = it->second;
+    if( found ) { (*found)[icat] = 1; }
+  }
+}
 
-float EnergySmearer::getScaleOffset(int run, const std::string & category) const
+void EnergySmearer::compileParameters()
 {
-  const std::map<std::string, float> * scale_offset =  &(myParameters_.scale_offset);
+  categoryType_  = categoryTypeId(myParameters_.categoryType);
+  categoryNames_ = categoryNames(myParameters_);
+  ncat_ = categoryNames_.size();
+
+  std::vector<const std::map<std::string, float> *> scale_offsets;
+  firstRun_.clear(), lastRun_.clear();
+  if( myParameters_.byRun ) {
+    for(energySmearingParameters::eScaleVectorConstIt it=myParameters_.scale_offset_byrun.begin(); it!=myParameters_.scale_offset_byrun.end();
+	++it ) {
+	    firstRun_.push_back(it->firstrun), lastRun_.push_back(it->lastrun);
+	    scale_offsets.push_back(&(it->scale_offset));
+    }
+  } else {
+    scale_offsets.push_back(&(myParameters_.scale_offset));
+  }
+  scaleOffset_.clear(), hasScaleOffset_.clear();
+  for(size_t irange=0; irange<scale_offsets.size(); ++irange) {
+    std::vector<float> values;
+    std::vector<char> found;
+    compileParameter(*scale_offsets[irange], values, &found);
+    scaleOffset_.insert(scaleOffset_.end(), values.begin(), values.end());
+    hasScaleOffset_.insert(hasScaleOffset_.end(), found.begin(), found.end());
+  }
   
+  compileParameter(myParameters_.scale_offset_error, scaleOffsetError_);
+  compileParameter(myParameters_.smearing_sigma, smearingSigma_);
+  compileParameter(myParameters_.smearing_sigma_error, smearingSigmaError_);
+  compileParameter(myParameters_.smearing_stocastic_sigma, smearingStocasticSigma_);
+  compileParameter(myParameters_.smearing_stocastic_sigma_error, smearingStocasticSigmaError_);
+  compileParameter(myParameters_.smearing_stocastic_pivot, smearingStocasticPivot_, &hasStocasticPivot_);
+}
+
+
+float EnergySmearer::getScaleOffset(int run, int icat) const
+{
+  int irange = 0;
   if( myParameters_.byRun ) {
-    scale_offset = &(find(myParameters_.scale_offset_byrun.begin(),myParameters_.scale_offset_byrun.end(),run)->scale_offset) ;
+    int nranges = firstRun_.size();
+    for(; irange<nranges; ++irange) {
+      if( run>=firstRun_[irange] && ( lastRun_[irange]<0 || run<=lastRun_[irange] ) ) { break; }
+    }
+    assert( irange < nranges );
   }
-  energySmearingParameters::parameterMapConstIt it=scale_offset->find(category);
   
-  if ( it == scale_offset->end())
+  if ( ! hasScaleOffset_[irange*ncat_+icat] )
     {
       std::cout << "Category was not found in the configuration. Giving Up" << std::endl;
       return false;
     }
   
-  return 1. + it->second;
+  return 1. + scaleOffset_[irange*ncat_+icat];
   
 }
 
@@ -193,9 +301,9 @@ bool EnergySmearer::smearPhoton(PhotonReducedInfo & aPho, float & weight, int ru
 	    }
     }
     
-    std::string category=photonCategory(aPho);
+    int icat=photonCategoryIndex(aPho);
     
-    if (category == "")
+    if (icat < 0)
     {
 	std::cout << "No category has been found associated with this photon. Giving Up" << std::endl;
 	return false;
@@ -219,16 +327,15 @@ bool EnergySmearer::smearPhoton(PhotonReducedInfo & aPho, float & weight, int ru
 	aPho.setCorrEnergyErr(newSigma);
     } else {
 	if( scaleOrSmear_ ) {
-	    float scale_offset   = getScaleOffset(run, category);
+	    float scale_offset   = getScaleOffset(run, icat);
 
-	    scale_offset   += syst_shift * myParameters_.scale_offset_error.find(category)->second;
+	    scale_offset   += syst_shift * scaleOffsetError_[icat];
 	    newEnergy *=  scale_offset;
 	    if( syst_shift == 0. ) {
 		    aPho.cacheVal( smearerId(), this, scale_offset );
 	    }
 	} else {
-	  float smearing_sigma = getSmearingSigma( myParameters_, category, aPho.energy(), 
-						   aPho.caloPosition().Eta(), syst_shift );
+	  float smearing_sigma = getSmearingSigma( icat, aPho.energy(), aPho.caloPosition().Eta(), syst_shift );
 	  
 	  float smear = 1.;
 	  if( smearing_sigma > 0. ) {
@@ -256,14 +363,64 @@ bool EnergySmearer::smearPhoton(PhotonReducedInfo & aPho, float & weight, int ru
     //////////////////////  if you're doing corrections, don't touch the weights ////////////////////////////////////////
     if(doEfficiencies_ && (!doCorrections_) ) {
 	if( !smearing_eff_graph_.empty()  ){
-	    weight = getWeight( ( aPho.energy() / cosh(aPho.caloPosition().PseudoRapidity()) ) ,category, syst_shift);
+	    weight = getWeight( ( aPho.energy() / cosh(aPho.caloPosition().PseudoRapidity()) ) ,categoryNames_[icat], syst_shift);
 	}
     }
     
     return true;
 }
 
+bool EnergySmearer::smearPhotonShifts(PhotonReducedInfo & aPho, int run, int nshifts, const float * syst_shifts, 
+				      float * energies, float * weights) const
+{
+    // stocastic smearing re-seeds the generator for each shift and the regression smearing 
+    //   modifies the energy error: leave those to smearPhoton
+    if( doRegressionSmear_ || ( ! doCorrections_ && ! scaleOrSmear_ ) ) { return false; }
+    if( forceShift_ ) { forceShift_ = false; }
+    for(int ishift=0; ishift<nshifts; ++ishift) { energies[ishift] = aPho.energy(); }
+    if( ! preselCategories_.empty() ) {
+	    if( find(preselCategories_.begin(), preselCategories_.end(),
+		     PhotonCategory::photon_coord_t(
+			     aPho.energy()/cosh(fabs((float)aPho.caloPosition().PseudoRapidity())),
+			     fabs((float)aPho.caloPosition().PseudoRapidity()),(float)aPho.r9(),
+			     aPho.isSphericalPhoton())
+		    ) ==  preselCategories_.end() ) { 
+		    return true; 
+	    }
+    }
+    
+    // the category, scale offset and its error are looked up once for all the shifts
+    int icat=photonCategoryIndex(aPho);
+    if (icat < 0) { return false; }
 
+    if (  doCorrections_ ) {
+	for(int ishift=0; ishift<nshifts; ++ishift) {
+	    energies[ishift] = aPho.corrEnergy() + syst_shifts[ishift] * myParameters_.corrRelErr * (aPho.corrEnergy() - aPho.energy());
+	}
+    } else {
+	float scale_offset       = getScaleOffset(run, icat);
+	float scale_offset_error = scaleOffsetError_[icat];
+	for(int ishift=0; ishift<nshifts; ++ishift) {
+	    energies[ishift] *= scale_offset + syst_shifts[ishift] * scale_offset_error;
+	}
+    }
+    for(int ishift=0; ishift<nshifts; ++ishift) {
+	if( energies[ishift] == 0. ) {
+	    std::cerr << "New energy is 0.: aborting " << this->name() << std::endl;
+	    assert( energies[ishift] != 0. );
+	}
+    }
+    
+    if(doEfficiencies_ && (!doCorrections_) ) {
+	if( !smearing_eff_graph_.empty()  ){
+	    for(int ishift=0; ishift<nshifts; ++ishift) {
+		weights[ishift] = getWeight( ( energies[ishift] / cosh(aPho.caloPosition().PseudoRapidity()) ) ,categoryNames_[icat], syst_shifts[ishift]);
+	    }
+	}
+    }
+    
+    return true;
+}
 
 bool EnergySmearer::initEfficiency() 
 {
@@ -367,7 +524,9 @@ EnergySmearerExtrapolation::EnergySmearerExtrapolation(EnergySmearer * smearer)
 	target_(smearer),
 	name_(smearer->name()+"_extra"),
 	myParameters_(smearer->myParameters_),
-	needed_(false)
+	needed_(false),
+	stocasticSigma_(smearer->smearingStocasticSigma_),
+	stocasticSigmaError_(smearer->smearingStocasticSigmaError_)
 {
 	for(EnergySmearer::energySmearingParameters::parameterMapConstIt ipivot = myParameters_.smearing_stocastic_pivot.begin(); 
 	    ipivot != myParameters_.smearing_stocastic_pivot.end(); ++ipivot ) {
@@ -399,10 +558,10 @@ bool EnergySmearerExtrapolation::smearPhoton(PhotonReducedInfo &info, float & we
 {
 	// modify the target smearer parameters such that the stocastic smearing correspond to syst_shift variations 
 	//    from the nominal value
-	std::string category = EnergySmearer::photonCategory(myParameters_,info);
-	target_->myParameters_.smearing_stocastic_sigma_error[category] = 0.;
-	target_->myParameters_.smearing_stocastic_sigma[category] = myParameters_.smearing_stocastic_sigma.find(category)->second 
-		+ syst_shift*myParameters_.smearing_stocastic_sigma_error.find(category)->second;
+	int icat = target_->photonCategoryIndex(info);
+	if( icat < 0 ) { return true; }
+	target_->smearingStocasticSigmaError_[icat] = 0.;
+	target_->smearingStocasticSigma_[icat] = stocasticSigma_[icat] + syst_shift*stocasticSigmaError_[icat];
 	target_->forceShift_ = true;
 	return true;
 }
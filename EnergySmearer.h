@@ -132,7 +132,9 @@ public:
   virtual const std::string & name() const { return name_; };
   
   virtual bool smearPhoton(PhotonReducedInfo &, float & weight, int run, float syst_shift) const;
-  float getScaleOffset(int run, const std::string & category) const;
+  virtual bool smearPhotonShifts(PhotonReducedInfo &, int run, int nshifts, const float * syst_shifts, 
+				 float * energies, float * weights) const;
+  float getScaleOffset(int run, int icat) const;
 
   void name(const std::string & x) { name_ = x; };
   
@@ -156,12 +158,39 @@ public:
 
   energySmearingParameters  myParameters_;
   
+  // photon categories are identified by a dense index, the position of their name in categoryNames
+  enum category_type_t { unknownCategories=-1, automagicCategories=0, twoCatR9EBEECategories, twoCatR9EBEBm4EECategories, EBEECategories };
+  
   std::string photonCategory(PhotonReducedInfo &) const;
+  int photonCategoryIndex(const PhotonReducedInfo &) const;
+  const std::string & categoryName(int icat) const { return categoryNames_[icat]; };
+  float getSmearingSigma(int icat, float energy, float eta, float syst_shift) const;
+
   static std::string photonCategory(const energySmearingParameters &, const PhotonReducedInfo &);
+  static int categoryTypeId(const std::string & categoryType);
+  static int photonCategoryIndex(int categoryType, const energySmearingParameters::phoCatVector & categories, const PhotonReducedInfo &);
+  static std::vector<std::string> categoryNames(const energySmearingParameters &);
   static float getSmearingSigma(const energySmearingParameters & myParameters, const std::string & category, float energy, 
 				float eta, float syst_shift);
   
  protected:
+  // the parameter maps are compiled into flat arrays indexed by photon category 
+  //   (and by run range for the scale offsets: [irange*ncat_+icat])
+  void compileParameters();
+  void compileParameter(const std::map<std::string,float> & par, std::vector<float> & values, std::vector<char> * found=0) const;
+  static float combineSmearingSigma(float smearing_sigma, float err_sigma, float smearing_stocastic_sigma, float smearing_stocastic_sigma_error, 
+				    const float * pivot, bool etStocastic, float energy, float eta, float syst_shift);
+
+  int categoryType_, ncat_;
+  std::vector<std::string> categoryNames_;
+  std::vector<int> firstRun_, lastRun_;
+  std::vector<float> scaleOffset_;
+  std::vector<char> hasScaleOffset_;
+  std::vector<float> scaleOffsetError_;
+  std::vector<float> smearingSigma_, smearingSigmaError_, smearingStocasticSigma_, smearingStocasticSigmaError_;
+  std::vector<float> smearingStocasticPivot_;
+  std::vector<char> hasStocasticPivot_;
+
   bool doEnergy_, scaleOrSmear_, doEfficiencies_, doCorrections_, doRegressionSmear_;
   mutable bool forceShift_;
   int baseSeed_;
@@ -187,6 +216,7 @@ public:
 	
 	virtual bool smearPhoton(PhotonReducedInfo &, float & weight, int run, float syst_shift) const;
 	virtual const std::string & name() const { return name_; };
+	virtual bool hasSideEffects() const { return true; };
 
 	bool needed() { return needed_; };
 private:
@@ -194,6 +224,8 @@ private:
 	std::string name_;
 	bool needed_;
 	EnergySmearer::energySmearingParameters  myParameters_;
+	// nominal stocastic term of the target, by photon category
+	std::vector<float> stocasticSigma_, stocasticSigmaError_;
 
 };
 
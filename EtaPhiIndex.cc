@@ -0,0 +1,84 @@
+#include "EtaPhiIndex.h"
+#include "TMath.h"
+
+#include <algorithm>
+#include <cmath>
+
+// margin added to the query windows to protect against rounding 
+static const double etaPhiIndexMargin = 1.e-3;
+
+// ------------------------------------------------------------------------------------
+EtaPhiIndex::EtaPhiIndex(double etaMax, double cellSize) : 
+	etaMax_(etaMax), cellSize_(cellSize), nentries_(0)
+{
+	// bin 0 and nEta_-1 collect the objects outside [-etaMax,etaMax]
+	nEta_ = (int)ceil(2.*etaMax_/cellSize_) + 2;
+	nPhi_ = std::max(1,(int)(TMath::TwoPi()/cellSize_));
+}
+
+// ------------------------------------------------------------------------------------
+int EtaPhiIndex::etaBin(double eta) const
+{
+	if( eta < -etaMax_ ) { return 0; }
+	if( eta >= etaMax_ ) { return nEta_-1; }
+	return std::min(nEta_-2, 1+(int)((eta+etaMax_)/cellSize_));
+}
+
+// ------------------------------------------------------------------------------------
+int EtaPhiIndex::phiBin(double phi) const
+{
+	int bin = (int)((phi+TMath::Pi())/TMath::TwoPi()*nPhi_);
+	return std::max(0,std::min(nPhi_-1,bin));
+}
+
+// ------------------------------------------------------------------------------------
+void EtaPhiIndex::build(const std::vector<double> & eta, const std::vector<double> & phi)
+{
+	nentries_ = eta.size();
+	unbinned_.clear();
+	cellStart_.assign(nEta_*nPhi_+1,0);
+	entries_.resize(nentries_);
+
+	// counting sort of the objects by cell
+	std::vector<int> cells(nentries_,-1);
+	for(int ii=0; ii<nentries_; ++ii) {
+		if( TMath::IsNaN(eta[ii]) || TMath::IsNaN(phi[ii]) ) { 
+			unbinned_.push_back(ii);
+			continue; 
+		}
+		cells[ii] = etaBin(eta[ii])*nPhi_ + phiBin(phi[ii]);
+		++cellStart_[cells[ii]+1];
+	}
+	for(size_t icell=1; icell<cellStart_.size(); ++icell) { cellStart_[icell] += cellStart_[icell-1]; }
+	std::vector<int> fill(cellStart_.begin(), cellStart_.end()-1);
+	for(int ii=0; ii<nentries_; ++ii) {
+		if( cells[ii] >= 0 ) { entries_[fill[cells[ii]]++] = ii; }
+	}
+}
+
+// ------------------------------------------------------------------------------------
+void EtaPhiIndex::query(double etaMin, double etaMax, double phi, double dphi, std::vector<int> & entries) const
+{
+	entries = unbinned_;
+	if( nentries_ == 0 ) { return; }
+	
+	int etaLow = etaBin(etaMin-etaPhiIndexMargin), etaHigh = etaBin(etaMax+etaPhiIndexMargin);
+	dphi += etaPhiIndexMargin;
+	int phiLow = 0, nphi = nPhi_;
+	// windows wrapping around all but less than a cell take all the phi bins
+	if( dphi < TMath::Pi()*(1.-1./nPhi_) ) {
+		double low = phi - dphi, high = phi + dphi;
+		if( low < -TMath::Pi() ) { low += TMath::TwoPi(); }
+		if( high > TMath::Pi() ) { high -= TMath::TwoPi(); }
+		phiLow = phiBin(low);
+		nphi = ( phiBin(high) - phiLow + nPhi_ ) % nPhi_ + 1;
+	}
+	for(int ieta=etaLow; ieta<=etaHigh; ++ieta) {
+		for(int jphi=0; jphi<nphi; ++jphi) {
+			int icell = ieta*nPhi_ + (phiLow+jphi)%nPhi_;
+			entries.insert(entries.end(), entries_.begin()+cellStart_[icell], entries_.begin()+cellStart_[icell+1]);
+		}
+	}
+	// keep the order of the original collection, so that sums are not changed
+	std::sort(entries.begin(), entries.end());
+}
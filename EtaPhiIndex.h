@@ -0,0 +1,29 @@
+#ifndef __ETAPHIINDEX__
+#define __ETAPHIINDEX__
+
+#include <vector>
+
+// ------------------------------------------------------------------------------------
+// Eta-phi binned index over a collection of objects (PF candidates, tracks...).
+// A query returns, sorted, the indexes of the objects found in the cells overlapping an 
+// eta-phi window: a superset of the objects inside the window, the caller applies the exact cuts.
+class EtaPhiIndex
+{
+public:
+	EtaPhiIndex(double etaMax=3., double cellSize=0.1);
+	
+	void build(const std::vector<double> & eta, const std::vector<double> & phi);
+	void query(double etaMin, double etaMax, double phi, double dphi, std::vector<int> & entries) const;
+	int size() const { return nentries_; };
+
+private:
+	int etaBin(double eta) const;
+	int phiBin(double phi) const;
+	
+	double etaMax_, cellSize_;
+	int nEta_, nPhi_, nentries_;
+	std::vector<int> cellStart_, entries_;
+	std::vector<int> unbinned_; // objects with undefined coordinates, returned by all queries
+};
+
+#endif
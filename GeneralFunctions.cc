@@ -1,8 +1,57 @@
 #include "LoopAll.h"
 #include "Sorters.h"
 #include "TRandom3.h"
+#include "TMVA/MethodBase.h"
+#include "RootLock.h"
 #define GFDEBUG 0
 
+void LoopAll::fillIsolationObject(isolation_objects_t & objs, int i, const TLorentzVector & p4, const TVector3 * vtx)
+{
+    objs.pt[i] = p4.Pt(), objs.px[i] = p4.Px(), objs.py[i] = p4.Py(), objs.pz[i] = p4.Pz();
+    // same value as TVector3::PseudoRapidity, without the warning for null transverse momentum
+    objs.eta[i] = ( objs.pt[i] != 0. ? p4.Eta() : ( p4.Pz() > 0 ? 10e10 : -10e10 ) );
+    objs.phi[i] = p4.Phi();
+    objs.hasVtx[i] = ( vtx != 0 );
+    if( vtx != 0 ) {
+        objs.vx[i] = vtx->X(), objs.vy[i] = vtx->Y(), objs.vz[i] = vtx->Z();
+        objs.vzMin = std::min(objs.vzMin,objs.vz[i]), objs.vzMax = std::max(objs.vzMax,objs.vz[i]);
+        objs.vrMax = std::max(objs.vrMax,(double)vtx->Perp());
+    }
+}
+
+const LoopAll::isolation_objects_t & LoopAll::pfCandIndex()
+{
+    isolation_objects_t & pf = pfCandIndex_;
+    if( ! pf.valid ) {
+        pf.resize(pfcand_n);
+        pf.vzMin = 1e9, pf.vzMax = -1e9, pf.vrMax = 0.;
+        for(int i=0; i<pfcand_n; i++) {
+            pf.pdgid[i] = pfcand_pdgid[i];
+            fillIsolationObject(pf, i, *((TLorentzVector*)pfcand_p4->At(i)), (TVector3*)pfcand_posvtx->At(i));
+        }
+        pf.index.build(pf.eta, pf.phi);
+        pf.valid = true;
+    }
+    return pf;
+}
+
+const LoopAll::isolation_objects_t & LoopAll::trackIndex()
+{
+    isolation_objects_t & tk = trackIndex_;
+    if( ! tk.valid ) {
+        tk.resize(tk_n);
+        tk.vzMin = 1e9, tk.vzMax = -1e9, tk.vrMax = 0.;
+        for(int itk=0; itk<tk_n; itk++) {
+            tk.pdgid[itk] = 0;
+            fillIsolationObject(tk, itk, *((TLorentzVector *) tk_p4->At(itk)), 
+                                ( itk < tk_vtx_pos->GetEntries() ? (TVector3 *) tk_vtx_pos->At(itk) : 0 ) );
+        }
+        tk.index.build(tk.eta, tk.phi);
+        tk.valid = true;
+    }
+    return tk;
+}
+
 float LoopAll::pfTkIsoWithVertex(int phoindex, int vtxInd, float dRmax, float dRvetoBarrel, float dRvetoEndcap, 
                                  float ptMin, float dzMax, float dxyMax, int pfToUse) {
   
@@ -13,36 +62,39 @@ float LoopAll::pfTkIsoWithVertex(int phoindex, int vtxInd, float dRmax, float dR
         dRveto = dRvetoEndcap;
   
     TLorentzVector photonDirectionWrtVtx = get_pho_p4(phoindex, vtxInd, 0);
+    double phoEta = photonDirectionWrtVtx.Eta(), phoPhi = photonDirectionWrtVtx.Phi();
+    TVector3* vtx = (TVector3*)vtx_std_xyz->At(vtxInd);
   
+    // Loop over the PFCandidates around the photon
+    const isolation_objects_t & pf = pfCandIndex();
+    pf.index.query(phoEta-dRmax, phoEta+dRmax, phoPhi, dRmax, isolationQuery_);
     float sum = 0;
-    // Loop over the PFCandidates
-    for(unsigned i=0; i<pfcand_n; i++) {
+    for(size_t j=0; j<isolationQuery_.size(); j++) {
+        int i = isolationQuery_[j];
     
         //require that PFCandidate is a charged hadron
-        if (pfcand_pdgid[i] == pfToUse) {
-      
-            TLorentzVector* pfc = (TLorentzVector*)pfcand_p4->At(i);
+        if (pf.pdgid[i] == pfToUse) {
       
-            if (pfc->Pt() < ptMin)
+            if (pf.pt[i] < ptMin)
                 continue;
     
-            TVector3* vtx = (TVector3*)vtx_std_xyz->At(vtxInd);
-            TVector3* pfCandVtx = (TVector3*)pfcand_posvtx->At(i);
-
-            float dz = fabs(pfCandVtx->Z() - vtx->Z());
+            float dz = fabs(pf.vz[i] - vtx->Z());
       
             if (dz > dzMax) 
                 continue;
 
-            double dxy = (-(pfCandVtx->X() - vtx->X())*pfc->Py() + (pfCandVtx->Y() - vtx->Y())*pfc->Px()) / pfc->Pt();
+            double dxy = (-(pf.vx[i] - vtx->X())*pf.py[i] + (pf.vy[i] - vtx->Y())*pf.px[i]) / pf.pt[i];
             if(fabs(dxy) > dxyMax) 
                 continue;
       
-            float dR = photonDirectionWrtVtx.DeltaR(*pfc);
+            // same as TLorentzVector::DeltaR
+            double deta = phoEta - pf.eta[i];
+            double dphi = TVector2::Phi_mpi_pi(phoPhi - pf.phi[i]);
+            float dR = TMath::Sqrt(deta*deta + dphi*dphi);
             if(dR > dRmax || dR < dRveto) 
                 continue;
       
-            sum += pfc->Pt();
+            sum += pf.pt[i];
         }
     }
   
@@ -63,10 +115,29 @@ float LoopAll::pfEcalIso(int phoindex, float dRmax, float dRVetoBarrel, float dR
         thr = thrEndcaps;
     }
 
+    const isolation_objects_t & pf = pfCandIndex();
+    if( pf.index.size() == 0 ) { return 0.; }
+    TVector3* phoEcalPos = (TVector3*)sc_xyz->At(pho_scind[phoindex]);
+
+    // The photon direction is taken with respect to the vertex of each candidate. 
+    //   Bound it using the bounding box of the candidate vertices, and look for candidates within dRmax of it.
+    double rho = phoEcalPos->Perp();
+    if( rho > pf.vrMax ) {
+        double rhoLow = rho - pf.vrMax, rhoHigh = rho + pf.vrMax;
+        double dzLow = phoEcalPos->Z() - pf.vzMax, dzHigh = phoEcalPos->Z() - pf.vzMin;
+        double etaLow  = std::min(TMath::ASinH(dzLow/rhoLow), TMath::ASinH(dzLow/rhoHigh));
+        double etaHigh = std::max(TMath::ASinH(dzHigh/rhoLow), TMath::ASinH(dzHigh/rhoHigh));
+        double dphi = TMath::ASin(pf.vrMax/rho);
+        pf.index.query(etaLow-dRmax, etaHigh+dRmax, phoEcalPos->Phi(), dphi+dRmax, isolationQuery_);
+    } else {
+        pf.index.query(-1e11, 1e11, 0., TMath::Pi(), isolationQuery_);
+    }
+
     float sum = 0;
-    for(unsigned i=0; i<pfcand_n; i++) {
+    for(size_t j=0; j<isolationQuery_.size(); j++) {
+        int i = isolationQuery_[j];
     
-        if (pfcand_pdgid[i] == pfToUse) {
+        if (pf.pdgid[i] == pfToUse) {
       
             // FIXME questo non so come implementarlo...
             //if(pfc.superClusterRef().isNonnull() && localPho->superCluster().isNonnull()) {
@@ -74,20 +145,19 @@ float LoopAll::pfEcalIso(int phoindex, float dRmax, float dRVetoBarrel, float dR
             //  continue;
             //}
       
-            TVector3* pfvtx = (TVector3*)pfcand_posvtx->At(i);
-            TVector3* phoEcalPos = (TVector3*)sc_xyz->At(pho_scind[phoindex]);
-
-            TVector3 photonDirectionWrtVtx = TVector3(phoEcalPos->X() - pfvtx->X(),
-                                                      phoEcalPos->Y() - pfvtx->Y(),
-                                                      phoEcalPos->Z() - pfvtx->Z());
+            TVector3 photonDirectionWrtVtx = TVector3(phoEcalPos->X() - pf.vx[i],
+                                                      phoEcalPos->Y() - pf.vy[i],
+                                                      phoEcalPos->Z() - pf.vz[i]);
 
-            TLorentzVector* pfc = (TLorentzVector*)pfcand_p4->At(i);
-
-            if( pfc->Pt() < thr ) 
+            if( pf.pt[i] < thr ) 
                 continue;
 
-            float dEta = fabs(photonDirectionWrtVtx.Eta() - pfc->Eta());
-            float dR = photonDirectionWrtVtx.DeltaR(pfc->Vect());
+            // same as TVector3::DeltaR
+            double phoEta = photonDirectionWrtVtx.Eta();
+            float dEta = fabs(phoEta - pf.eta[i]);
+            double deta = phoEta - pf.eta[i];
+            double dphi = TVector2::Phi_mpi_pi(photonDirectionWrtVtx.Phi() - pf.phi[i]);
+            float dR = TMath::Sqrt(deta*deta + dphi*dphi);
       
             if (dEta < etaStrip)
                 continue;
@@ -95,7 +165,7 @@ float LoopAll::pfEcalIso(int phoindex, float dRmax, float dRVetoBarrel, float dR
             if(dR > dRmax || dR < dRVeto)
                 continue;
       
-            sum += pfc->Pt();
+            sum += pf.pt[i];
         }
     }
   
@@ -251,6 +321,51 @@ void LoopAll::SetAllMVA() {
   tmvaReaderID_2013_Endcap->AddVariable("ph.idmva_PsEffWidthSigmaRR",   &tmva_photonid_ESEffSigmaRR );
 }
 
+Float_t LoopAll::evaluateMVA(TMVA::Reader * reader, const char * method) {
+
+  std::pair<TMVA::Reader *,std::string> key(reader,method);
+  std::map<std::pair<TMVA::Reader *,std::string>,compiled_mva_t>::iterator it = compiledMvas_.find(key);
+  if( it == compiledMvas_.end() ) {
+    // compile the forest from the weights file booked in the reader; the inputs must all be floats
+    R__LOCKGUARD(gRootLock);
+    it = compiledMvas_.insert( std::make_pair(key,compiled_mva_t()) ).first;
+    compiled_mva_t & mva = it->second;
+    TMVA::MethodBase * mb = dynamic_cast<TMVA::MethodBase *>(reader->FindMVA(method));
+    TMVA::DataSetInfo & dsi = reader->DataInfo();
+    bool floats = true;
+    for(UInt_t ivar=0; ivar<dsi.GetNVariables(); ++ivar) {
+      TMVA::VariableInfo & vinfo = dsi.GetVariableInfo(ivar);
+      floats = floats && vinfo.GetVarType() == 'F' && vinfo.GetExternalLink() != 0;
+      mva.inputs.push_back( (Float_t *)vinfo.GetExternalLink() );
+    }
+    if( mb != 0 && floats && mva.forest.load( mb->GetWeightFileName().Data() ) && mva.forest.nVariables() == (int)mva.inputs.size() ) {
+      mva.row.resize(mva.inputs.size());
+      std::cout << "LoopAll::evaluateMVA: evaluating " << method << " from " << mb->GetWeightFileName() 
+		<< " with " << mva.forest.nTrees() << " compiled trees" << std::endl;
+    } else {
+      mva.forest.clear();
+    }
+  }
+  
+  compiled_mva_t & mva = it->second;
+  if( ! mva.forest.valid() ) { 
+    R__LOCKGUARD(gRootLock);
+    return reader->EvaluateMVA(method);
+  }
+  for(size_t ivar=0; ivar<mva.inputs.size(); ++ivar) {
+    mva.row[ivar] = *(mva.inputs[ivar]);
+  }
+  Float_t ret = mva.forest.evaluate(&mva.row[0]);
+  if( checkCompiledMvas ) {
+    R__LOCKGUARD(gRootLock);
+    Float_t ref = reader->EvaluateMVA(method);
+    if( fabs(ret - ref) > 1.e-5*std::max(1.f,(float)fabs(ref)) ) {
+      std::cout << "LoopAll::evaluateMVA: " << method << " compiled forest gives " << ret << " TMVA::Reader gives " << ref << std::endl;
+    }
+  }
+  return ret;
+}
+
 Float_t LoopAll::photonIDMVA2013(Int_t iPhoton, Int_t vtx, TLorentzVector &p4, const char* type)  {
 
     Float_t mva = 999.;
@@ -281,9 +396,9 @@ Float_t LoopAll::photonIDMVA2013(Int_t iPhoton, Int_t vtx, TLorentzVector &p4, c
   tmva_photonid_ESEffSigmaRR = pho_ESEffSigmaRR[iPhoton];
 
   if (pho_isEB[iPhoton]) {
-    mva = tmvaReaderID_2013_Barrel->EvaluateMVA("AdaBoost");
+    mva = evaluateMVA(tmvaReaderID_2013_Barrel,"AdaBoost");
   } else {
-    mva = tmvaReaderID_2013_Endcap->EvaluateMVA("AdaBoost");
+    mva = evaluateMVA(tmvaReaderID_2013_Endcap,"AdaBoost");
   }
 
     return mva;
@@ -318,10 +433,10 @@ Float_t LoopAll::photonIDMVA2012(Int_t iPhoton, Int_t vtx, TLorentzVector &p4, c
   tmva_photonid_ESEffSigmaRR = pho_ESEffSigmaRR[iPhoton];
 
   if (pho_isEB[iPhoton]) {
-    mva = tmvaReaderID_Single_Barrel->EvaluateMVA("AdaBoost");
+    mva = evaluateMVA(tmvaReaderID_Single_Barrel,"AdaBoost");
   }
   else {
-    mva = tmvaReaderID_Single_Endcap->EvaluateMVA("AdaBoost");
+    mva = evaluateMVA(tmvaReaderID_Single_Endcap,"AdaBoost");
   }
 
     return mva;
@@ -375,6 +490,7 @@ Float_t LoopAll::photonIDMVA2011(Int_t iPhoton, Int_t vtx, TLorentzVector &p4, c
         tmva_id_ucsd_eta = fabs(p4.Eta());
         tmva_id_ucsd_isLeading = -1.; // not used just a spectator in the original definition
     
+        R__LOCKGUARD(gRootLock);
         mva = tmvaReaderID_UCSD->EvaluateMVA("Gradient");
     } else {
         tmva_id_mit_hoe = pho_hoe[iPhoton];
@@ -404,6 +520,7 @@ Float_t LoopAll::photonIDMVA2011(Int_t iPhoton, Int_t vtx, TLorentzVector &p4, c
         tmva_id_mit_preshower = sc_pre[pho_scind[iPhoton]]/raw;
         tmva_id_mit_sceta    = ((TVector3*)sc_xyz->At(pho_scind[iPhoton]))->Eta();
 
+        R__LOCKGUARD(gRootLock);
         if (pho_isEB[iPhoton]) 
             mva = tmvaReaderID_MIT_Barrel->EvaluateMVA("AdaBoost");
         else
@@ -439,6 +556,7 @@ Float_t LoopAll::diphotonMVA(Int_t diphoton_id, Int_t leadingPho, Int_t subleadi
         // tmva_dipho_UCSD_dmom = sigmaMrv/mass;
         tmva_dipho_UCSD_dmom = sigmaMeonly/mass;
   
+        R__LOCKGUARD(gRootLock);
         mva = tmvaReader_dipho_UCSD->EvaluateMVA("Gradient");
     } else {
         *tmva_dipho_MIT_dmom = sigmaMrv/mass;
@@ -469,7 +587,15 @@ Float_t LoopAll::diphotonMVA(Int_t diphoton_id, Int_t leadingPho, Int_t subleadi
         }
 	
 	tmva_dipho_MIT_cache[diphoton_id] = tmva_dipho_MIT_buf;
-	mva = ( funcReader_dipho_MIT != 0 ? funcReader_dipho_MIT->eval() : tmvaReader_dipho_MIT->EvaluateMVA("Gradient") );
+	std::map<std::vector<Float_t>,Float_t>::iterator memo = diphoMvaMemo_.find(tmva_dipho_MIT_buf);
+	if( memo != diphoMvaMemo_.end() ) {
+	    ++diphoMvaMemoHits;
+	    mva = memo->second;
+	} else {
+	    ++diphoMvaMemoMisses;
+	    mva = ( funcReader_dipho_MIT != 0 ? funcReader_dipho_MIT->eval() : evaluateMVA(tmvaReader_dipho_MIT,"Gradient") );
+	    diphoMvaMemo_.insert( std::make_pair(tmva_dipho_MIT_buf,mva) );
+	}
     }
 
     return mva;
@@ -1204,16 +1330,13 @@ TLorentzVector LoopAll::correctMet_Simple( TLorentzVector & pho_lead, TLorentzVe
 
 TLorentzVector LoopAll::METCorrection2012B(TLorentzVector lead_p4, TLorentzVector sublead_p4, bool moriond2013MetCorrection){
   
-  // corrected met
-  static TLorentzVector finalCorrMET;
-  static int lastEvent=-1, lastLumi=-1, lastRun=-1;
-  static bool lastIsMC;
-  static TLorentzVector last_lead, last_sublead;
+  // corrected met, cached per LoopAll so that every worker keeps its own
+  TLorentzVector & finalCorrMET = metCorr2012B_;
   
   bool isMC = itype[current]!=0;
 
-  if( event == lastEvent && lumis == lastLumi && run == lastRun && lastIsMC == isMC &&
-      last_lead == lead_p4 && last_sublead == sublead_p4 ) {
+  if( event == metCorrEvent_ && lumis == metCorrLumi_ && run == metCorrRun_ && metCorrIsMC_ == isMC &&
+      metCorrLead_ == lead_p4 && metCorrSublead_ == sublead_p4 ) {
 	  return finalCorrMET;
   }
 
@@ -1251,12 +1374,12 @@ TLorentzVector LoopAll::METCorrection2012B(TLorentzVector lead_p4, TLorentzVecto
     finalCorrMET = shiftscaleMET_corr;
   }
 
-  lastEvent = event;
-  lastLumi  = lumis;
-  lastRun   = run;
-  lastIsMC  = isMC;
-  last_lead = lead_p4;
-  last_sublead = sublead_p4;
+  metCorrEvent_ = event;
+  metCorrLumi_  = lumis;
+  metCorrRun_   = run;
+  metCorrIsMC_  = isMC;
+  metCorrLead_ = lead_p4;
+  metCorrSublead_ = sublead_p4;
   
   return finalCorrMET;
 }
@@ -3682,35 +3805,39 @@ Float_t LoopAll::SumTrackPtInCone(TLorentzVector *photon_p4, Int_t vtxind, Float
         }
     }
   
-    for(unsigned int itk=0; itk!=tk_n; itk++) {
+    // only look at the tracks around the photon
+    double pho_eta = photon_p4->Eta();
+    double pho_phi = photon_p4->Phi();
+    const isolation_objects_t & tk = trackIndex();
+    tk.index.query(pho_eta-OuterConeRadius, pho_eta+OuterConeRadius, pho_phi, OuterConeRadius, isolationQuery_);
+    for(size_t jtk=0; jtk<isolationQuery_.size(); jtk++) {
+        unsigned int itk = isolationQuery_[jtk];
         // remove electron track for Zee validation when there is a match
         if(Zee_validation && !pho_isconv[pho_ind] && electronMatch!=-1) {
             if(itk==el_std_tkind[electronMatch]) continue;
         }  
 
-        TLorentzVector * tkp4= (TLorentzVector *) tk_p4->At(itk);
-        if(tkp4->Pt() < PtMin)continue;
+        if(tk.pt[itk] < PtMin)continue;
 	
-	if( itk >= tk_vtx_pos->GetEntries() ) {
-		std::cout << "WARNING: track position at vertex not available " << vtxind << " " << itk << " " << tkp4->Pt() << std::endl;
+	if( ! tk.hasVtx[itk] ) {
+		std::cout << "WARNING: track position at vertex not available " << vtxind << " " << itk << " " << tk.pt[itk] << std::endl;
 	} else {
-		TVector3 * tkpos= (TVector3 *) tk_vtx_pos->At(itk);
-		/// double deltaz = fabs(vtxpos->Z() - tkpos->Z()); 
-		double deltaz = fabs( (tkpos->Z()-vtxpos->Z()) - ( (tkpos->X()-vtxpos->X())*tkp4->Px() + (tkpos->Y()-vtxpos->Y())*tkp4->Py() )/tkp4->Pt() * tkp4->Pz()/tkp4->Pt() );
+		/// double deltaz = fabs(vtxpos->Z() - tk.vz[itk]); 
+		double deltaz = fabs( (tk.vz[itk]-vtxpos->Z()) - ( (tk.vx[itk]-vtxpos->X())*tk.px[itk] + (tk.vy[itk]-vtxpos->Y())*tk.py[itk] )/tk.pt[itk] * tk.pz[itk]/tk.pt[itk] );
 		if(deltaz > dzmax)continue;
 		
-		double dxy = ( -(tkpos->X() - vtxpos->X())*tkp4->Py() + (tkpos->Y() - vtxpos->Y())*tkp4->Px()) / tkp4->Pt();
+		double dxy = ( -(tk.vx[itk] - vtxpos->X())*tk.py[itk] + (tk.vy[itk] - vtxpos->Y())*tk.px[itk]) / tk.pt[itk];
 		if(fabs(dxy) > dxymax)continue;
 	}
-        double tk_eta = tkp4->Eta();
-        double tk_phi = tkp4->Phi();
-        double deta = fabs(photon_p4->Eta() - tk_eta);
-        double dphi = fabs(photon_p4->Phi() - tk_phi);
+        double tk_eta = tk.eta[itk];
+        double tk_phi = tk.phi[itk];
+        double deta = fabs(pho_eta - tk_eta);
+        double dphi = fabs(pho_phi - tk_phi);
         if(dphi > TMath::Pi())dphi = TMath::TwoPi() - dphi;
     
         double deltaR = sqrt(deta*deta + dphi*dphi);
     
-        if(deltaR < OuterConeRadius && deltaR >= InnerConeRadius && deta >= EtaStripHalfWidth)SumTrackPt+=tkp4->Pt();
+        if(deltaR < OuterConeRadius && deltaR >= InnerConeRadius && deta >= EtaStripHalfWidth)SumTrackPt+=tk.pt[itk];
     }
     return SumTrackPt;
 }
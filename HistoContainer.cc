@@ -38,7 +38,26 @@ std::string HistoContainer::ModifiedName(char* name, int i) {
   return output;
 }
 
-void HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories,int bins, float xmin, float xmax) {
+int HistoContainer::book(const std::string & name, int dim, int nslots) {
+
+  std::map<std::string, int>::iterator it = handles.find(name);
+  if (it != handles.end() && dims[it->second] == dim) {
+    return it->second;
+  }
+  int hdl = it != handles.end() ? it->second : (int)names.size();
+  if (it == handles.end()) {
+    names.push_back(name);
+    dims.push_back(dim);
+    slots.push_back(nslots);
+    handles[name] = hdl;
+  } else {
+    dims[hdl] = dim;
+    slots[hdl] = nslots;
+  }
+  return hdl;
+}
+
+int HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories,int bins, float xmin, float xmax) {
 
   std::vector<TH1F> temp;
   for (int i=0; i<categories; i++) {
@@ -52,12 +71,14 @@ void HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories,in
     temp.back().SetDirectory(0);
     //temp.push_back(TH1F(modName.c_str(), modName.c_str(), bins, xmin, xmax));
   }
-  names.push_back(name);
-  h1[std::string(name)] = temp;
+  int hdl = book(name, 1, h1.size());
+  if (slots[hdl] == (int)h1.size()) { h1.push_back(temp); }
+  else { h1[slots[hdl]] = temp; }
+  return hdl;
 }
 
 
-void HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories, int binsx, float xmin, float xmax,
+int HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories, int binsx, float xmin, float xmax,
 			 int binsy, float ymin, float ymax) {
   
   std::vector<TH2F> temp;
@@ -70,11 +91,13 @@ void HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories, i
     temp.push_back(histo_temp);
     //temp.push_back(TH2F(modName.c_str(), modName.c_str(), binsx, xmin, xmax, binsy, ymin, ymax));
   }
-  names.push_back(name);
-  h2[std::string(name)] = temp;
+  int hdl = book(name, 2, h2.size());
+  if (slots[hdl] == (int)h2.size()) { h2.push_back(temp); }
+  else { h2[slots[hdl]] = temp; }
+  return hdl;
 }
 
-void HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories, int binsx, 
+int HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories, int binsx, 
 			 float xmin, float xmax,
 			 float ymin, float ymax) {
 
@@ -87,212 +110,123 @@ void HistoContainer::Add(char* name, char* xaxis, char* yaxis, int categories, i
     temp.push_back(histo_temp);
     //temp.push_back(TProfile(modName.c_str(), modName.c_str(), binsx, xmin, xmax, ymin, ymax));
   }
-  names.push_back(name);
-  hp[std::string(name)] = temp;
+  int hdl = book(name, 3, hp.size());
+  if (slots[hdl] == (int)hp.size()) { hp.push_back(temp); }
+  else { hp[slots[hdl]] = temp; }
+  return hdl;
 } 
 
 void HistoContainer::Fill(std::string name, int category, float value) {
-  Fill(name, category, value, 1.0);
+  Fill(handle(name), category, value, 1.0);
 }
 
 void HistoContainer::Fill(std::string name, int category, float value, float weight) {
-
-  //std::string modName = ModifiedName(name);
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(std::string(name));
-  /// if( category == 0 )std::cerr << " HistoContainer::Fill " << total_scale << " " << weight << std::endl;
-  if (it != h1.end()) {
-    (it->second)[category].Fill(value, total_scale*weight);
-    return;
-  }
+  Fill(handle(name), category, value, weight);
 }
 
 void HistoContainer::Fill2D(std::string name, int category, float valuex, float valuey) { 
-  Fill2D(name, category, valuex, valuey, 1.0);
+  Fill2D(handle(name), category, valuex, valuey, 1.0);
 }
 
 void HistoContainer::Fill2D(std::string name, int category, float valuex, float valuey, float weight) { 
-
-  //std::string modName = ModifiedName(name);
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(std::string(name));
-  if (itp != hp.end()) {
-    (itp->second)[category].Fill(valuex, valuey, total_scale*weight);
-    return;
-  }
-
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(std::string(name));
-  if (it2 != h2.end()) {
-    (it2->second)[category].Fill(valuex, valuey, total_scale*weight);
-    return;
-  }
+  Fill2D(handle(name), category, valuex, valuey, weight);
 }
 
 void HistoContainer::Save() {
-  std::map<std::string, std::vector<TH1F> >::iterator it;
-  for (it = h1.begin(); it != h1.end(); ++it) {
-    for (unsigned int i=0; i<(it->second).size(); i++) {
-      (it->second)[i].Write();
+  for (unsigned int n=0; n<names.size(); n++) {
+    if (dims[n] == 1) {
+      std::vector<TH1F> & hists = h1[slots[n]];
+      for (unsigned int i=0; i<hists.size(); i++) { hists[i].Write(); }
+    } else if (dims[n] == 2) {
+      std::vector<TH2F> & hists = h2[slots[n]];
+      for (unsigned int i=0; i<hists.size(); i++) { hists[i].Write(); }
+    } else {
+      std::vector<TProfile> & hists = hp[slots[n]];
+      for (unsigned int i=0; i<hists.size(); i++) { hists[i].Write(); }
     }
   }
+}
 
-  std::map<std::string, std::vector<TH2F> >::iterator it2;
-  for (it2 = h2.begin(); it2 != h2.end(); ++it2) {
-    for (unsigned int i=0; i<(it2->second).size(); i++) {
-      (it2->second)[i].Write(); 
+void HistoContainer::Merge(HistoContainer & other) {
+  for (unsigned int n=0; n<names.size(); n++) {
+    int hdl = other.handle(names[n]);
+    if (hdl < 0 || other.dims[hdl] != dims[n]) { continue; }
+    if (dims[n] == 1) {
+      std::vector<TH1F> & hists = h1[slots[n]], & extra = other.h1[other.slots[hdl]];
+      for (unsigned int i=0; i<hists.size() && i<extra.size(); i++) { hists[i].Add(&extra[i]); }
+    } else if (dims[n] == 2) {
+      std::vector<TH2F> & hists = h2[slots[n]], & extra = other.h2[other.slots[hdl]];
+      for (unsigned int i=0; i<hists.size() && i<extra.size(); i++) { hists[i].Add(&extra[i]); }
+    } else {
+      std::vector<TProfile> & hists = hp[slots[n]], & extra = other.hp[other.slots[hdl]];
+      for (unsigned int i=0; i<hists.size() && i<extra.size(); i++) { hists[i].Add(&extra[i]); }
     }
   }
+}
 
-  std::map<std::string, std::vector<TProfile> >::iterator itp;
-  for (itp = hp.begin(); itp != hp.end(); ++itp) {
-    for (unsigned int i=0; i<(itp->second).size(); i++) {
-      (itp->second)[i].Write();
-    }
-  }
+TH1 * HistoContainer::first(int n) {
+  if (n < 0 || n >= (int)names.size()) { return 0; }
+  if (dims[n] == 1) { return h1[slots[n]].empty() ? 0 : &h1[slots[n]][0]; }
+  if (dims[n] == 2) { return h2[slots[n]].empty() ? 0 : &h2[slots[n]][0]; }
+  return hp[slots[n]].empty() ? 0 : &hp[slots[n]][0];
 }
 
 int HistoContainer::getDimension(int n) {
-
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(names[n]);
-  if (it != h1.end())
-    return 1;
-
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(names[n]);
-  if (it2 != h2.end())
-    return 2;
-  
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(names[n]);
-  if (itp != hp.end())
-    return 3;
+  return dims[n];
 }
 
 int HistoContainer::ncat(int n) {
   
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(names[n]);
-  if (it != h1.end())
-    return it->second.size();
-  
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(names[n]);
-  if (it2 != h2.end())
-    return it2->second.size();
-  
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(names[n]);
-  if (itp != hp.end())
-    return itp->second.size(); 
-  
-  return -1;
+  if (n < 0 || n >= (int)names.size())
+    return -1;
+  if (dims[n] == 1)
+    return h1[slots[n]].size();
+  if (dims[n] == 2)
+    return h2[slots[n]].size();
+  return hp[slots[n]].size();
 }
 
 int HistoContainer::nbins(int n, bool isX) {
   
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(names[n]);
-  if (it != h1.end()) {
-    if (isX)
-      return (it->second)[0].GetNbinsX();
-    else
-      return -1;
-  }
-  
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(names[n]);
-  if (it2 != h2.end()) {
-    if (isX)
-      return (it2->second)[0].GetNbinsX();
-    else
-      return (it2->second)[0].GetNbinsY();
-  }
-  
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(names[n]);
-  if (itp != hp.end()) {
-    if (isX)
-      return (itp->second)[0].GetNbinsX();
-    else
-      return -1;
-  }
-
+  TH1 * h = first(n);
+  if (h == 0)
+    return -1;
+  if (isX)
+    return h->GetNbinsX();
+  if (dims[n] == 2)
+    return h->GetNbinsY();
   return -1;
 }
 
 float HistoContainer::max(int n, bool isX) {
   
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(names[n]);
-  if (it != h1.end()) {
-    if (isX)
-      return (it->second)[0].GetXaxis()->GetXmax();
-    else
-      return (it->second)[0].GetYaxis()->GetXmax();
-  }
-  
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(names[n]);
-  if (it2 != h2.end()) {
-    if (isX)
-      return (it2->second)[0].GetXaxis()->GetXmax();
-    else
-      return (it2->second)[0].GetYaxis()->GetXmax();
-  }
-  
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(names[n]);
-  if (itp != hp.end()) {
-    if (isX)
-      return (itp->second)[0].GetXaxis()->GetXmax();
-    else
-      return (itp->second)[0].GetYaxis()->GetXmax();
-  }
-
-  return -1;
+  TH1 * h = first(n);
+  if (h == 0)
+    return -1;
+  if (isX)
+    return h->GetXaxis()->GetXmax();
+  else
+    return h->GetYaxis()->GetXmax();
 }
 
 float HistoContainer::min(int n, bool isX) {
   
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(names[n]);
-  if (it != h1.end()) {
-    if (isX)
-      return (it->second)[0].GetXaxis()->GetXmin();
-    else
-      return (it->second)[0].GetYaxis()->GetXmin();
-  }
-  
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(names[n]);
-  if (it2 != h2.end()) {
-    if (isX)
-      return (it2->second)[0].GetXaxis()->GetXmin();
-    else
-      return (it2->second)[0].GetYaxis()->GetXmin();
-  }
-  
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(names[n]);
-  if (itp != hp.end()) {
-    if (isX)
-      return (itp->second)[0].GetXaxis()->GetXmin();
-    else
-      return (itp->second)[0].GetYaxis()->GetXmin();
-  }
-
-  return -1;
+  TH1 * h = first(n);
+  if (h == 0)
+    return -1;
+  if (isX)
+    return h->GetXaxis()->GetXmin();
+  else
+    return h->GetYaxis()->GetXmin();
 }
 
 std::string HistoContainer::axisName(int n, bool isX) {
   
-  std::map<std::string, std::vector<TH1F> >::iterator it = h1.find(names[n]);
-  if (it != h1.end()) {
-    if (isX)
-      return (it->second)[0].GetXaxis()->GetTitle();
-    else
-      return (it->second)[0].GetYaxis()->GetTitle();
-  }
-  
-  std::map<std::string, std::vector<TH2F> >::iterator it2 = h2.find(names[n]);
-  if (it2 != h2.end()) {
-    if (isX)
-      return (it2->second)[0].GetXaxis()->GetTitle();
-    else
-      return (it2->second)[0].GetYaxis()->GetTitle();
-  }
-  
-  std::map<std::string, std::vector<TProfile> >::iterator itp = hp.find(names[n]);
-  if (itp != hp.end()) {
-    if (isX)
-      return (itp->second)[0].GetXaxis()->GetTitle();
-    else
-      return (itp->second)[0].GetYaxis()->GetTitle();
-  }
-
-  return "";
+  TH1 * h = first(n);
+  if (h == 0)
+    return "";
+  if (isX)
+    return h->GetXaxis()->GetTitle();
+  else
+    return h->GetYaxis()->GetTitle();
 }
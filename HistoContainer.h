@@ -14,15 +14,34 @@ class HistoContainer {
   HistoContainer(int,std::string);
   ~HistoContainer();
     
-  void Add(char *, char*, char*, int, int, float, float);
-  void Add(char *, char*, char*, int, int, float, float, int, float, float);
-  void Add(char *, char*, char*, int, int, float, float, float, float);
+  /** booking methods return the handle of the histogram, i.e. its index in the list of names */
+  int Add(char *, char*, char*, int, int, float, float);
+  int Add(char *, char*, char*, int, int, float, float, int, float, float);
+  int Add(char *, char*, char*, int, int, float, float, float, float);
+
+  /** @return the handle of a booked histogram, -1 if no histogram with this name exists */
+  int handle(const std::string & name) const { 
+    std::map<std::string, int>::const_iterator it = handles.find(name); 
+    return ( it != handles.end() ? it->second : -1 );
+  };
 
   void Fill(std::string, int, float);
   void Fill(std::string, int, float, float);
+  void Fill(int handle, int category, float value, float weight) {
+    if( handle < 0 || dims[handle] != 1 ) { return; }
+    h1[slots[handle]][category].Fill(value, total_scale*weight);
+  };
   
   void Fill2D(std::string, int, float, float);
   void Fill2D(std::string, int, float, float, float);
+  void Fill2D(int handle, int category, float valuex, float valuey, float weight) {
+    if( handle < 0 ) { return; }
+    if( dims[handle] == 3 ) { 
+      hp[slots[handle]][category].Fill(valuex, valuey, total_scale*weight); 
+    } else if( dims[handle] == 2 ) {
+      h2[slots[handle]][category].Fill(valuex, valuey, total_scale*weight); 
+    }
+  };
 
   int ncat(int n);
   int size() { return (int)names.size(); }
@@ -33,6 +52,7 @@ class HistoContainer {
   std::string getName(int n) { return names[n]; }
   
   void Save();
+  void Merge(HistoContainer &);
 
   int getDimension(int);
   int getHistVal();
@@ -46,10 +66,17 @@ class HistoContainer {
   int histVal;
   std::string histNam;
   std::vector<std::string> names;
+  std::map<std::string, int> handles;
   
-  std::map<std::string, std::vector<TH1F> > h1;
-  std::map<std::string, std::vector<TH2F> > h2;
-  std::map<std::string, std::vector<TProfile> > hp;
+  // dimension (1: TH1F, 2: TH2F, 3: TProfile) and position in h1, h2 or hp of each handle
+  std::vector<int> dims;
+  std::vector<int> slots;
+  int book(const std::string & name, int dim, int nslots);
+  TH1 * first(int n);
+
+  std::vector<std::vector<TH1F> > h1;
+  std::vector<std::vector<TH2F> > h2;
+  std::vector<std::vector<TProfile> > hp;
 };
 
 #endif
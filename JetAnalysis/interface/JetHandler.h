@@ -65,6 +65,15 @@ private:
     int nLumiBins_;
     float lumiStep_;
     JetResponseChange *jetResponseChange;
+
+    // track to vertex association, built once per event from vtx_std_tkind and shared by all the jets and vertices
+    void buildTrackVertexMap();
+    const float * trackDz(int itrack);
+    int tkMapFile_, tkMapRun_, tkMapLumi_, tkMapEvent_, tkMapNtk_, tkMapNvtx_;
+    std::vector<unsigned char> tkInVtx_;  // [itrack*nvtx+ivtx]: the track is in the vertex track list
+    std::vector<short> tkNVtx_;           // number of vertices the track is associated to
+    std::vector<float> tkDz_;             // [itrack*(nvtx+1)+ivtx]: dz to each vertex, followed by the minimum over the vertices
+    std::vector<unsigned char> tkDzDone_; // dz filled on first use
  
 };
 
@@ -1,5 +1,8 @@
 #include "JetAnalysis/interface/JetHandler.h"
 #include "LoopAll.h"
+#include "RootLock.h"
+
+#include <limits>
 
 // ---------------------------------------------------------------------------------------------------------------
 JetHandler::JetHandler(const std::string & cfg, LoopAll & l):
@@ -51,6 +54,8 @@ JetHandler::JetHandler(const std::string & cfg, LoopAll & l):
     jetResponseChange = new JetResponseChange("aux/JetResponseVsEta.root");
     nLumiBins_ = 0;
 
+    tkMapFile_ = tkMapRun_ = tkMapLumi_ = tkMapEvent_ = tkMapNtk_ = tkMapNvtx_ = -1;
+
 }
 
 // ---------------------------------------------------------------------------------------------------------------
@@ -72,6 +77,55 @@ float dz(TLorentzVector * tkp4, TVector3 * tkpos, TVector3 * vtxpos)
 		 ( (tkpos->X()-vtxpos->X())*tkp4->Px() + (tkpos->Y()-vtxpos->Y())*tkp4->Py() )/tkp4->Pt() * tkp4->Pz()/tkp4->Pt() );
 }
 
+// ---------------------------------------------------------------------------------------------------------------
+void JetHandler::buildTrackVertexMap()
+{
+    if( tkMapFile_ == l_.current && tkMapRun_ == l_.run && tkMapLumi_ == l_.lumis && tkMapEvent_ == l_.event && 
+	tkMapNtk_ == l_.tk_n && tkMapNvtx_ == l_.vtx_std_n ) {
+	return;
+    }
+    tkMapFile_  = l_.current;
+    tkMapRun_   = l_.run;
+    tkMapLumi_  = l_.lumis;
+    tkMapEvent_ = l_.event;
+    tkMapNtk_   = l_.tk_n;
+    tkMapNvtx_  = l_.vtx_std_n;
+    
+    tkInVtx_.assign(tkMapNtk_*tkMapNvtx_, 0);
+    tkNVtx_.assign(tkMapNtk_, 0);
+    tkDz_.resize(tkMapNtk_*(tkMapNvtx_+1));
+    tkDzDone_.assign(tkMapNtk_, 0);
+    for(int ivtx=0; ivtx<tkMapNvtx_; ++ivtx) {
+	const std::vector<unsigned short> & ivtx_tracks = (*l_.vtx_std_tkind)[ivtx];
+	for(std::vector<unsigned short>::const_iterator itrack=ivtx_tracks.begin(); itrack!=ivtx_tracks.end(); ++itrack ) {
+	    if( *itrack >= tkMapNtk_ ) { continue; }
+	    unsigned char & inVtx = tkInVtx_[*itrack*tkMapNvtx_+ivtx];
+	    if( ! inVtx ) {
+		inVtx = 1;
+		++tkNVtx_[*itrack];
+	    }
+	}
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+const float * JetHandler::trackDz(int itrack)
+{
+    float * tkdz = &tkDz_[itrack*(tkMapNvtx_+1)];
+    if( ! tkDzDone_[itrack] ) {
+	TVector3 * tkpos= (TVector3 *) l_.tk_vtx_pos->At(itrack);
+	TLorentzVector * tkp4= (TLorentzVector *) l_.tk_p4->At(itrack);
+	float dZmin = std::numeric_limits<float>::max();
+	for(int ivtx=0; ivtx<tkMapNvtx_; ++ivtx) {
+	    tkdz[ivtx] = dz(tkp4, tkpos, (TVector3*)l_.vtx_std_xyz->At(ivtx));
+	    dZmin = std::min(dZmin, tkdz[ivtx]);
+	}
+	tkdz[tkMapNvtx_] = dZmin;
+	tkDzDone_[itrack] = 1;
+    }
+    return tkdz;
+}
+
 // ---------------------------------------------------------------------------------------------------------------
 void JetHandler::computeBetas(int ijet, int vtx)
 {
@@ -89,30 +143,19 @@ void JetHandler::computeBetas(int ijet, int vtx)
     /// std::cout << "JetHandler::computeBetas before " << ijet << " " << vtx << " " << beta << " " << betaStar << " " << betaStarClassic << std::endl;
     beta = 0., betaStar = 0., betaStarClassic = 0.;
 
-    const std::vector<unsigned short> & vtx_tracks = (*l_.vtx_std_tkind)[vtx];
-    TVector3 * vtxpos = (TVector3*)l_.vtx_std_xyz->At(vtx);
+    buildTrackVertexMap();
     
     const std::vector<unsigned short> & jet_tracks = (*l_.jet_algoPF1_tkind)[ijet];
     for(std::vector<unsigned short>::const_iterator itrack=jet_tracks.begin(); itrack!=jet_tracks.end(); ++itrack ) {
-	bool inVtx0 = find( vtx_tracks.begin(),  vtx_tracks.end(), *itrack ) != vtx_tracks.end();
-	bool inAnyOther = false;
+	bool inVtx0 = tkInVtx_[*itrack*tkMapNvtx_+vtx];
+	bool inAnyOther = tkNVtx_[*itrack] > (inVtx0 ? 1 : 0);
 	
-	TVector3 * tkpos= (TVector3 *) l_.tk_vtx_pos->At(*itrack);
 	TLorentzVector * tkp4= (TLorentzVector *) l_.tk_p4->At(*itrack);
 	float tkpt = tkp4->Pt();
 	
-	float dZ0 = dz(tkp4, tkpos, vtxpos);
-	float dZ = dZ0;
-	
-	for(int ivtx=0; ivtx<l_.vtx_std_n; ++ivtx) {
-	    bool isVtx0 = (ivtx == vtx);
-	    if( ! isVtx0 && ! inAnyOther ) {
-		const std::vector<unsigned short> & ivtx_tracks = (*l_.vtx_std_tkind)[ivtx];
-		inAnyOther = find( ivtx_tracks.begin(),  ivtx_tracks.end(), *itrack ) != ivtx_tracks.end();
-	    }
-	    TVector3 * ivtxpos = (TVector3*)l_.vtx_std_xyz->At(ivtx);
-	    dZ = std::min(dZ, dz(tkp4, tkpos, ivtxpos));
-	}
+	const float * tkdz = trackDz(*itrack);
+	float dZ0 = tkdz[vtx];
+	float dZ = tkdz[tkMapNvtx_];
 	
 	sumTkPt += tkpt;
 	if( ! inVtx0 && inAnyOther ) {
@@ -204,6 +247,8 @@ void JetHandler::computeMva(int ijet, int ivtx)
     }
 
     
+    // the MVAs are evaluated through TMVA::Reader
+    R__LOCKGUARD(gRootLock);
     // full->set(internalId_);
     PileupJetIdentifier fullId = full->computeMva();
     (*l_.jet_algoPF1_full_mva_ext)[ijet][ivtx] = fullId.mva();
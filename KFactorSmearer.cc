@@ -49,6 +49,36 @@ bool KFactorSmearer::smearEvent( float & weight, const TLorentzVector & p4, cons
   return true;
 }
 
+bool KFactorSmearer::smearEventShifts( const TLorentzVector & p4, const int nPu, const int sample_type, 
+				       int nshifts, const float * syst_shifts, float * weights ) const
+{
+  int genMassPoint;
+
+  if( sample_type >= 0 ) { return true; }
+  genMassPoint = std::round(norm_->GetMass(sample_type));
+
+  if( norm_->GetProcess(sample_type) != "ggh" ) {
+	  return true;
+  }
+  if( genMassPoint > 150 ) { genMassPoint=150; } // Warning: missing k-factor
+  if( genMassPoint == 100 ) { genMassPoint=105; }  // Warning: missing k-factor
+  
+  assert( genMassPoint % 5 == 0 );
+
+  // the k-factor histograms are looked up once for all the shifts
+  float gPT = p4.Pt();
+  double nominal = getKFactor( genMassPoint, 0, gPT );
+  double up      = getKFactor( genMassPoint, 1, gPT );
+  double down    = getKFactor( genMassPoint, 2, gPT );
+  for(int ishift=0; ishift<nshifts; ++ishift) {
+    double variation = syst_shifts[ishift] > 0 ? up : down;
+    double kWeight = nominal + (variation-nominal) * fabs(syst_shifts[ishift]);
+    weights[ishift] = (kWeight > 0) ? kWeight : 0;
+  }
+
+  return true;
+}
+
 
 bool KFactorSmearer::init() 
 {
@@ -23,6 +23,8 @@ public:
   virtual const std::string & name() const { return name_; };
   
   virtual bool smearEvent( float & weight, const TLorentzVector & p4, const int nPu, const int sample_type, float syst_shift=0. ) const ;
+  virtual bool smearEventShifts( const TLorentzVector & p4, const int nPu, const int sample_type, 
+				 int nshifts, const float * syst_shifts, float * weights ) const;
 
   void name(const std::string & x) { name_ = x; };
 
@@ -7,12 +7,22 @@
 #include <iterator>
 #include <math.h>
 #include <ctime>
+#include <limits>
+#include <algorithm>
 #include "stdlib.h"
 
 using namespace std;
 
 #include "BaseAnalysis.h"
 
+#include "TThread.h"
+#include "TMutex.h"
+#include "RootLock.h"
+#include "TSystem.h"
+#include <typeinfo>
+
+TVirtualMutex * gRootLock = 0;
+
 // ------------------------------------------------------------------------------------
 BaseAnalysis* LoopAll::AddAnalysis(BaseAnalysis* baseAnalysis) {
   
@@ -37,6 +47,7 @@ void LoopAll::SetTypeRun(int t, const char* name) {
   if (makeOutputTree) {
     cout << "CREATE " << outputFileName<<endl;
     outputFile=TFile::Open(outputFileName,"recreate");
+    SetupOutputFile();
     outputFile->cd();
     if(outputFile) 
       if (DEBUG)
@@ -60,6 +71,7 @@ void LoopAll::SetTypeRun(int t, const char* name) {
     for (size_t i=0; i<analyses.size(); i++) {
       analyses[i]->ReducedOutputTree(*this,outputTree);
     }
+    SetupOutputTree();
 
     outputTreePar = new TTree("global_variables","Parameters");
     outputParParameters = new std::vector<std::string>;
@@ -80,6 +92,28 @@ void LoopAll::SetTypeRun(int t, const char* name) {
   outputTreeLumi->Branch("lumis", &lumis, "lumis/I");
 }
 
+// ------------------------------------------------------------------------------------
+void LoopAll::SetupOutputFile() {
+  if( outputFile == 0 ) { return; }
+  if( outputCompressionAlgorithm > 0 ) { 
+    outputFile->SetCompressionAlgorithm(outputCompressionAlgorithm);
+  }
+  if( outputCompressionLevel >= 0 ) { 
+    outputFile->SetCompressionLevel(outputCompressionLevel);
+  }
+}
+
+// ------------------------------------------------------------------------------------
+void LoopAll::SetupOutputTree() {
+  if( outputBasketSize > 0 ) {
+    outputTree->SetBasketSize("*",outputBasketSize);
+  }
+  // the baskets are written out every outputAutoFlush bytes, and resized to the branch contents 
+  //   at the first flush. The tree header is only rewritten at the coarser outputAutoSave interval.
+  outputTree->SetAutoFlush(outputAutoFlush);
+  outputTree->SetAutoSave(outputAutoSave);
+}
+
 // ------------------------------------------------------------------------------------
 void LoopAll::ReadInput(int t) {
   // FIXME make this variable global ?
@@ -95,6 +129,7 @@ void LoopAll::ReadInput(int t) {
   if (makeOutputTree) {
     cout << "CREATE " << outputFileName<<endl;
     outputFile=TFile::Open(outputFileName,"recreate");
+    SetupOutputFile();
     outputFile->cd();
     if(outputFile) 
       if (DEBUG)	cout<<"output file defined"<<endl;
@@ -115,7 +150,7 @@ void LoopAll::ReadInput(int t) {
     for (size_t i=0; i<analyses.size(); i++) {
       analyses[i]->ReducedOutputTree(*this,outputTree);
     }
-    
+    SetupOutputTree();
     
   } 
   outputTreeLumi = new TTree("lumi","Lumi info tree"); 
@@ -193,8 +228,45 @@ void LoopAll::AddFile(std::string name,int type) {
   nfiles++;
 }
 
+// ------------------------------------------------------------------------------------
+namespace {
+  /// file to be merged, opened ahead of the one being merged
+  struct merge_input_t {
+    merge_input_t() : handle(0), file(0), size(0) {};
+    TFileOpenHandle * handle;
+    TFile * file;
+    Long64_t size;
+  };
+}
+
+// ------------------------------------------------------------------------------------
+/// completes the opening of a file started with AsyncOpen and asks for its content to be read in the 
+/// background (by the operating system, or by the server for remote files), without copying it in memory.
+static void readAheadMergeInput(merge_input_t & input) {
+  if( input.handle == 0 ) { 
+    return; 
+  }
+  // opening a file makes it the current directory
+  TDirectory * cwd = gDirectory;
+  input.file = TFile::Open(input.handle);
+  input.handle = 0;
+  if( cwd != 0 ) { cwd->cd(); } else { gROOT->cd(); }
+  if( input.file == 0 ) { 
+    return; 
+  }
+  if( input.file->IsZombie() ) {
+    delete input.file;
+    input.file = 0;
+    return;
+  }
+  Long64_t end = input.file->GetEND();
+  for(Long64_t offset=0; offset<end; offset+=kMaxInt) {
+    input.file->ReadBufferAsync(offset, (Int_t)std::min(end-offset,(Long64_t)kMaxInt));
+  }
+}
+
+// ------------------------------------------------------------------------------------
 void LoopAll::MergeContainers(){
-  int i=0;
   
   if (DEBUG)
     cout<<"LoopAndFillHistos: calling InitReal " << endl;
@@ -204,52 +276,94 @@ void LoopAll::MergeContainers(){
   int numberOfFiles = files.size();  
   Files.resize(numberOfFiles);  
 
-  std::vector<std::string>::iterator it;
-  std::vector<TFile*>::iterator it_file;
-  
-  it = files.begin();
-  it_file = Files.begin();
   // Get names of objects inside RooContainer
   std::vector<std::string> histogramNames = rooContainer->GetTH1FNames();
   std::vector<std::string> datasetNames = rooContainer->GetDataSetNames();
-		
+
+  // while a file is appended, the following ones are opened with AsyncOpen and read ahead, as long as their 
+  // total size stays below prefetchBytes. Appending is always done on this thread and in the order of the files 
+  // list, so that the merged output does not depend on the prefetching.
+  std::vector<merge_input_t> inputs(numberOfFiles);
+  for (int i=0; i<numberOfFiles && prefetchFiles > 0; ++i) {
+    FileStat_t stat;
+    inputs[i].size = ( gSystem->GetPathInfo(files[i].c_str(), stat) == 0 ? stat.fSize : prefetchBytes );
+  }
+  int nstarted = 0;
+  Long64_t ahead = 0;
+  
   // Loop Over the files and get the relevant pieces to Merge:
-  for (;it!=files.end()
-	 ;it_file++,it++){
+  for (int i=0; i<numberOfFiles; ++i) {
+    
+    TFile * file = 0;
+    if( i < nstarted ) {
+      readAheadMergeInput(inputs[i]);
+      file = inputs[i].file;
+      inputs[i].file = 0;
+      ahead -= inputs[i].size;
+    } else {
+      nstarted = i+1;
+    }
+    if( file == 0 ) {
+      file = TFile::Open(files[i].c_str());
+    }
+    if( file == 0 ){
+      std::cerr << "Error opening file " << files[i] << std::endl;
+      exit(H2GG_ERR_FILEOP);
+    }
     
-	  *it_file = TFile::Open((*it).c_str());
-    (*it_file)->cd();
-    std::cout << "Combining Current File " << i << " / " << numberOfFiles << " - " << (*it) << std::endl;
+    for( ; prefetchFiles > 0 && nstarted<numberOfFiles && ahead+inputs[nstarted].size <= prefetchBytes; ++nstarted ) {
+      inputs[nstarted].handle = TFile::AsyncOpen(files[nstarted].c_str());
+      ahead += inputs[nstarted].size;
+    }
+    if( i+1 < nstarted ) {
+      readAheadMergeInput(inputs[i+1]);
+    }
+
+    Files[i] = file;
+    file->cd();
+    std::cout << "Combining Current File " << i << " / " << numberOfFiles << " - " << files[i] << std::endl;
 
     for (std::vector<std::string>::iterator it_hist=histogramNames.begin()
 	   ;it_hist!=histogramNames.end()
 	   ;it_hist++) {
 			
-      TH1F *histExtra = (TH1F*) (*it_file)->Get(Form("th1f_%s",it_hist->c_str()));
+      TH1F *histExtra = (TH1F*) file->Get(Form("th1f_%s",it_hist->c_str()));
       rooContainer->AppendTH1F(*it_hist,histExtra);	
-      //delete histExtra;
-    }
-		
-    RooWorkspace *work = (RooWorkspace*) (*it_file)->Get("cms_hgg_workspace");
-    for (std::vector<std::string>::iterator it_data=datasetNames.begin()
-	   ;it_data!=datasetNames.end()
-	   ;it_data++) {
-
-      RooDataSet *dataExtra = (RooDataSet*) work->data(Form("%s",it_data->c_str()));
-      if( dataExtra == 0 ) {
-	      std::cout << "skipping "<< it_data->c_str() << " " << dataExtra << std::endl;
-	      continue;
+    }
+    
+    // datasets saved as separate keys are read one by one, without deserialising the workspace
+    TDirectory * datasetDir = ( datasetNames.empty() ? 0 : file->GetDirectory("cms_hgg_datasets") );
+    if( datasetDir != 0 ) {
+      for (std::vector<std::string>::iterator it_data=datasetNames.begin()
+	     ;it_data!=datasetNames.end()
+	     ;it_data++) {
+
+	RooDataSet *dataExtra = (RooDataSet*) datasetDir->Get(it_data->c_str());
+	if( dataExtra == 0 ) {
+	  std::cout << "skipping "<< it_data->c_str() << " " << dataExtra << std::endl;
+	  continue;
+	}
+	rooContainer->AppendDataSet(*it_data,dataExtra);	
+	delete dataExtra;
+      }
+    } else if( ! datasetNames.empty() ) {
+      // older files only have the workspace
+      RooWorkspace *work = (RooWorkspace*) file->Get("cms_hgg_workspace");
+      for (std::vector<std::string>::iterator it_data=datasetNames.begin()
+	     ;it_data!=datasetNames.end()
+	     ;it_data++) {
+
+	RooDataSet *dataExtra = (RooDataSet*) work->data(Form("%s",it_data->c_str()));
+	if( dataExtra == 0 ) {
+	  std::cout << "skipping "<< it_data->c_str() << " " << dataExtra << std::endl;
+	  continue;
+	}
+	rooContainer->AppendDataSet(*it_data,dataExtra);	
       }
-      rooContainer->AppendDataSet(*it_data,dataExtra);	
-      //delete dataExtra;
+      delete work;
     }
 
-    delete work;
-    //std::cout << "Finished Combining File - " << (*it) << std::endl;
-
-    (*it_file)->Close();
-    i++;
-    //delete tmpFile;			
+    file->Close();
   } 
   TermReal(typerun);
   Term();
@@ -301,18 +415,8 @@ void LoopAll::LoopAndFillHistos(TString treename) {
 
     cout<<"LoopAndFillHistos: opening file " << i+1 << " / " << numberOfFiles << " : " << files[i]<<endl;
     
-    for(int itry=0; itry<3; ++itry) {
-	    *it_file = TFile::Open((*it).c_str(),"TIMEOUT=60");
-	    if( *it_file == 0 ){
-		    std::cerr << "Error opening file " << (*it).c_str() << " attempt " << itry << std::endl;
-	    } else {
-		    break;
-	    }
-    }
-    if( *it_file == 0 ){
-	    std::cerr << "Error opening file " << (*it).c_str() << std::endl;
-	    exit(H2GG_ERR_FILEOP);
-    }
+    *it_file = OpenInputFile(i);
+    PrefetchInputFiles(i+1);
     
     //Files[i] = TFile::Open(files[i]);
     tot_events=1;
@@ -381,6 +485,8 @@ void LoopAll::LoopAndFillHistos(TString treename) {
         (*it_file)->Close();
   }
   
+  ClearPrefetchedFiles();
+
   TermReal(typerun);
   Term();
   
@@ -389,6 +495,57 @@ void LoopAll::LoopAndFillHistos(TString treename) {
     Files[0]->Close();
 }
 
+// ------------------------------------------------------------------------------------
+TFile * LoopAll::OpenInputFile(int i) {
+  TFile * file = 0;
+  std::map<int, TFileOpenHandle *>::iterator it = prefetchedFiles.find(i);
+  if( it != prefetchedFiles.end() ) {
+    // the open was started by PrefetchInputFiles: this waits for it to be completed
+    file = TFile::Open(it->second);
+    prefetchedFiles.erase(it);
+  }
+  
+  for(int itry=0; itry<3 && file == 0; ++itry) {
+    file = TFile::Open(files[i].c_str(),"TIMEOUT=60");
+    if( file == 0 ){
+      std::cerr << "Error opening file " << files[i] << " attempt " << itry << std::endl;
+    }
+  }
+  if( file == 0 ){
+    std::cerr << "Error opening file " << files[i] << std::endl;
+    exit(H2GG_ERR_FILEOP);
+  }
+  return file;
+}
+
+// ------------------------------------------------------------------------------------
+void LoopAll::PrefetchInputFiles(int first) {
+  if( prefetchFiles <= 0 ) { 
+    return; 
+  }
+  // the files are opened asynchronously by ROOT itself, without any I/O done here: 
+  // the TFile objects are only created in OpenInputFile, from the main thread
+  for(int i=first; i<first+prefetchFiles && i<(int)files.size(); ++i) {
+    if( prefetchedFiles.find(i) != prefetchedFiles.end() ) { continue; }
+    TFileOpenHandle * handle = TFile::AsyncOpen(files[i].c_str());
+    if( handle != 0 ) { 
+      prefetchedFiles[i] = handle;
+    }
+  }
+}
+
+// ------------------------------------------------------------------------------------
+void LoopAll::ClearPrefetchedFiles() {
+  for(std::map<int, TFileOpenHandle *>::iterator it=prefetchedFiles.begin(); it!=prefetchedFiles.end(); ++it) {
+    TFile * file = TFile::Open(it->second);
+    if( file != 0 ) { 
+      file->Close(); 
+      delete file;
+    }
+  }
+  prefetchedFiles.clear();
+}
+
 // ------------------------------------------------------------------------------------
 void LoopAll::StoreProcessedLumis(TTree * tree){
   tree->SetBranchAddress("run",&run);
@@ -413,7 +570,8 @@ void LoopAll::Term(){
 
 // ------------------------------------------------------------------------------------
 LoopAll::LoopAll(TTree *tree) :
-	counters(4,0.), countersred(4,0.), checkBench(0), sqrtS(8)
+	counters(4,0.), countersred(4,0.), checkBench(0), sqrtS(8), nThreads(1), workerId(0), prefetchFiles(0), prefetchCacheSize(30000000), prefetchBytes(1000000000), checkCompiledMvas(0), cutsCompiled(false),
+	diphoMvaMemoHits(0), diphoMvaMemoMisses(0)
 {  
 #include "branchdef/newclonesarray.h"
 
@@ -430,6 +588,12 @@ LoopAll::LoopAll(TTree *tree) :
   // Best Set Global parameters accesible via python to defauls
   
   funcReader_dipho_MIT = 0;
+
+  outputCompressionAlgorithm = 0;
+  outputCompressionLevel = -1;
+  outputAutoFlush = -30000000;
+  outputAutoSave = -300000000;
+  outputBasketSize = 0;
   /// signalNormalizer->FillSignalTypes();
 
   runZeeValidation = false;
@@ -439,6 +603,9 @@ LoopAll::LoopAll(TTree *tree) :
   pfisoOffset=2.5;
   cicVersion="7TeV";
   pho_r9_cic = &pho_r9[0];
+
+  metCorrEvent_ = metCorrLumi_ = metCorrRun_ = -1;
+  metCorrIsMC_ = false;
 }
 
 // ------------------------------------------------------------------------------------
@@ -527,10 +694,20 @@ void LoopAll::InitReal(Int_t typerunpass) {
   //  histoContainer.push_back(temp);
   // }
 
+  if( nThreads > 1 && workers.empty() ) {
+    CreateWorkers();
+  }
+
   if(LDEBUG) cout << "doing InitRealPhotonAnalysis" << endl;
   for (size_t i=0; i<analyses.size(); i++) {
     analyses[i]->Init(*this);
   }
+  for (size_t iw=0; iw<workers.size(); iw++) {
+    workers[iw]->signalNormalizer = signalNormalizer;
+    for (size_t i=0; i<workers[iw]->analyses.size(); i++) {
+      workers[iw]->analyses[i]->Init(*workers[iw]);
+    }
+  }
   
   if(LDEBUG) cout << "finished InitRealPhotonAnalysis" << endl;
 
@@ -548,6 +725,13 @@ void LoopAll::TermReal(Int_t typerunpass) {
 
   typerun=typerunpass;
 
+  MergeWorkers();
+
+  if( diphoMvaMemoHits + diphoMvaMemoMisses > 0 ) {
+    std::cout << "LoopAll::TermReal: diphoton MVA evaluations " << diphoMvaMemoMisses 
+	      << ", reused for identical inputs " << diphoMvaMemoHits << std::endl;
+  }
+
   for (size_t i=0; i<analyses.size(); i++) {
     analyses[i]->Term(*this);
   }
@@ -590,6 +774,14 @@ void LoopAll::Init(Int_t typerunpass, TTree *tree) {
   }
   SetBranchAddresses(inputBranchNames);
   
+  // the baskets of the branches read are fetched in blocks through the TTreeCache of the tree
+  if( prefetchFiles > 0 && prefetchCacheSize > 0 ) {
+    fChain->SetCacheSize(prefetchCacheSize);
+    for(std::set<TBranch *>::iterator ib=inputBranches.begin(); ib!=inputBranches.end(); ++ib) {
+      fChain->AddBranchToCache(*ib, kTRUE);
+    }
+    fChain->StopCacheLearningPhase();
+  }
 
   Notify();
 }
@@ -642,11 +834,8 @@ void LoopAll::Loop(Int_t a) {
     nentries = Int_t(fChain->GetEntriesFast());
 
 
-  Int_t nbytes = 0, nb = 0;
-
   outputEvents=0;
 
-  int hasoutputfile=0;
   // Call the Reset Analysis at start of new file
   for (size_t i=0; i<analyses.size(); i++) {
     analyses[i]->ResetAnalysis(); 
@@ -684,49 +873,10 @@ void LoopAll::Loop(Int_t a) {
   if(checkBench > 0) {
 	  stopWatch.Start();
   }
-  for (Int_t jentry=0; jentry<nentries;jentry++) {
-    
-    if(jentry%10000==0) {
-      cout << "Entry: "<<jentry << " / "<<nentries <<  " "  ;
-      copy(countersred.begin(), countersred.end(), std::ostream_iterator<float>(cout, "_") );
-      cout << endl;
-    }
-    if(makeDummyTrees) continue;
-    
-    if(checkBench > 0 && jentry%checkBench == 0 ) {
-	    stopWatch.Stop();
-	    float cputime  = stopWatch.CpuTime();
-	    float realtime = stopWatch.RealTime();
-	    stopWatch.Start(false);
-	    if( realtime > benchStart*60. && cputime / realtime < benchThr ) {
-		    std::cout << 
-			    "\n\n\n\nAbourting exection.\n"
-			    "Sorry: too inefficient to continue (cputime " << cputime << " realtime " << realtime << ")" 
-			      << std::endl;
-		    exit(H2GG_ERR_DUTYC);
-	    }
-    }
-
-    if(LDEBUG) 
-      cout<<"call LoadTree"<<endl;
-    
-    Int_t ientry = LoadTree(jentry);
-  
-    if (ientry < 0) 
-      break;
-    
-    if(typerun == kFill ) {
-      nb=0;
-    }
-
-    nbytes += nb;
-
-    if(LDEBUG) 
-      cout<<"Call FillandReduce "<<endl;
-      
-    hasoutputfile = this->FillAndReduce(jentry);
-    if(LDEBUG) 
-      cout<<"Called FillandReduce "<<endl;
+  if( ! workers.empty() ) {
+    LoopParallel(a, nentries);
+  } else {
+    LoopEntries(0, nentries, nentries);
   }
   tfileend = time(0);
   std::cout << "Average time per event: " << (float) difftime(tfileend,tfilestart)/nentries << std::endl;
@@ -796,6 +946,287 @@ void LoopAll::Loop(Int_t a) {
 
 }
 
+// ------------------------------------------------------------------------------------
+void LoopAll::LoopEntries(Int_t first, Int_t last, Int_t nentries) {
+
+  Int_t nbytes = 0, nb = 0;
+  int hasoutputfile=0;
+
+  for (Int_t jentry=first; jentry<last;jentry++) {
+    
+    if(jentry%10000==0 && workerId == 0) {
+      cout << "Entry: "<<jentry << " / "<<nentries <<  " "  ;
+      copy(countersred.begin(), countersred.end(), std::ostream_iterator<float>(cout, "_") );
+      cout << endl;
+    }
+    if(makeDummyTrees) continue;
+    
+    if(checkBench > 0 && jentry%checkBench == 0 ) {
+	    stopWatch.Stop();
+	    float cputime  = stopWatch.CpuTime();
+	    float realtime = stopWatch.RealTime();
+	    stopWatch.Start(false);
+	    if( realtime > benchStart*60. && cputime / realtime < benchThr*(workers.size()+1) ) {
+		    std::cout << 
+			    "\n\n\n\nAbourting exection.\n"
+			    "Sorry: too inefficient to continue (cputime " << cputime << " realtime " << realtime << ")" 
+			      << std::endl;
+		    exit(H2GG_ERR_DUTYC);
+	    }
+    }
+
+    if(LDEBUG) 
+      cout<<"call LoadTree"<<endl;
+    
+    Int_t ientry = LoadTree(jentry);
+  
+    if (ientry < 0) 
+      break;
+    
+    if(typerun == kFill ) {
+      nb=0;
+    }
+
+    nbytes += nb;
+
+    if(LDEBUG) 
+      cout<<"Call FillandReduce "<<endl;
+      
+    hasoutputfile = this->FillAndReduce(jentry);
+    if(LDEBUG) 
+      cout<<"Called FillandReduce "<<endl;
+  }
+}
+
+// ------------------------------------------------------------------------------------
+struct LoopAllWorkerTask {
+  LoopAll * worker;
+  Int_t first, last, nentries;
+};
+
+static void * runLoopAllWorker(void * arg) {
+  LoopAllWorkerTask * task = (LoopAllWorkerTask *)arg;
+  task->worker->LoopEntries(task->first, task->last, task->nentries);
+  return 0;
+}
+
+// ------------------------------------------------------------------------------------
+LoopAll * LoopAll::MakeWorker(int id) {
+
+  // the worker is a copy of this instance, so that it gets all the settings read from the datacards.
+  // Workers are made before the analyses are initialized and before any input is read: the histogram, 
+  // counter and cut containers only hold the bookings at this stage, and copying them books the same 
+  // empty histograms and counters in the worker.
+  LoopAll * worker = new LoopAll(*this);
+  worker->workerId = id;
+  worker->nThreads = 1;
+  worker->workers.clear();
+  worker->analyses.clear();
+  worker->outputTextFileName = worker->WorkerFileName(outputTextFileName);
+
+  // what each instance owns is set up again for the worker: branch buffers and dictionary
+  worker->fChain = 0;
+  worker->inputBranches.clear();
+  worker->InitWorkerBranches();
+  worker->pho_r9_cic = &(worker->pho_r9[0]);
+  for(size_t ii=0; ii<worker->sampleContainer.size(); ++ii) {
+    if( sampleContainer[ii].extWeight() != 0 ) { worker->sampleContainer[ii].setExtWeight(&worker->weight); }
+  }
+  worker->cutsCompiled = false;
+  worker->counters.assign(counters.size(),0.);
+  worker->countersred.assign(countersred.size(),0.);
+
+  // results are only written by the main instance, and input files are only prefetched by it
+  worker->makeOutputTree = 0;
+  worker->outputFile = 0;
+  worker->outputTree = 0;
+  worker->outputTreeLumi = 0;
+  worker->outputTreePar = 0;
+  worker->plotvartree = 0;
+  worker->inputfiletree = 0;
+  worker->hfile = 0;
+  worker->Trees.clear();
+  worker->LumiTrees.clear();
+  worker->Files.clear();
+  worker->TreesPar.clear();
+  worker->configFiles.clear();
+  worker->globalHistos.clear();
+  worker->prefetchFiles = 0;
+  worker->prefetchedFiles.clear();
+
+  // MVA readers and fit models are booked by the analyses of the worker, against the worker buffers
+  worker->rooContainer = new RooContainer();
+  worker->rooContainer->BlindData();
+  worker->funcReader_dipho_MIT = 0;
+  worker->tmvaReaderID_UCSD = 0, worker->tmvaReader_dipho_UCSD = 0;
+  worker->tmvaReaderID_MIT_Barrel = 0, worker->tmvaReaderID_MIT_Endcap = 0;
+  worker->tmvaReader_dipho_MIT = 0;
+  worker->tmvaReaderID_Single_Barrel = 0, worker->tmvaReaderID_Single_Endcap = 0;
+  worker->tmvaReaderID_2013_Barrel = 0, worker->tmvaReaderID_2013_Endcap = 0;
+  worker->compiledMvas_.clear();
+  worker->tmva_dipho_MIT_cache.clear();
+  worker->diphoMvaMemo_.clear();
+  worker->diphoMvaMemoHits = 0, worker->diphoMvaMemoMisses = 0;
+
+  // per-event caches
+  worker->pfCandIndex_.valid = false, worker->trackIndex_.valid = false;
+  worker->metCorrEvent_ = worker->metCorrLumi_ = worker->metCorrRun_ = -1;
+
+  return worker;
+}
+
+// ------------------------------------------------------------------------------------
+std::string LoopAll::WorkerFileName(const std::string & name) const {
+  if( workerId == 0 ) { return name; }
+  return Form("%s.worker%d", name.c_str(), workerId);
+}
+
+// ------------------------------------------------------------------------------------
+void LoopAll::InitWorkerBranches() {
+
+  // the copy still points to the buffers and branches of the instance it was made from
+#include "branchdef/newclonesarray.h"
+  
+  bool cic = runCiC;
+  branchDict.clear();
+#ifndef __CINT__
+#include "branchdef/branchdict.h"
+  DefineUserBranches();
+#endif
+  runCiC = cic;
+}
+
+// ------------------------------------------------------------------------------------
+bool LoopAll::CreateWorkers() {
+
+  if( typerun != kFill ) {
+    std::cout << "LoopAll::CreateWorkers: multi-threaded running only supported in the analysis step. Using one thread." << std::endl;
+    return false;
+  }
+  if( ! treeContainer.empty() ) {
+    std::cout << "LoopAll::CreateWorkers: flat trees cannot be filled by multiple threads. Using one thread." << std::endl;
+    return false;
+  }
+  
+  // analyses are cloned before being initialized, so that every clone sets itself up against its own LoopAll
+  std::vector<std::vector<BaseAnalysis *> > clones(nThreads-1);
+  bool clonable = true;
+  for(int iw=0; iw<nThreads-1 && clonable; ++iw) {
+    for (size_t i=0; i<analyses.size(); i++) {
+      BaseAnalysis * clone = analyses[i]->Clone();
+      if( clone == 0 || typeid(*clone) != typeid(*(analyses[i])) ) {
+	std::cout << "LoopAll::CreateWorkers: analysis " << analyses[i]->name() << " cannot be cloned. Using one thread." << std::endl;
+	if( clone != 0 ) { delete clone; }
+	clonable = false;
+	break;
+      }
+      clones[iw].push_back(clone);
+    }
+  }
+  if( ! clonable ) {
+    for(size_t iw=0; iw<clones.size(); ++iw) {
+      for(size_t i=0; i<clones[iw].size(); ++i) { delete clones[iw][i]; }
+    }
+    return false;
+  }
+
+  TThread::Initialize();
+  if( gRootLock == 0 ) { gRootLock = new TMutex(kTRUE); }
+  for(int iw=0; iw<nThreads-1; ++iw) {
+    LoopAll * worker = MakeWorker(iw+1);
+    for(size_t i=0; i<clones[iw].size(); ++i) {
+      worker->AddAnalysis(clones[iw][i]);
+    }
+    workers.push_back(worker);
+  }
+  std::cout << "LoopAll::CreateWorkers: running with " << nThreads << " threads" << std::endl;
+  
+  return true;
+}
+
+// ------------------------------------------------------------------------------------
+void LoopAll::LoopParallel(Int_t a, Int_t nentries) {
+  
+  int nworkers = workers.size();
+  std::vector<TFile *> workerFiles(nworkers,(TFile*)0);
+  std::vector<LoopAllWorkerTask> tasks(nworkers);
+  std::vector<TThread *> threads(nworkers,(TThread*)0);
+
+  // fixed splitting of the entries: the results do not depend on the thread scheduling
+  Int_t chunk = nentries / (nworkers+1);
+  
+  for(int iw=0; iw<nworkers; ++iw) {
+    LoopAll * worker = workers[iw];
+    for(int itry=0; itry<3 && workerFiles[iw] == 0; ++itry) {
+      workerFiles[iw] = TFile::Open(files[a].c_str(),"TIMEOUT=60");
+    }
+    if( workerFiles[iw] == 0 ){
+      std::cerr << "Error opening file " << files[a] << " in worker " << worker->workerId << std::endl;
+      exit(H2GG_ERR_FILEOP);
+    }
+    worker->current = current;
+    worker->current_sample_index = current_sample_index;
+    worker->tot_events = tot_events;
+    worker->sel_events = sel_events;
+    worker->type = type;
+    worker->version = version;
+    worker->reductions = reductions;
+    worker->countersred.assign(countersred.size(),0.);
+    worker->Init(typerun, (TTree*)workerFiles[iw]->Get(fChain->GetName()));
+    for (size_t i=0; i<worker->analyses.size(); i++) {
+      worker->analyses[i]->ResetAnalysis(); 
+    }
+    
+    tasks[iw].worker = worker;
+    tasks[iw].first = (iw+1)*chunk;
+    tasks[iw].last = ( iw == nworkers-1 ? nentries : (iw+2)*chunk );
+    tasks[iw].nentries = nentries;
+    threads[iw] = new TThread(Form("LoopAll_worker%d",worker->workerId), runLoopAllWorker, (void*)&tasks[iw]);
+    threads[iw]->Run();
+  }
+  
+  LoopEntries(0, chunk, nentries);
+
+  for(int iw=0; iw<nworkers; ++iw) {
+    threads[iw]->Join();
+    delete threads[iw];
+    for(size_t ic=0; ic<countersred.size(); ++ic) {
+      countersred[ic] += workers[iw]->countersred[ic];
+    }
+    for (size_t i=0; i<analyses.size(); i++) {
+      analyses[i]->MergeCloneOutput(*(workers[iw]->analyses[i]));
+    }
+    workers[iw]->fChain = 0;
+    workerFiles[iw]->Close();
+    delete workerFiles[iw];
+  }
+}
+
+// ------------------------------------------------------------------------------------
+void LoopAll::MergeWorkers() {
+  
+  // merge in a fixed order to get reproducible results
+  for(size_t iw=0; iw<workers.size(); ++iw) {
+    LoopAll * worker = workers[iw];
+    for(size_t ind=0; ind<histoContainer.size(); ++ind) {
+      histoContainer[ind].Merge(worker->histoContainer[ind]);
+    }
+    for(size_t ind=0; ind<counterContainer.size(); ++ind) {
+      counterContainer[ind].Merge(worker->counterContainer[ind]);
+    }
+    rooContainer->Merge(*(worker->rooContainer));
+    diphoMvaMemoHits += worker->diphoMvaMemoHits;
+    diphoMvaMemoMisses += worker->diphoMvaMemoMisses;
+    for (size_t i=0; i<analyses.size(); i++) {
+      analyses[i]->MergeClone(*(worker->analyses[i]));
+      delete worker->analyses[i];
+    }
+    delete worker->rooContainer;
+    delete worker;
+  }
+  workers.clear();
+}
+
 // ------------------------------------------------------------------------------------
 void LoopAll::WriteFits() {
   
@@ -1072,6 +1503,10 @@ int LoopAll::FillAndReduce(int jentry) {
   //count all events
   countersred[0]++;
 
+  // isolation indexes and MVA outputs refer to the previous entry
+  pfCandIndex_.valid = false, trackIndex_.valid = false;
+  diphoMvaMemo_.clear();
+
   //
   // read all inputs 
   //
@@ -1114,18 +1549,13 @@ int LoopAll::FillAndReduce(int jentry) {
       }
     }
 
-    // fill output tree
+    // fill output tree; flushing and checkpointing are driven by outputAutoFlush and outputAutoSave
     outputEvents++;
     if(LDEBUG) 
       cout<<"before fill"<<endl;
     outputTree->Fill();
     if(LDEBUG) 
       cout<<"after fill"<<endl;
-    // flush the output tree
-    if(outputEvents==100) {
-      outputEvents=0;
-      outputTree->Write(0,TObject::kWriteDelete);
-    }
 
   }
 
@@ -1219,13 +1649,16 @@ void LoopAll::GetEntry(std::set<TBranch *> & branches, int jentry)
   }
 }
 // ------------------------------------------------------------------------------------
-void LoopAll::BookTreeBranch(std::string name, int type, std::string dirName){
+void * LoopAll::BookTreeBranch(std::string name, int type, std::string dirName){
+  // only one sample is filled at a time: the trees of all the samples share the same value
+  void * address = 0;
   for(unsigned int ind=0; ind<treeContainer[dirName].size(); ind++) {
-    treeContainer[dirName][ind].AddTreeBranch(name,type);
+    address = treeContainer[dirName][ind].AddTreeBranch(name,type,address);
   }
+  return address;
 }
 // ------------------------------------------------------------------------------------
-void LoopAll::BookHisto(int h2d,
+int LoopAll::BookHisto(int h2d,
 			int typplot,
 			int typeplotall,
 			int histoncat,
@@ -1239,12 +1672,22 @@ void LoopAll::BookHisto(int h2d,
 			const char *xaxis, 
 			const char* yaxis) {
 
+  // the cut plots handles are resolved when the cuts are compiled
+  cutsCompiled = false;
+  int handle = -1;
   for(unsigned int ind=0; ind<histoContainer.size(); ind++) {
     if (nbinsy == 0)
-      histoContainer[ind].Add(const_cast<char*>(name), const_cast<char*>(xaxis), const_cast<char*>(yaxis), histoncat, nbinsx, lowlim, highlim);
+      handle = histoContainer[ind].Add(const_cast<char*>(name), const_cast<char*>(xaxis), const_cast<char*>(yaxis), histoncat, nbinsx, lowlim, highlim);
     if (nbinsy != 0)
-      histoContainer[ind].Add(const_cast<char*>(name), const_cast<char*>(xaxis), const_cast<char*>(yaxis), histoncat, nbinsx, lowlim, highlim, nbinsy, lowlim2, highlim2);
+      handle = histoContainer[ind].Add(const_cast<char*>(name), const_cast<char*>(xaxis), const_cast<char*>(yaxis), histoncat, nbinsx, lowlim, highlim, nbinsy, lowlim2, highlim2);
   }
+  return handle;
+}
+
+// ------------------------------------------------------------------------------------
+int LoopAll::HistoHandle(const std::string & name) {
+  if( histoContainer.empty() ) { return -1; }
+  return histoContainer.back().handle(name);
 }
 
 // ------------------------------------------------------------------------------------
@@ -1272,6 +1715,8 @@ void LoopAll::AddCut(char *cutnamesc, int ncatstmp, int ifromright, int ifinalcu
   }
   if(LDEBUG) cout<<"push back cut  "<<endl;
   cutContainer.push_back(*this_cut);
+  delete this_cut;
+  cutsCompiled = false;
   if(LDEBUG) cout<<"pushed back cut  "<<endl;
   if(LDEBUG) cout<<"InitCuts END"<<endl;
 }
@@ -1283,9 +1728,66 @@ void LoopAll::InitCounters(){
   for(unsigned int i=0; i<sampleContainer.size(); i++)
     counterContainer.push_back(CounterContainer(i));
 
+  // configProducer adds the cuts after this: they are compiled on first use
+  cutsCompiled = false;
+
   if(LDEBUG) cout<<"InitCounts END"<<endl;
 }
 
+// ------------------------------------------------------------------------------------
+void LoopAll::CompileCuts() {
+  const float inf = std::numeric_limits<float>::infinity();
+  compiledCuts.clear();
+  cutLow.clear();
+  cutHigh.clear();
+  cutIndex.clear();
+  cutSets.clear();
+
+  for (unsigned int i=0; i<cutContainer.size(); i++) {
+    Cut & cut = cutContainer[i];
+    // the first cut with a given name is the one found by name
+    cutIndex.insert(std::make_pair(cut.name, (int)i));
+
+    compiled_cut_t compiled;
+    compiled.var = cut.mycutvar;
+    compiled.ncat = cut.ncat;
+    compiled.first = cutLow.size();
+    compiled.nminus1Name = cut.name+"_nminus1";
+    compiled.sequentialName = cut.name+"_sequential";
+    compiled.nminus1Histo = HistoHandle(compiled.nminus1Name);
+    compiled.sequentialHisto = HistoHandle(compiled.sequentialName);
+    if(cut.fromright==2) {
+      cutLow.insert(cutLow.end(), cut.cutintervall.begin(), cut.cutintervall.end());
+      cutHigh.insert(cutHigh.end(), cut.cutintervalh.begin(), cut.cutintervalh.end());
+    } else if(cut.fromright==1) {
+      cutLow.insert(cutLow.end(), cut.cut.size(), -inf);
+      cutHigh.insert(cutHigh.end(), cut.cut.begin(), cut.cut.end());
+    } else if(cut.fromright==0) {
+      cutLow.insert(cutLow.end(), cut.cut.begin(), cut.cut.end());
+      cutHigh.insert(cutHigh.end(), cut.cut.size(), inf);
+    } else {
+      compiled.first = -1;
+    }
+    compiledCuts.push_back(compiled);
+
+    cut_set_t & set = cutSets[cut.finalcut];
+    if( set.cuts.empty() ) { set.consistent = true; }
+    for(size_t j=0; j<set.cuts.size(); ++j) {
+      int ncat = cutContainer[set.cuts[j]].ncat;
+      if( cut.ncat>1 && ncat>1 && ncat!=cut.ncat ) { set.consistent = false; }
+    }
+    set.cuts.push_back(i);
+  }
+  cutsCompiled = true;
+}
+
+// ------------------------------------------------------------------------------------
+int LoopAll::CutIndex(const std::string & cutname) {
+  if( ! cutsCompiled ) { CompileCuts(); }
+  std::map<std::string,int>::const_iterator it = cutIndex.find(cutname);
+  return ( it == cutIndex.end() ? -1 : it->second );
+}
+
 /////// ------------------------------------------------------------------------------------
 /////void LoopAll::AddCounter(int countersncat,
 /////			 char *countername,
@@ -1361,28 +1863,20 @@ void LoopAll::AddCounter(int countersncat,
 // ------------------------------------------------------------------------------------
 int LoopAll::ApplyCut(int icut, float var, int icat) {
   
-  //returns 0 if not initialized
-  //MARCO if(cutContainer[icut].useit==0) return 1;
-  if(cutContainer[icut].ncat<2)icat=0;
+  if( ! cutsCompiled ) { CompileCuts(); }
+  const compiled_cut_t & cut = compiledCuts[icut];
+  if( cut.first < 0 ) return 1;
+  if( cut.ncat<2 ) icat=0;
   
-  if(cutContainer[icut].fromright==2) {
-    if(var<cutContainer[icut].cutintervall[icat] || var>cutContainer[icut].cutintervalh[icat]) return 0;
-  }
-  else if (cutContainer[icut].fromright==1) {
-    if(var>cutContainer[icut].cut[icat]) return 0;
-  }
-  else if (cutContainer[icut].fromright==0) {
-    if(var<cutContainer[icut].cut[icat]) return 0;
-  }
+  if(var<cutLow[cut.first+icat] || var>cutHigh[cut.first+icat]) return 0;
   return 1;
 }
 
 // ------------------------------------------------------------------------------------
 int LoopAll::ApplyCut(std::string cutname, float var, int icat) {
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].name == cutname) {
-      return ApplyCut(i, var, icat);
-    }
+  int icut = CutIndex(cutname);
+  if( icut >= 0 ) {
+    return ApplyCut(icut, var, icat);
   }
 
   std::cout<<"ApplyCut: attention cutname "<<cutname<<" not found"<<std::endl;
@@ -1452,13 +1946,23 @@ void LoopAll::FillHist2D(std::string name, float x, float y) {
 
 // ------------------------------------------------------------------------------------
 void LoopAll::FillHist(std::string name, int category, float y, float wt ) {
-  histoContainer[current_sample_index].Fill(name, category, y, wt);
-  histoContainer.back().Fill(name, category, y, wt);
+  FillHist(HistoHandle(name), category, y, wt);
 }
 // ------------------------------------------------------------------------------------
 void LoopAll::FillHist2D(std::string name, int category, float x, float y, float wt ) {
-  histoContainer[current_sample_index].Fill2D(name, category, x, y, wt);
-  histoContainer.back().Fill2D(name, category, x, y, wt);
+  FillHist2D(HistoHandle(name), category, x, y, wt);
+}
+
+// ------------------------------------------------------------------------------------
+// all the containers are booked in the same order, so the handles are shared among them
+void LoopAll::FillHist(int handle, int category, float y, float wt ) {
+  histoContainer[current_sample_index].Fill(handle, category, y, wt);
+  histoContainer.back().Fill(handle, category, y, wt);
+}
+// ------------------------------------------------------------------------------------
+void LoopAll::FillHist2D(int handle, int category, float x, float y, float wt ) {
+  histoContainer[current_sample_index].Fill2D(handle, category, x, y, wt);
+  histoContainer.back().Fill2D(handle, category, x, y, wt);
 }
 
 // ------------------------------------------------------------------------------------
@@ -1483,14 +1987,7 @@ bool LoopAll::CheckLumiSelection( int run, int lumi )
     return true;
   }
 
-  std::vector<std::pair<int,int> > &run_lumis = sampleContainer[current_sample_index].goodLumis[run];
-  for(std::vector<std::pair<int,int> >::iterator it=
-	run_lumis.begin(); it!=run_lumis.end(); ++it ) {
-    if( lumi >= it->first && lumi <= it->second ) {
-      return true;
-    }
-  }
-  return false;
+  return sampleContainer[current_sample_index].isGoodLumi(run,lumi);
 }
 
 // ----------------------------------------------------------------------------------------------------------------------
@@ -1500,14 +1997,7 @@ bool LoopAll::CheckEventList( int run, int lumi, int event  )
     return true;
   }
 
-  std::vector<std::pair<int,int> > &run_events = sampleContainer[current_sample_index].eventList[run];
-  for(std::vector<std::pair<int,int> >::iterator it=
-	run_events.begin(); it!=run_events.end(); ++it ) {
-    if( lumi == it->first && event == it->second ) {
-      return true;
-    }
-  }
-  return false;
+  return sampleContainer[current_sample_index].isInEventList(run,lumi,event);
 }
 
 
@@ -1524,18 +2014,17 @@ Normalization_8TeV * LoopAll::normalizer()
 
 // ----------------------------------------------------------------------------------------------------------------------
 float LoopAll::GetCutValue(TString cutname, int icat, int highcut) {
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].name == cutname) {
-      if(cutContainer[i].ncat<2) icat=0;
-      if(cutContainer[i].fromright==2){
-        if(highcut){
-          return cutContainer[i].cutintervalh[icat];
-        }else{
-          return cutContainer[i].cutintervall[icat];
-        }
+  int i = CutIndex(cutname.Data());
+  if( i >= 0 ) {
+    if(cutContainer[i].ncat<2) icat=0;
+    if(cutContainer[i].fromright==2){
+      if(highcut){
+        return cutContainer[i].cutintervalh[icat];
       }else{
-        return cutContainer[i].cut[icat];
+        return cutContainer[i].cutintervall[icat];
       }
+    }else{
+      return cutContainer[i].cut[icat];
     }
   }
   std::cout<<"GetCutValue: attention cutname "<<cutname<<" not found"<<std::endl;
@@ -1545,25 +2034,20 @@ float LoopAll::GetCutValue(TString cutname, int icat, int highcut) {
 
 int LoopAll::ApplyCut(int icut, int icat) {
 
-  if(cutContainer[icut].fromright==2) {
-    if(*(cutContainer[icut].mycutvar)<cutContainer[icut].cutintervall[icat] || *(cutContainer[icut].mycutvar)>cutContainer[icut].cutintervalh[icat]) return 0; 
-  }
-  else if (cutContainer[icut].fromright==1) {
-    if(*(cutContainer[icut].mycutvar)>cutContainer[icut].cut[icat]) return 0; 
-  }
-  else if (cutContainer[icut].fromright==0) {
-    if(*(cutContainer[icut].mycutvar)<cutContainer[icut].cut[icat]) return 0; 
-  }
+  if( ! cutsCompiled ) { CompileCuts(); }
+  const compiled_cut_t & cut = compiledCuts[icut];
+  if( cut.first < 0 ) return 1;
+  float var = *(cut.var);
+  if(var<cutLow[cut.first+icat] || var>cutHigh[cut.first+icat]) return 0; 
   return 1;
 }
 
 int LoopAll::ApplyCut(TString cutname, int icat) {
 
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].name == cutname) {
-      return ApplyCut(i, icat);
-    }
-  } 
+  int i = CutIndex(cutname.Data());
+  if( i >= 0 ) {
+    return ApplyCut(i, icat);
+  }
   //std::cout<<"ApplyCut: attention cutname "<<cutname<<" not found"<<endl;
   return 0;
 }
@@ -1577,10 +2061,9 @@ int LoopAll::ApplyCut(int icut, int * passcategory) {
 }
 
 int LoopAll::ApplyCut(TString cutname, int * passcategory) { //returns the number of categories
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].name==cutname) {
-      return ApplyCut(i, passcategory);
-    }
+  int i = CutIndex(cutname.Data());
+  if( i >= 0 ) {
+    return ApplyCut(i, passcategory);
   }
   cout<<"ApplyCut: attention cutname "<<cutname<<" not found"<<endl;
   return 0;
@@ -1588,33 +2071,28 @@ int LoopAll::ApplyCut(TString cutname, int * passcategory) { //returns the numbe
 
 int LoopAll::ApplyCuts(int icat, int cutset, int & ncutsapplied, int & ncutspassed,  int & ncutsfailed) {
 
-  int ncats=0;
-  int passcuts=1;
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].finalcut==cutset) {
-      //if(cutContainer[i].useit) 
-      {
+  if( ! cutsCompiled ) { CompileCuts(); }
+  std::map<int,cut_set_t>::const_iterator iset = cutSets.find(cutset);
+  if( iset == cutSets.end() ) { return 1; }
+  if( ! iset->second.consistent ) {
+    cout<<"ApplyCuts: attention inconsistent number of categories for cutset "<<cutset<<endl;
+    return 0;
+  }
+  const std::vector<int> & cuts = iset->second.cuts;
 
-	if(cutContainer[i].ncat>1) {
-	  if(ncats==0) ncats=cutContainer[i].ncat;
-	  if(cutContainer[i].ncat!=ncats) {
-	    cout<<"ApplyCuts: attention inconsistent number of categories for cutset "<<cutset<<endl;
-	    return 0;
-	  }
-	}
-	ncutsapplied++;
-	int icatuse=icat;
-	if(cutContainer[i].ncat<=1) {
-	  icatuse=0;
-	}
-	if(ApplyCut(i,icatuse)) {
-	  ncutspassed++;
-	}
-	else {
-	  ncutsfailed++;
-	  passcuts=0;
-	}
-      }
+  int passcuts=1;
+  for (size_t i=0; i<cuts.size(); i++) {
+    ncutsapplied++;
+    int icatuse=icat;
+    if(compiledCuts[cuts[i]].ncat<=1) {
+      icatuse=0;
+    }
+    if(ApplyCut(cuts[i],icatuse)) {
+      ncutspassed++;
+    }
+    else {
+      ncutsfailed++;
+      passcuts=0;
     }
   }
   return passcuts;
@@ -1622,6 +2100,15 @@ int LoopAll::ApplyCuts(int icat, int cutset, int & ncutsapplied, int & ncutspass
 
 int LoopAll::ApplyCutsFill(int icat, int cutset, int & ncutsapplied, int & ncutspassed,  int & ncutsfailed, float histweight, float countweight) {
 
+  if( ! cutsCompiled ) { CompileCuts(); }
+  std::map<int,cut_set_t>::const_iterator iset = cutSets.find(cutset);
+  if( iset == cutSets.end() ) { return 1; }
+  if( ! iset->second.consistent ) {
+    cout<<"ApplyCuts: attention inconsistent number of categories for cutset "<<cutset<<endl;
+    return 0;
+  }
+  const std::vector<int> & cuts = iset->second.cuts;
+
   int ntmpcuts=0;
   int tmppasscut[100];
   int indexcut[100];
@@ -1629,41 +2116,24 @@ int LoopAll::ApplyCutsFill(int icat, int cutset, int & ncutsapplied, int & ncuts
     tmppasscut[i]=0;
   }
 
-  int ncats=0;
   int passcuts=1;
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].finalcut==cutset) {
-      //MARCO if(cutContainer[i].useit) 
-      {
-
-	//cout<<"ApplyCutsFill "<<cutContainer[i].finalcut<<" "<<cutContainer[i].useit<<" "<<endl;
-
-	if(cutContainer[i].ncat>1) {
-	  if(ncats==0) ncats=cutContainer[i].ncat;
-	  if(cutContainer[i].ncat!=ncats) {
-	    cout<<"ApplyCuts: attention inconsistent number of categories for cutset "<<cutset<<endl;
-	    return 0;
-	  }
-	}
-	
-	ncutsapplied++;
+  for (size_t i=0; i<cuts.size(); i++) {
+    ncutsapplied++;
 	
-	int icatuse=icat;
-	if(cutContainer[i].ncat<=1) {
-	  icatuse=0;
-	}
-	if(ApplyCut(i,icatuse)) {
-	  ncutspassed++;
-	  tmppasscut[ntmpcuts]=1;
-	}
-	else {
-	  ncutsfailed++;
-	  passcuts=0;
-	}
-	indexcut[ntmpcuts]=i;
-	ntmpcuts++;
-      }
+    int icatuse=icat;
+    if(compiledCuts[cuts[i]].ncat<=1) {
+      icatuse=0;
+    }
+    if(ApplyCut(cuts[i],icatuse)) {
+      ncutspassed++;
+      tmppasscut[ntmpcuts]=1;
+    }
+    else {
+      ncutsfailed++;
+      passcuts=0;
     }
+    indexcut[ntmpcuts]=cuts[i];
+    ntmpcuts++;
   }
   //cout<<"ApplyCutsFill "<<ncutsapplied<<" "<<ncutsfailed<<" "<<ncutspassed<<" "<<endl;
 
@@ -1671,16 +2141,18 @@ int LoopAll::ApplyCutsFill(int icat, int cutset, int & ncutsapplied, int & ncuts
   if(ncutsfailed==1||ncutsfailed==0) {
     for(int i=0; i<ntmpcuts; i++) {
       if(ncutsfailed==0||tmppasscut[i]==0) {
-  	FillHist(cutContainer[indexcut[i]].name+"_nminus1", icat, *(cutContainer[indexcut[i]].mycutvar), histweight);
-  	FillCounter(cutContainer[indexcut[i]].name+"_nminus1", countweight, icat);
+	const compiled_cut_t & cut = compiledCuts[indexcut[i]];
+  	FillHist(cut.nminus1Histo, icat, *(cut.var), histweight);
+  	FillCounter(cut.nminus1Name, countweight, icat);
   	
       }
     } 
   }
   
   for(int i=0; i<ntmpcuts; i++) {
-    FillHist(cutContainer[indexcut[i]].name+"_sequential", icat, *(cutContainer[indexcut[i]].mycutvar), histweight);
-    FillCounter(cutContainer[indexcut[i]].name+"_sequential", countweight, icat);
+    const compiled_cut_t & cut = compiledCuts[indexcut[i]];
+    FillHist(cut.sequentialHisto, icat, *(cut.var), histweight);
+    FillCounter(cut.sequentialName, countweight, icat);
     if(tmppasscut[i]==0) break;
   }
 
@@ -1691,10 +2163,13 @@ int LoopAll::ApplyCutsFill(int icat, int cutset, int & ncutsapplied, int & ncuts
 
 void LoopAll::FillCutPlots(int icat, int cutset, std::string postfix, float histweight, float countweight)
 {
-    for (unsigned int i=0; i<cutContainer.size(); i++) {
-	if(cutContainer[i].finalcut!=cutset) { continue; }
-	FillHist(cutContainer[i].name+postfix, icat, *(cutContainer[i].mycutvar), histweight);
-	FillCounter(cutContainer[i].name+postfix, countweight, icat);
+    if( ! cutsCompiled ) { CompileCuts(); }
+    std::map<int,cut_set_t>::const_iterator iset = cutSets.find(cutset);
+    if( iset == cutSets.end() ) { return; }
+    const std::vector<int> & cuts = iset->second.cuts;
+    for (size_t i=0; i<cuts.size(); i++) {
+	FillHist(cutContainer[cuts[i]].name+postfix, icat, *(compiledCuts[cuts[i]].var), histweight);
+	FillCounter(cutContainer[cuts[i]].name+postfix, countweight, icat);
     }
 
 }
@@ -1751,14 +2226,14 @@ int LoopAll::ApplyCuts(int cutset, int * passcategory) { //returns the number of
 
 int LoopAll::SetCutVariables(int i, float * variables) {
   cutContainer[i].mycutvar=variables;
+  if( cutsCompiled ) { compiledCuts[i].var=variables; }
   //cout<<"TEST CUT "<<i<<" "<<cutContainer[i].name<<" "<<*(cutContainer[i].mycutvar)<<endl;
 }
 
 int LoopAll::SetCutVariables(TString cutname, float * variables) {
-  for (unsigned int i=0; i<cutContainer.size(); i++) {
-    if(cutContainer[i].name==cutname) {
-      return SetCutVariables(i,variables);
-    }
+  int i = CutIndex(cutname.Data());
+  if( i >= 0 ) {
+    return SetCutVariables(i,variables);
   }
   cout<<"SetCutVariables: attention cutname "<<cutname<<" not found"<<endl;
   return 0;
@@ -39,6 +39,8 @@ class BaseAnalysis;
 #include "VertexAnalysis/interface/VertexAlgoParameters.h"
 #include "Macros/Normalization_8TeV.h"
 #include "RooFuncReader.h"
+#include "EtaPhiIndex.h"
+#include "VertexAnalysis/interface/FlatBDT.h"
 
 #define BRANCH_DICT(NAME) branchDict[# NAME] = branch_info_t(& b ## _ ## NAME, & LoopAll::SetBranchAddress ## _ ## NAME, & LoopAll::Branch ## _ ## NAME )
 
@@ -57,6 +59,27 @@ class LoopAll {
   std::vector<CounterContainer> counterContainer;
   std::vector<SampleContainer> sampleContainer;
   std::vector<Cut> cutContainer;
+#ifndef __CINT__
+  /** cutContainer compiled on first use (and again after AddCut / BookHisto): each cut becomes a variable 
+      pointer and a (low, high) window per category, with one-sided cuts extended to infinity. */
+  struct compiled_cut_t {
+    float * var;
+    int ncat;
+    int first;  // index of the category 0 window in cutLow / cutHigh, -1 for cuts that always pass
+    int nminus1Histo, sequentialHisto;
+    std::string nminus1Name, sequentialName;
+  };
+  struct cut_set_t {
+    std::vector<int> cuts;
+    bool consistent;  // all the cuts with more than one category have the same number of categories
+  };
+  std::vector<compiled_cut_t> compiledCuts;
+  std::vector<float> cutLow, cutHigh;
+  std::map<std::string,int> cutIndex;
+  std::map<int,cut_set_t> cutSets;
+#endif
+  bool cutsCompiled;
+  void CompileCuts();
   //std::vector<TreeContainer> treeContainer;	 
   std::map<std::string, std::vector<TreeContainer> > treeContainer;	 
   
@@ -110,7 +133,48 @@ class LoopAll {
   void Term(); 
 
   void checkDuty(int n, float thr, float start) { checkBench=n; benchThr=thr; benchStart=start; }
+
+  /** number of threads used to process each input file in the analysis step (typerun 0).
+      With nThreads > 1 the entries of each file are split across worker LoopAll 
+      instances, copies of this one owning their own branch buffers, analysis clones and containers.
+      The workers' results are merged into this instance in TermReal. Text files written by the analyses are 
+      opened by the workers under WorkerFileName and appended after each input file (BaseAnalysis::MergeCloneOutput).
+      The calls into TMVA::Reader and RooFit made while looping are serialised through gRootLock (see RootLock.h): 
+      code calling them from an analysis has to take the lock too.
+      Histograms are summed in a different order than in a single-threaded job: AnalysisScripts/check_threads.py 
+      compares the outputs of jobs run with different numbers of threads. */
+  int nThreads;
+  /** 0 for the main instance, 1..nThreads-1 for the worker instances */
+  int workerId;
+  /** name of a file written by this instance: the worker instances append .worker<workerId> to it */
+  std::string WorkerFileName(const std::string & name) const;
+  std::vector<LoopAll*> workers;
+
+  LoopAll * MakeWorker(int id);
+  void InitWorkerBranches();
+  bool CreateWorkers();
+  void MergeWorkers();
+  void LoopEntries(Int_t first, Int_t last, Int_t nentries);
+  void LoopParallel(Int_t a, Int_t nentries);
+
+  /** number of input files opened ahead of the one being processed, with TFile::AsyncOpen. 
+      The baskets of the input branches are then read in blocks through a TTreeCache. 
+      In MergeContainers, any value > 0 enables the reading ahead, limited by prefetchBytes.
+      0 disables the prefetching. */
+  int prefetchFiles;
+  /** size in bytes of the TTreeCache set up on the input trees when prefetchFiles > 0 */
+  Long64_t prefetchCacheSize;
+  /** in MergeContainers, maximum total size in bytes of the files opened and read ahead of the one being merged */
+  Long64_t prefetchBytes;
   
+  TFile * OpenInputFile(int i);
+  void PrefetchInputFiles(int first);
+  void ClearPrefetchedFiles();
+  
+  /** if non-zero, each BDT evaluated through its compiled forest is also evaluated 
+      with TMVA::Reader and differences are reported */
+  int checkCompiledMvas;
+
   int checkBench;
   TStopwatch stopWatch;
   float benchThr, benchStart;
@@ -155,6 +219,18 @@ class LoopAll {
   std::string outputTextFileName;
   Int_t makeOutputTree;
 
+  /** output settings for the reduction step, which can be set from the reduction datacard.
+      The reduced tree is flushed to the file every outputAutoFlush bytes (or entries if positive)
+      and its header is saved every outputAutoSave bytes (or entries), so that a crashed job leaves a 
+      readable file. Compression algorithm and level follow the TFile conventions; 
+      algorithm 0 and a negative level leave the defaults. 
+      A positive outputBasketSize overrides the basket size of all the output branches. */
+  Int_t outputCompressionAlgorithm, outputCompressionLevel;
+  Long64_t outputAutoFlush, outputAutoSave;
+  Int_t outputBasketSize;
+  void SetupOutputFile();
+  void SetupOutputTree();
+
   char inputFilesName[1024];
   char countersName[1024];
 
@@ -209,14 +285,31 @@ class LoopAll {
   void myPrintCounters();
   void myPrintCountersNew();
 
-  virtual void   BookHisto(int, int, int, int, int, int,
+  /** books the histogram in all the containers
+      @return the handle to be passed to FillHist / FillHist2D */
+  virtual int    BookHisto(int, int, int, int, int, int,
                            float, float, float, float, const char*,
 			   const char* xaxis="", const char* yaxis="");
+  /** @return the handle of a booked histogram, -1 if no histogram with this name was booked */
+  int HistoHandle(const std::string & name);
 
   
   // Cut down (flat) trees for MVA Training 
   void InitTrees(std::string);
-  void BookTreeBranch(std::string name, int type, std::string dirName="");
+  /** books the branch in the trees of all the samples, bound to one value shared among them.
+      @return the address of the value: writing to it and calling FillTreeContainer(dirName) fills the 
+      tree of the current sample, without any look up by name */
+  void * BookTreeBranch(std::string name, int type, std::string dirName="");
+  /** @return the address of the value of a branch booked with BookTreeBranch (e.g. from the treevariables dat file), 
+      0 if there is no such branch of type T */
+  template <class T> T * GetTreeSlot(const std::string & name, const std::string & dirName="") {
+	  T * address = 0;
+	  std::map<std::string, std::vector<TreeContainer> >::iterator it = treeContainer.find(dirName);
+	  if( it != treeContainer.end() && ! it->second.empty() ) {
+		  it->second[0].GetSlot(name,address);
+	  }
+	  return address;
+  }
   template <class T> void BookExternalTreeBranch(const char * name, T* addr, std::string dirName) {
 	  for(unsigned int ind=0; ind<treeContainer[dirName].size(); ind++) {
 		  treeContainer[dirName][ind].AddExternalBranch<T>(name,addr);
@@ -274,12 +367,20 @@ class LoopAll {
   int SetCutVariables(int i, float * variables);
   int SetCutVariables(TString cutname, float * variables);  
 
+  /** @return the index of the cut in cutContainer, to be passed to the integer versions of ApplyCut 
+      and SetCutVariables, -1 if no cut with this name was added */
+  int CutIndex(const std::string & cutname);
+
   void FillHist(std::string, float);
   void FillHist2D(std::string, float, float);
 
   void FillHist(std::string, int, float, float wt = 1.0); 
   void FillHist2D(std::string, int, float, float, float wt = 1.0);
 
+  /** fast filling methods, which skip the histogram lookup by name */
+  void FillHist(int handle, int category, float y, float wt = 1.0); 
+  void FillHist2D(int handle, int category, float x, float y, float wt = 1.0);
+
   void FillCounter(std::string name, float weight=1., int cat=0);
 
   BaseAnalysis* AddAnalysis(BaseAnalysis*); 
@@ -314,6 +415,8 @@ class LoopAll {
   };
   typedef std::map<std::string, branch_info_t> dict_t;
   dict_t branchDict;
+
+  std::map<int, TFileOpenHandle *> prefetchedFiles;
 #endif
 
   //// std::set<std::string> skimBranchNames;
@@ -329,12 +432,47 @@ class LoopAll {
   float pfEcalIso(int phoindex, float dRmax, float dRVetoBarrel, float dRVetoEndcap, float etaStripBarrel, float etaStripEndcap, 
 		  float thrBarrel, float thrEndcaps, int pfToUse=4);
 
+#ifndef __CINT__
+  /** per-event copies of the PF candidates and tracks used by the isolation sums, indexed in eta-phi. 
+      Built on first use, invalidated when a new entry is read */
+  struct isolation_objects_t {
+	  isolation_objects_t() : valid(false) {};
+	  void resize(int n) {
+		  pt.resize(n), px.resize(n), py.resize(n), pz.resize(n), eta.resize(n), phi.resize(n);
+		  vx.resize(n), vy.resize(n), vz.resize(n), pdgid.resize(n), hasVtx.resize(n);
+	  };
+	  bool valid;
+	  std::vector<double> pt, px, py, pz, eta, phi, vx, vy, vz;
+	  std::vector<int> pdgid;
+	  std::vector<char> hasVtx;
+	  double vzMin, vzMax, vrMax; // bounding box of the vertex positions
+	  EtaPhiIndex index;
+  };
+  isolation_objects_t pfCandIndex_, trackIndex_;
+  std::vector<int> isolationQuery_;
+  void fillIsolationObject(isolation_objects_t & objs, int i, const TLorentzVector & p4, const TVector3 * vtx);
+  const isolation_objects_t & pfCandIndex();
+  const isolation_objects_t & trackIndex();
+#endif
+
   RooFuncReader *funcReader_dipho_MIT;
   TMVA::Reader *tmvaReaderID_UCSD, * tmvaReader_dipho_UCSD;
   TMVA::Reader *tmvaReaderID_MIT_Barrel, *tmvaReaderID_MIT_Endcap;
   TMVA::Reader *tmvaReader_dipho_MIT;
   TMVA::Reader *tmvaReaderID_Single_Barrel, *tmvaReaderID_Single_Endcap;
   TMVA::Reader *tmvaReaderID_2013_Barrel, *tmvaReaderID_2013_Endcap;
+#ifndef __CINT__
+  /** BDTs booked in the readers above, compiled into flat node tables on first use (see FlatBDT).
+      The inputs are read through the same pointers that were bound to the Reader. */
+  struct compiled_mva_t {
+	  FlatBDT forest;
+	  std::vector<Float_t *> inputs;
+	  std::vector<float> row;
+  };
+  std::map<std::pair<TMVA::Reader *,std::string>,compiled_mva_t> compiledMvas_;
+  /** same as reader->EvaluateMVA(method), using the compiled forest when the method could be compiled */
+  Float_t evaluateMVA(TMVA::Reader * reader, const char * method);
+#endif
 
   Float_t photonIDMVA(Int_t, Int_t, TLorentzVector &, const char*);
 
@@ -396,6 +534,9 @@ class LoopAll {
  
   std::vector<Float_t> tmva_dipho_MIT_buf;
   std::map<int,std::vector<Float_t> > tmva_dipho_MIT_cache;
+  /** MIT diphoton MVA outputs of the current entry, keyed on the full set of inputs */
+  std::map<std::vector<Float_t>,Float_t> diphoMvaMemo_;
+  Long64_t diphoMvaMemoHits, diphoMvaMemoMisses;
   Float_t *tmva_dipho_MIT_dmom;
   Float_t *tmva_dipho_MIT_dmom_wrong_vtx;
   Float_t *tmva_dipho_MIT_vtxprob;
@@ -1238,6 +1379,10 @@ int ElectronSelectionMVA2012_nocutOnMVA(float elptcut);
 bool ElectronMVACuts_nocutOnMVA(int el_ind, int vtx_ind);
 //HCP2012
 TLorentzVector METCorrection2012B(TLorentzVector lead_p4, TLorentzVector sublead_p4, bool moriond2013MetCorrection);
+// last METCorrection2012B result and the event/photons it was computed for
+TLorentzVector metCorr2012B_, metCorrLead_, metCorrSublead_;
+int metCorrEvent_, metCorrLumi_, metCorrRun_;
+bool metCorrIsMC_;
 //bool METAnalysis2012B(float MET);
 bool METAnalysis2012B(TLorentzVector lead_p4, TLorentzVector sublead_p4, bool useUncor, bool doMETCleaning=true, bool moriond2013MetCorrection=false);
 bool METCleaning2012B(TLorentzVector& lead_p4, TLorentzVector& sublead_p4, TLorentzVector& myMet);
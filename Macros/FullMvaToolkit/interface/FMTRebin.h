@@ -21,6 +21,8 @@ class FMTRebin : public FMTBase {
     void histogramSmoothingFit(TH1F*);
     TH1F* rebinBinnedDataset(string,TH1F*,vector<double>,int);
     void maxSigScan(double*,int*,int*,TH1F*,TH1F*,int,int*,int);
+    void fillRangeSums(TH1F*,vector<double>&);
+    double rangeSum(const vector<double>&,int,int);
     vector<double> significanceOptimizedBinning(TH1F*,TH1F*,int,int mass=125);
     vector<double> soverBOptimizedBinning(TH1F*,TH1F*,int,double);
     
@@ -58,6 +60,10 @@ class FMTRebin : public FMTBase {
 		int sweepmode;
 		double *signalVector1;
 		double *backgroundVector1;
+		// bin range integrals of the histograms being scanned by maxSigScan, filled by fillRangeSums
+		vector<double> sigRangeSums_, bkgRangeSums_;
+		vector<int> rangeSumRow_;
+		int rangeSumBins_;
 		TFile *tFile;
 		TFile *outFile;
 
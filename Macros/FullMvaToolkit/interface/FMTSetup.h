@@ -90,6 +90,7 @@ class FMTSetup : public FMTBase {
     string bdtname;
     string weightsFile;
     string histFromTreeMode_;
+    int interpThreads_;
 
 		int tempmHMin_;
 		int tempmHMax_;
@@ -23,11 +23,14 @@ class FMTSigInterp : public FMTBase {
 
     TH1F *Interpolate(double,TH1F*,double,TH1F*,double,  bool smoothEff=false, std::string prod="nothing");
 
+    // number of threads computing the interpolated histograms in runInterpolation
+    void setnThreads(int);
     void runInterpolation();
 
   private:
     TFile *tFile;
     Normalization_8TeV *normalizer;
+    int nThreads_;
    // bool diagnose_;
    // bool blind_;
 	
@@ -32,6 +32,7 @@ FMTRebin::FMTRebin(TFile *tF, TFile *oF):
 
   signalVector1 = new double[25];
   backgroundVector1 = new double[25];
+  rangeSumBins_ = 0;
   cout << "Creating fitter" << endl;
   cout << "Passing outfile" << outFile->GetName() << endl;
   fitter = new FMTFit(tFile,outFile);
@@ -48,6 +49,7 @@ FMTRebin::FMTRebin(TFile *tF, TFile *oF, double intLumi, bool is2011, int mHMini
 {
   signalVector1 = new double[25];
 	backgroundVector1 = new double[25];
+  rangeSumBins_ = 0;
 	//tFile = TFile::Open(filename.c_str());
 	//outFile = new TFile(outfilename.c_str(),"RECREATE");
   cout << "Creating fitter" << endl;
@@ -159,6 +161,10 @@ std::vector<double> FMTRebin::significanceOptimizedBinning(TH1F *hs,TH1F *hb,int
   int 	chosenN=1;
   int 	*finalCounters=NULL ;
 
+  // every candidate placement needs the signal and background in each bin range, tabulate them once
+  fillRangeSums(hsnew,sigRangeSums_);
+  fillRangeSums(hbnew,bkgRangeSums_);
+
   g_step = (int)TMath::Exp(TMath::Log(nNewBins/2)/2);
   if (g_step < 1) g_step=1;
 
@@ -476,6 +482,36 @@ TH1F* FMTRebin::rebinBinnedDataset(std::string new_name, TH1F *hb,std::vector<do
   return hbnew;	
 }
 
+void FMTRebin::fillRangeSums(TH1F *h, vector<double> &sums){
+
+  // Table of h->Integral(a,b) for 1<=a<=nBins and a<=b<=nBins+1, row a starting at rangeSumRow_[a].
+  // Each row is accumulated bin by bin, as TH1::Integral does, so the values are the same to the last bit.
+  int nBins = h->GetNbinsX();
+  rangeSumRow_.assign(nBins+2,0);
+  int nsums=0;
+  for (int a=1;a<=nBins;a++){
+    rangeSumRow_[a]=nsums;
+    nsums+=nBins+2-a;
+  }
+  sums.resize(nsums);
+  for (int a=1;a<=nBins;a++){
+    double integral=0;
+    double *row = &sums[rangeSumRow_[a]];
+    for (int b=a;b<=nBins+1;b++){
+      integral+=h->GetBinContent(b);
+      row[b-a]=integral;
+    }
+  }
+  rangeSumBins_=nBins;
+}
+
+double FMTRebin::rangeSum(const vector<double> &sums, int a, int b){
+
+  // same conventions as TH1::Integral: a range ending before it starts runs up to the overflow
+  if (b<a || b>rangeSumBins_+1) b=rangeSumBins_+1;
+  return sums[rangeSumRow_[a]+b-a];
+}
+
 void FMTRebin::maxSigScan(double *maximumSignificance,int *frozen_counters,int *chosen_counters,TH1F *hs, TH1F *hb, int N,int *counters, int movingCounterIndex){
 
 
@@ -504,58 +540,43 @@ void FMTRebin::maxSigScan(double *maximumSignificance,int *frozen_counters,int *
   if (counters[movingCounterIndex] < 2) std::cout << "WHAT IS GOING ON?? " <<  movingCounterIndex << " " << counters[movingCounterIndex]<<std::endl;
 
   if ( movingCounterIndex==N-1) {	
-    if (not sweepmode){
-      for (;counters[N-1]<=nBins;counters[N-1]+=g_step){
-        for (int j=0;j<=N-1;j++){
-          if (j==0){
-            signalVector1[j] = (hs->Integral(1,counters[j]-1));
-            backgroundVector1[j] = (hb->Integral(1,counters[j]-1));
-
-          } else {
-            signalVector1[j] = (hs->Integral(counters[j-1],counters[j]-1));
-            backgroundVector1[j] = (hb->Integral(counters[j-1],counters[j]-1));
-
-          }
-        }
-        signalVector1[N]=(hs->Integral(counters[N-1],nBins));
-        backgroundVector1[N]=(hb->Integral(counters[N-1],nBins));
-        significance_now = calculateSigMulti(signalVector1,backgroundVector1,N+1);
-
-        if (significance_now>*maximumSignificance){
-          *maximumSignificance=significance_now;
-          for (int j=0;j<N;j++){
-            chosen_counters[j]=counters[j];	
-            if (chosen_counters[j] < 0) std::cout << "Freak OUT !!! - " << j << "  " << chosen_counters[j] <<std::endl;
-          }
-        }
+    // broad scan moves the last boundary by g_step up to the end, fine scan by one up to g_step past the rough guess
+    int laststep = (not sweepmode) ? g_step : 1;
+    int lastmax = nBins;
+    if (sweepmode && frozen_counters[N-1] + g_step < nBins) lastmax = frozen_counters[N-1] + g_step;
+
+    // bins below counters[N-2] do not depend on the last boundary, sum their terms once
+    // in the same order as calculateSigMulti so that the significance is unchanged
+    double logtermsFixed=0, stermFixed=0;
+    for (int j=0;j<N-1;j++){
+      signalVector1[j] = rangeSum(sigRangeSums_,(j==0 ? 1 : counters[j-1]),counters[j]-1);
+      backgroundVector1[j] = rangeSum(bkgRangeSums_,(j==0 ? 1 : counters[j-1]),counters[j]-1);
+      logtermsFixed+=(signalVector1[j]+backgroundVector1[j])*TMath::Log((signalVector1[j]+backgroundVector1[j])/backgroundVector1[j]);
+      stermFixed+=signalVector1[j];
+    }
+    int lastlow = (N==1) ? 1 : counters[N-2];
+    for (;counters[N-1]<=lastmax;counters[N-1]+=laststep){
+      signalVector1[N-1] = rangeSum(sigRangeSums_,lastlow,counters[N-1]-1);
+      backgroundVector1[N-1] = rangeSum(bkgRangeSums_,lastlow,counters[N-1]-1);
+      signalVector1[N] = rangeSum(sigRangeSums_,counters[N-1],nBins);
+      backgroundVector1[N] = rangeSum(bkgRangeSums_,counters[N-1],nBins);
+
+      double logterms = logtermsFixed;
+      double sterm = stermFixed;
+      for (int j=N-1;j<=N;j++){
+        logterms+=(signalVector1[j]+backgroundVector1[j])*TMath::Log((signalVector1[j]+backgroundVector1[j])/backgroundVector1[j]);
+        sterm+=signalVector1[j];
       }
-      maxSigScan(maximumSignificance,frozen_counters,chosen_counters,hs,hb,N,counters,movingCounterIndex-1);
-    } else { // fine scanning
-      int currmax = (nBins < frozen_counters[N-1] + g_step )? nBins : frozen_counters[N-1] + g_step;
-      for (;counters[N-1]<=currmax;counters[N-1]++){
-        for (int j=0;j<=N-1;j++){
-          if (j==0){
-            signalVector1[j] = (hs->Integral(1,counters[j]-1));
-            backgroundVector1[j] = (hb->Integral(1,counters[j]-1));
-
-          } else {
-            signalVector1[j] = (hs->Integral(counters[j-1],counters[j]-1));
-            backgroundVector1[j] = (hb->Integral(counters[j-1],counters[j]-1));
-
-          }
-        }	
-        signalVector1[N]=(hs->Integral(counters[N-1],nBins));
-        backgroundVector1[N]=(hb->Integral(counters[N-1],nBins));
-        significance_now = calculateSigMulti(signalVector1,backgroundVector1,N+1);
-        if (significance_now>*maximumSignificance){
-          *maximumSignificance=significance_now;
-          for (int j=0;j<N;j++){
-            chosen_counters[j]=counters[j];
-          }
+      significance_now = 1.4142*TMath::Sqrt(logterms - sterm);
+
+      if (significance_now>*maximumSignificance){
+        *maximumSignificance=significance_now;
+        for (int j=0;j<N;j++){
+          chosen_counters[j]=counters[j];
         }
       }
-      maxSigScan(maximumSignificance,frozen_counters,chosen_counters,hs,hb,N,counters,movingCounterIndex-1);
     }
+    maxSigScan(maximumSignificance,frozen_counters,chosen_counters,hs,hb,N,counters,movingCounterIndex-1);
   }
 
 
@@ -40,7 +40,8 @@ FMTSetup::FMTSetup(string filename):
 	runSB_(false),
 	cleaned(false),
   userLumi_(0.),
-  histFromTreeMode_("all")
+  histFromTreeMode_("all"),
+  interpThreads_(1)
 {
   //if (filename!="0") system(Form("cp %s %s_beforeFMT.root",filename.c_str(),filename.c_str()));
   intLumi_=0.;
@@ -86,6 +87,7 @@ void FMTSetup::OptionParser(int argc, char *argv[]){
     ("dumpDatFile,F",po::value<string>(&dumpDatFil_),                   "Save a new .dat file. For example if you want to save the bin edges so they can be read in later.")
     ("bkgModel,b",  																										"Correct the background model")
     ("interp,I",    																										"Run signal interpolation")
+    ("interpThreads",po::value<int>(&interpThreads_)->default_value(1),"Number of threads used to compute the signal interpolation")
     ("datacards,d", 																										"Produce datacards")
     ("diagnose,D",  																										"Run full diagnostics (makes plots) - increases running time")
     ("www,w",     	po::value<string>(&webDir_),												"Publish to web - increases running time")
@@ -580,6 +582,7 @@ void FMTSetup::interpolateBDT(){
 		FMTSigInterp *interpolater = new FMTSigInterp(outfilename_);
 		configureOptions(interpolater);
 		ReadRunConfig(interpolater);
+		interpolater->setnThreads(interpThreads_);
 		interpolater->runInterpolation();
 		delete interpolater;
 	}
@@ -9,6 +9,7 @@
 #include "TLegend.h"
 #include "TCanvas.h"
 #include "TPaveText.h"
+#include "TThread.h"
 
 #include "boost/lexical_cast.hpp"
 
@@ -18,6 +19,7 @@ using namespace std;
 FMTSigInterp::FMTSigInterp(string filename):FMTBase()
 {
   tFile = new TFile(filename.c_str(),"UPDATE");
+  nThreads_ = 1;
 }
 
 FMTSigInterp::FMTSigInterp(string filename, double intLumi, bool is2011, bool diagnose, bool doSyst, int mHMinimum, int mHMaximum, double mHStep, double massMin, double massMax, int nDataBins, double signalRegionWidth, double sidebandWidth, int numberOfSidebands, int numberOfSidebandsForAlgos, int numberOfSidebandGaps, double massSidebandMin, double massSidebandMax, int nIncCategories, bool includeVBF, int nVBFCategories, bool includeLEP, int nLEPCategories, vector<string> systematics, bool rederiveOptimizedBinEdges, vector<map<int, vector<double> > > AllBinEdges, bool blind, bool verbose):
@@ -27,6 +29,7 @@ FMTSigInterp::FMTSigInterp(string filename, double intLumi, bool is2011, bool di
  // blind_(blind)
 {
   tFile = new TFile(filename.c_str(),"UPDATE");
+  nThreads_ = 1;
 
 }
 
@@ -100,6 +103,64 @@ void FMTSigInterp::makeEfficiencyGraphs(){
   }  
 }
 
+// -------------------------------------------------------------------------------------------------------------
+namespace {
+  // one interpolated histogram; low and high index the table of input histograms
+  struct interp_job_t {
+    string name;
+    int low, high;
+    double massLow, massHigh, massInt;
+    double lowScale, highScale;
+    double effNorm, xsNorm;   // effNorm < 0 when the efficiency is not smoothed
+    size_t offset;            // of the interpolated contents in the output array
+    double factor;            // final normalisation, filled by the workers
+  };
+
+  struct interp_input_t {
+    TH1F *hist;
+    int nbins;
+    size_t offset;            // of the bin contents in the input array
+  };
+
+  struct interp_task_t {
+    const vector<interp_input_t> *inputs;
+    const double *inputContents;
+    vector<interp_job_t> *jobs;
+    double *outContents;
+    size_t first, last;
+  };
+
+  // same arithmetic as FMTSigInterp::Interpolate, values are rounded to float wherever the histograms store them
+  void interpolateJob(const vector<interp_input_t> &inputs, const double *inputContents, interp_job_t &job, double *outContents){
+    const interp_input_t &low = inputs[job.low];
+    const interp_input_t &high = inputs[job.high];
+    const double *contLow = inputContents+low.offset;
+    const double *contHigh = inputContents+high.offset;
+    double *out = outContents+job.offset;
+    double integral=0.;
+    for (int i=0; i<low.nbins; i++){
+      double OutLow = (float)(contLow[i]*(1./job.lowScale));
+      double OutHigh = (float)(contHigh[i]*(1./job.highScale));
+      out[i] = (float)((OutHigh*(job.massInt-job.massLow)-OutLow*(job.massInt-job.massHigh))/(job.massHigh-job.massLow));
+      integral += out[i];
+    }
+    if (job.effNorm>=0.) job.factor = job.effNorm*job.xsNorm/integral;
+    else job.factor = job.xsNorm;
+  }
+
+  void *runInterpolationTask(void *arg){
+    interp_task_t *task = (interp_task_t*)arg;
+    for (size_t j=task->first; j<task->last; j++){
+      interpolateJob(*task->inputs,task->inputContents,(*task->jobs)[j],task->outContents);
+    }
+    return 0;
+  }
+}
+
+void FMTSigInterp::setnThreads(int nThreads){
+  nThreads_ = (nThreads<1 ? 1 : nThreads);
+}
+
 void FMTSigInterp::runInterpolation(){
   
   normalizer = new Normalization_8TeV();
@@ -113,103 +174,167 @@ void FMTSigInterp::runInterpolation(){
   
   vector<int> mcMasses = getMCMasses();
   vector<string> productionTypes = getProdTypes();
+  vector<string> theSystematics = getsystematics();
+  vector<string> UorD;
+  UorD.push_back("Up");
+  UorD.push_back("Down");
 
   // make Smooth efficiency Graphs
 
   makeEfficiencyGraphs();
   
-  
-  // now do interpolation
+  // first list the interpolations, reading every input histogram once into a contiguous array
+  vector<interp_input_t> inputs;
+  vector<double> inputContents;
+  map<string,int> inputIndex;
+  vector<interp_job_t> jobs;
+  size_t nOutContents=0;
+  vector<double> knownMasses;
+
   for (vector<int>::iterator mcMass=mcMasses.begin(); mcMass!=mcMasses.end(); mcMass++){
     vector<double> mhMasses = getMHMasses(*mcMass);
     for (vector<double>::iterator mh = mhMasses.begin(); mh!=mhMasses.end(); mh++){
       if (fabs(*mh-boost::lexical_cast<double>(*mcMass))<0.01) {
-        if (verbose_) cout << "Already know this mass " << *mh << endl;
-        TH1F *allSig=0;
-        for (vector<string>::iterator prod=productionTypes.begin(); prod!=productionTypes.end(); prod++){
-          TH1F *sig = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%3.1f_%3.1f",prod->c_str(),*mh,*mh));
-          sig->SetName(Form("th1f_sig_grad_%s_%3.1f",prod->c_str(),*mh));
-          //write(tFile,sig);
-	  // Make its Normalization and efficiency smoother!
-      	  double EffNorm = (efficiencyGraphs[*prod])->GetFunction("pol4")->Eval(*mh);
-	  double XSnorm  = normalizer->GetXsection(*mh,sig->GetName())*normalizer->GetBR(*mh);
-      	  sig->Scale(EffNorm*XSnorm/sig->Integral());
-	  
-          if (verbose_) checkHisto(sig);
-          gDirectory->Cd(Form("%s:/",tFile->GetName()));
-          sig->Write();
-          if (*prod=="ggh") allSig = (TH1F*)sig->Clone();
-          else allSig->Add(sig);
-          vector<string> theSystematics = getsystematics();
-          if (verbose_) cout << "["; printVec(theSystematics); cout << "]" << endl;
-          for (vector<string>::iterator syst=theSystematics.begin(); syst!=theSystematics.end(); syst++){
-            if (verbose_) cout << Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sUp01_sigma",prod->c_str(),*mh,*mh,syst->c_str()) << endl;
-            if (verbose_) cout << Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sDown01_sigma",prod->c_str(),*mh,*mh,syst->c_str()) << endl;
-            TH1F* up = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sUp01_sigma",prod->c_str(),*mh,*mh,syst->c_str()));
-            TH1F* down = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sDown01_sigma",prod->c_str(),*mh,*mh,syst->c_str()));
-            up->SetName(Form("th1f_sig_grad_%s_%3.1f_%sUp01_sigma",prod->c_str(),*mh,syst->c_str()));
-            down->SetName(Form("th1f_sig_grad_%s_%3.1f_%sDown01_sigma",prod->c_str(),*mh,syst->c_str()));
-            //write(tFile,up);
-            //write(tFile,down);
-            gDirectory->Cd(Form("%s:/",tFile->GetName()));
-            up->Write();
-            down->Write();
-          }
-        }
+        knownMasses.push_back(*mh);
+        continue;
       }
-      else{
-        int nearest = (getInterpMasses(*mh)).first;
-        int nextNear = (getInterpMasses(*mh)).second;
-        int binningMass, lowInterpMass, highInterpMass;
-        if (nearest-nextNear>0) {
-          binningMass=nearest;
-          lowInterpMass=nextNear;
-          highInterpMass=nearest;
-          if (verbose_) cout << "Mass: " << *mh << " binMass: " << nearest << " (" << nextNear << "," << nearest << ")" << endl;
-        }
-        else {
-          binningMass=nearest;
-          lowInterpMass=nearest;
-          highInterpMass=nextNear;
-          if (verbose_) cout << "Mass: " << *mh << " binMass: " << nearest << " (" << nearest << "," << nextNear << ")" << endl;
+      int nearest = (getInterpMasses(*mh)).first;
+      int nextNear = (getInterpMasses(*mh)).second;
+      int binningMass, lowInterpMass, highInterpMass;
+      if (nearest-nextNear>0) {
+        binningMass=nearest;
+        lowInterpMass=nextNear;
+        highInterpMass=nearest;
+        if (verbose_) cout << "Mass: " << *mh << " binMass: " << nearest << " (" << nextNear << "," << nearest << ")" << endl;
+      }
+      else {
+        binningMass=nearest;
+        lowInterpMass=nearest;
+        highInterpMass=nextNear;
+        if (verbose_) cout << "Mass: " << *mh << " binMass: " << nearest << " (" << nearest << "," << nextNear << ")" << endl;
+      }
+      // central signal histograms, then signal systematic histograms
+      vector<string> suffixes(1,"");
+      for (vector<string>::iterator syst=theSystematics.begin(); syst!=theSystematics.end(); syst++){
+        for (vector<string>::iterator ud=UorD.begin(); ud!=UorD.end(); ud++){
+          suffixes.push_back(Form("_%s%s01_sigma",syst->c_str(),ud->c_str()));
         }
-        // first do central signal histograms
-        TH1F *allSig = 0;
+      }
+      for (vector<string>::iterator suffix=suffixes.begin(); suffix!=suffixes.end(); suffix++){
         for (vector<string>::iterator prod=productionTypes.begin(); prod!=productionTypes.end(); prod++){
-          TH1F *lowInterp = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%d.0_%d.0",prod->c_str(),binningMass,lowInterpMass));
-          TH1F *highInterp = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%d.0_%d.0",prod->c_str(),binningMass,highInterpMass));
-          if (verbose_) checkHisto(lowInterp);
-          if (verbose_) checkHisto(highInterp);
-          TH1F *interpolated = Interpolate(double(lowInterpMass), lowInterp, double(highInterpMass), highInterp, *mh,true,*prod);
-          if (verbose_) checkHisto(interpolated);
-          //write(tFile,interpolated);
-          gDirectory->Cd(Form("%s:/",tFile->GetName()));
-          interpolated->Write();
-          if (*prod=="ggh") allSig = (TH1F*)interpolated->Clone();
-          else allSig->Add(interpolated);
-        }
-        
-        // then do signal systematic histograms
-        vector<string> theSystematics = getsystematics();
-        vector<string> UorD;
-        UorD.push_back("Up");
-        UorD.push_back("Down");
-        for (vector<string>::iterator syst=theSystematics.begin(); syst!=theSystematics.end(); syst++){
-          for (vector<string>::iterator ud=UorD.begin(); ud!=UorD.end(); ud++){
-            for (vector<string>::iterator prod=productionTypes.begin(); prod!=productionTypes.end(); prod++){
-              TH1F *lowInterp = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%d.0_%d.0_%s%s01_sigma",prod->c_str(),binningMass,lowInterpMass,syst->c_str(),ud->c_str()));
-              TH1F *highInterp = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%d.0_%d.0_%s%s01_sigma",prod->c_str(),binningMass,highInterpMass,syst->c_str(),ud->c_str()));
-              if (verbose_) checkHisto(lowInterp);
-              if (verbose_) checkHisto(highInterp);
-              TH1F *interpolated = Interpolate(double(lowInterpMass), lowInterp, double(highInterpMass), highInterp, *mh);
-              if (verbose_) checkHisto(interpolated);
-              //write(tFile,interpolated);
-              gDirectory->Cd(Form("%s:/",tFile->GetName()));
-              interpolated->Write();
+          interp_job_t job;
+          int interpMass[2] = {lowInterpMass,highInterpMass};
+          int index[2];
+          for (int k=0; k<2; k++){
+            string inName = Form("th1f_sig_grad_%s_%d.0_%d.0%s",prod->c_str(),binningMass,interpMass[k],suffix->c_str());
+            map<string,int>::iterator it = inputIndex.find(inName);
+            if (it==inputIndex.end()){
+              TH1F *h = (TH1F*)tFile->Get(inName.c_str());
+              if (!h) {
+                cerr << "WARNING -- FMTSigInterp::runInterpolation() -- histogram " << inName << " not found. Bailing out" << endl;
+                exit(1);
+              }
+              if (verbose_) checkHisto(h);
+              interp_input_t input;
+              input.hist = h;
+              input.nbins = h->GetNbinsX();
+              input.offset = inputContents.size();
+              for (int i=0; i<input.nbins; i++) inputContents.push_back(h->GetBinContent(i+1));
+              it = inputIndex.insert(make_pair(inName,(int)inputs.size())).first;
+              inputs.push_back(input);
             }
+            index[k] = it->second;
           }
+          if (inputs[index[0]].nbins!=inputs[index[1]].nbins) std::cout << "Cannot interpolate differently binned histograms" << std::endl;
+          assert(inputs[index[0]].nbins==inputs[index[1]].nbins);
+
+          job.name = Form("th1f_sig_grad_%s_%3.1f%s",prod->c_str(),*mh,suffix->c_str());
+          job.low = index[0];
+          job.high = index[1];
+          job.massLow = double(lowInterpMass);
+          job.massHigh = double(highInterpMass);
+          job.massInt = *mh;
+          job.lowScale = normalizer->GetXsection(job.massLow,inputs[job.low].hist->GetName())*normalizer->GetBR(job.massLow);
+          job.highScale = normalizer->GetXsection(job.massHigh,inputs[job.high].hist->GetName())*normalizer->GetBR(job.massHigh);
+          job.xsNorm = normalizer->GetXsection(*mh,job.name.c_str())*normalizer->GetBR(*mh);
+          // Smooth eff*acc for nominal signal
+          job.effNorm = ( suffix->empty() ? (efficiencyGraphs[*prod])->GetFunction("pol4")->Eval(*mh) : -1. );
+          job.offset = nOutContents;
+          job.factor = 0.;
+          nOutContents += inputs[job.low].nbins;
+          jobs.push_back(job);
         }
       }
     }
   }
+
+  // now do interpolation, splitting the list in fixed chunks among the threads
+  vector<double> outContents(nOutContents);
+  int nTasks = ( (int)jobs.size()<nThreads_ ? (int)jobs.size() : nThreads_ );
+  if (nTasks<1) nTasks=1;
+  vector<interp_task_t> tasks(nTasks);
+  vector<TThread*> threads(nTasks,(TThread*)0);
+  if (nTasks>1) TThread::Initialize();
+  for (int t=0; t<nTasks; t++){
+    tasks[t].inputs = &inputs;
+    tasks[t].inputContents = ( inputContents.empty() ? 0 : &inputContents[0] );
+    tasks[t].jobs = &jobs;
+    tasks[t].outContents = ( outContents.empty() ? 0 : &outContents[0] );
+    tasks[t].first = jobs.size()*t/nTasks;
+    tasks[t].last = jobs.size()*(t+1)/nTasks;
+    if (t>0) {
+      threads[t] = new TThread(Form("FMTSigInterp_worker%d",t), runInterpolationTask, (void*)&tasks[t]);
+      threads[t]->Run();
+    }
+  }
+  runInterpolationTask((void*)&tasks[0]);
+  for (int t=1; t<nTasks; t++){
+    threads[t]->Join();
+    delete threads[t];
+  }
+  if (verbose_) cout << "Interpolated " << jobs.size() << " histograms from " << inputs.size() << " inputs with " << nTasks << " threads" << endl;
+
+  // make the output histograms, binning and errors are taken from the low mass input as in Interpolate
+  vector<TH1F*> outputs;
+  for (vector<interp_job_t>::iterator job=jobs.begin(); job!=jobs.end(); job++){
+    TH1F *interpolated = (TH1F*)inputs[job->low].hist->Clone();
+    interpolated->Scale(1./job->lowScale);
+    const double *out = &outContents[job->offset];
+    for (int i=0; i<interpolated->GetNbinsX(); i++) interpolated->SetBinContent(i+1,out[i]);
+    interpolated->SetName(job->name.c_str());
+    interpolated->Scale(job->factor);
+    if (verbose_) checkHisto(interpolated);
+    outputs.push_back(interpolated);
+  }
+
+  // MC masses are only renamed, with their normalization and efficiency made smoother
+  for (vector<double>::iterator mh=knownMasses.begin(); mh!=knownMasses.end(); mh++){
+    if (verbose_) cout << "Already know this mass " << *mh << endl;
+    for (vector<string>::iterator prod=productionTypes.begin(); prod!=productionTypes.end(); prod++){
+      TH1F *sig = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%3.1f_%3.1f",prod->c_str(),*mh,*mh));
+      sig->SetName(Form("th1f_sig_grad_%s_%3.1f",prod->c_str(),*mh));
+      double EffNorm = (efficiencyGraphs[*prod])->GetFunction("pol4")->Eval(*mh);
+      double XSnorm  = normalizer->GetXsection(*mh,sig->GetName())*normalizer->GetBR(*mh);
+      sig->Scale(EffNorm*XSnorm/sig->Integral());
+      if (verbose_) checkHisto(sig);
+      outputs.push_back(sig);
+      if (verbose_) cout << "["; printVec(theSystematics); cout << "]" << endl;
+      for (vector<string>::iterator syst=theSystematics.begin(); syst!=theSystematics.end(); syst++){
+        if (verbose_) cout << Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sUp01_sigma",prod->c_str(),*mh,*mh,syst->c_str()) << endl;
+        if (verbose_) cout << Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sDown01_sigma",prod->c_str(),*mh,*mh,syst->c_str()) << endl;
+        TH1F* up = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sUp01_sigma",prod->c_str(),*mh,*mh,syst->c_str()));
+        TH1F* down = (TH1F*)tFile->Get(Form("th1f_sig_grad_%s_%3.1f_%3.1f_%sDown01_sigma",prod->c_str(),*mh,*mh,syst->c_str()));
+        up->SetName(Form("th1f_sig_grad_%s_%3.1f_%sUp01_sigma",prod->c_str(),*mh,syst->c_str()));
+        down->SetName(Form("th1f_sig_grad_%s_%3.1f_%sDown01_sigma",prod->c_str(),*mh,syst->c_str()));
+        outputs.push_back(up);
+        outputs.push_back(down);
+      }
+    }
+  }
+
+  // write everything in one go
+  gDirectory->Cd(Form("%s:/",tFile->GetName()));
+  for (vector<TH1F*>::iterator out=outputs.begin(); out!=outputs.end(); out++){
+    (*out)->Write();
+  }
 }
@@ -1,44 +1,145 @@
 #include "Normalization_8TeV.h"
 
 #include "TSystem.h"
+#include "TMD5.h"
+
+#include <fstream>
+#include <sstream>
+#include <math.h>
 
 Normalization_8TeV::Normalization_8TeV(){
+  MassMin = 90.0;
+  MassStep = 0.1;
 }
 
 void Normalization_8TeV::Init(int sqrtS){
 
-    //TPython::Exec("import $(CMSSW_BASE).src.h2gglobe.AnalysisScripts.AnalysisScripts.python.buildSMHiggsSignalXSBR");
-    TPython::Exec("import os,imp");
+    // The tables are computed by buildSMHiggsSignalXSBR.py on a 0.1 GeV grid from 90 to 250 GeV.
+    // They are cached in a text file, so that only the first job needs python and the combine tools.
+    // The cache is looked for in the runtime aux directory, then in the temporary directory for read-only 
+    // release areas. It is only used if it was made by the same script with the same release.
+    const int nMass = 1601;
     const char * env = gSystem->Getenv("H2GGLOBE_RUNTIME");
     std::string globeRt = ( env != 0 ? env : H2GGLOBE_BASE "/AnalysisScripts");
-    if( ! TPython::Exec(Form("buildSMHiggsSignalXSBR = imp.load_source('*', '%s/python/buildSMHiggsSignalXSBR.py')",globeRt.c_str())) ) {
+    std::string script = globeRt + "/python/buildSMHiggsSignalXSBR.py";
+    TMD5 * md5 = TMD5::FileChecksum(script.c_str());
+    const char * release = gSystem->Getenv("CMSSW_VERSION");
+    std::string key = Form("%s %s", ( md5 != 0 ? md5->AsString() : "none" ), ( release != 0 ? release : "none" ));
+    delete md5;
+    
+    std::vector<std::string> cacheFiles;
+    cacheFiles.push_back( Form("%s/aux/SMHiggsSignalXSBR_%dTeV.txt",globeRt.c_str(),sqrtS) );
+    cacheFiles.push_back( Form("%s/SMHiggsSignalXSBR_%dTeV.txt",gSystem->TempDirectory(),sqrtS) );
+    
+    bool filled = false;
+    for(size_t ic=0; ic<cacheFiles.size() && ! filled; ++ic) {
+	filled = ReadTables(cacheFiles[ic],key) && (int)BranchingRatioTable.size() == nMass;
+    }
+    if( ! filled ) {
+	//TPython::Exec("import $(CMSSW_BASE).src.h2gglobe.AnalysisScripts.AnalysisScripts.python.buildSMHiggsSignalXSBR");
+	TPython::Exec("import os,imp");
+	if( ! TPython::Exec(Form("buildSMHiggsSignalXSBR = imp.load_source('*', '%s')",script.c_str())) ) {
 	    return;
+	}
+	TPython::Eval(Form("buildSMHiggsSignalXSBR.Init%dTeV()", sqrtS));
+	for(size_t ic=0; ic<cacheFiles.size() && ! filled; ++ic) {
+	    std::cout << "Normalization_8TeV: building the cross section and branching ratio tables in " << cacheFiles[ic] << std::endl;
+	    // written to a temporary file first, so that concurrent jobs never read a partial table
+	    std::string tmpFile = Form("%s.%d.tmp",cacheFiles[ic].c_str(),gSystem->GetPid());
+	    filled = TPython::Exec(Form("buildSMHiggsSignalXSBR.writeTable('%s','%s',%f,%d,%f)",tmpFile.c_str(),key.c_str(),MassMin,nMass,MassStep))
+		&& ReadTables(tmpFile,key) && (int)BranchingRatioTable.size() == nMass;
+	    if( ! filled || gSystem->Rename(tmpFile.c_str(),cacheFiles[ic].c_str()) != 0 ) {
+		gSystem->Unlink(tmpFile.c_str());
+	    }
+	}
+	if( ! filled ) {
+	    std::cout << "Normalization_8TeV: could not write the cross section and branching ratio tables, computing them in memory" << std::endl;
+	    FillTables(nMass);
+	}
     }
-    TPython::Eval(Form("buildSMHiggsSignalXSBR.Init%dTeV()", sqrtS));
     
-    for (double mH=90.0;mH<=250.0;mH+=0.1){ // Do we need this up to 250 ?
-	double valBR    =  (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getBR(%f)",mH));
-	double valXSggH =  (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"ggH"));
-	double valXSqqH =  (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"qqH"));
-	double valXSttH =  (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"ttH"));
-	double valXSWH  =  (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"WH"));
-	double valXSZH  =  (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"ZH"));
-	BranchingRatioMap[mH]	= valBR;
-        XSectionMap_ggh[mH]	= valXSggH; 	
-        XSectionMap_vbf[mH]	= valXSqqH; 	
-        XSectionMap_tth[mH]	= valXSttH; 	
-        XSectionMap_wh[mH]	= valXSWH; 	
-        XSectionMap_zh[mH]	= valXSZH;	
-        XSectionMap_wzh[mH]	= valXSWH+valXSZH;	
-	
+    XSectionTable_wzh.resize(nMass);
+    XSectionTable_sm.resize(nMass);
+    for (int i=0; i<nMass; ++i) {
+	XSectionTable_wzh[i] = XSectionTable_wh[i]+XSectionTable_zh[i];
+	//Graviton X-Sections - assume the same as SM
+	XSectionTable_sm[i] = XSectionTable_ggh[i]+XSectionTable_vbf[i]+XSectionTable_wzh[i]+XSectionTable_tth[i];
     }
+}
+
+void Normalization_8TeV::ClearTables(){
 
-    //Graviton X-Sections - assume the same as SM
-    for (std::map<double, double>::const_iterator iter = XSectionMap_ggh.begin(); iter != XSectionMap_ggh.end(); ++iter)
-      XSectionMap_sm[iter->first]=iter->second+XSectionMap_vbf[iter->first]+XSectionMap_wzh[iter->first]+XSectionMap_tth[iter->first];
-   
+  BranchingRatioTable.clear();
+  XSectionTable_ggh.clear();
+  XSectionTable_vbf.clear();
+  XSectionTable_tth.clear();
+  XSectionTable_wh.clear();
+  XSectionTable_zh.clear();
 }
 
+void Normalization_8TeV::FillTables(int nMass){
+
+  ClearTables();
+  for (int i=0; i<nMass; ++i) {
+    double mH = MassMin + i*MassStep;
+    BranchingRatioTable.push_back( (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getBR(%f)",mH)) );
+    XSectionTable_ggh.push_back( (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"ggH")) );
+    XSectionTable_vbf.push_back( (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"qqH")) );
+    XSectionTable_tth.push_back( (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"ttH")) );
+    XSectionTable_wh.push_back( (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"WH")) );
+    XSectionTable_zh.push_back( (double)TPython::Eval(Form("buildSMHiggsSignalXSBR.getXS(%f,'%s')",mH,"ZH")) );
+  }
+}
+
+bool Normalization_8TeV::ReadTables(const std::string & fname, const std::string & key){
+
+  ClearTables();
+  
+  std::ifstream in(fname.c_str());
+  if( ! in.good() ) { return false; }
+  // the first line tells what the table was made from
+  std::string line;
+  if( ! std::getline(in,line) || line != "# source " + key ) {
+    std::cout << "Normalization_8TeV: " << fname << " was made from a different source, ignoring it" << std::endl;
+    return false;
+  }
+  while( std::getline(in,line) ) {
+    if( line.empty() || line[0] == '#' ) { continue; }
+    std::istringstream row(line);
+    double mH, valBR, valXSggH, valXSqqH, valXSttH, valXSWH, valXSZH;
+    row >> mH >> valBR >> valXSggH >> valXSqqH >> valXSttH >> valXSWH >> valXSZH;
+    // the grid must be the one assumed by Interpolate
+    if( row.fail() || fabs(mH - (MassMin + BranchingRatioTable.size()*MassStep)) > 1.e-4 ) {
+      std::cout << "Normalization_8TeV: bad line in " << fname << ": " << line << std::endl;
+      ClearTables();
+      return false;
+    }
+    BranchingRatioTable.push_back(valBR);
+    XSectionTable_ggh.push_back(valXSggH);
+    XSectionTable_vbf.push_back(valXSqqH);
+    XSectionTable_tth.push_back(valXSttH);
+    XSectionTable_wh.push_back(valXSWH);
+    XSectionTable_zh.push_back(valXSZH);
+  }
+  return ! BranchingRatioTable.empty();
+}
+
+bool Normalization_8TeV::Interpolate(const std::vector<double> & table, double mass, double & val) const {
+
+  if( table.empty() ) { return false; }
+  double x = (mass-MassMin)/MassStep;
+  double xnode = floor(x+0.5);
+  int i = (int)xnode;
+  // grid points are returned as they are
+  if( fabs(x-xnode) < 1.e-6 && i >= 0 && i < (int)table.size() ) {
+    val = table[i];
+    return true;
+  }
+  i = (int)floor(x);
+  if( x < 0. || i+1 >= (int)table.size() ) { return false; }
+  val = (table[i+1]-table[i])*(x-i)+table[i];
+  return true;
+}
 
 void Normalization_8TeV::FillSignalTypes(){
 
@@ -132,30 +233,30 @@ void Normalization_8TeV::FillSignalTypes(){
 TGraph * Normalization_8TeV::GetSigmaGraph(TString process)
 {
   TGraph * gr = new TGraph();
-	std::map<double, double> * XSectionMap = 0 ;
+	std::vector<double> * XSectionTable = 0 ;
 	if ( process == "ggh") {
-		XSectionMap = &XSectionMap_ggh;
+		XSectionTable = &XSectionTable_ggh;
 	} else if ( process == "vbf") {
-		XSectionMap = &XSectionMap_vbf;
+		XSectionTable = &XSectionTable_vbf;
     } else if ( process == "vbfold") {
-      XSectionMap = &XSectionMap_vbfold;
+      XSectionTable = &XSectionTable_vbfold;
 	} else if ( process == "wzh") {
-		XSectionMap = &XSectionMap_wzh;
+		XSectionTable = &XSectionTable_wzh;
 	} else if ( process == "tth") {
-		XSectionMap = &XSectionMap_tth;
+		XSectionTable = &XSectionTable_tth;
 	} else if ( process == "wh") {
-		XSectionMap = &XSectionMap_wh;
+		XSectionTable = &XSectionTable_wh;
 	} else if ( process == "zh") {
-		XSectionMap = &XSectionMap_zh;
+		XSectionTable = &XSectionTable_zh;
 	} else if (process.Contains("grav")){
-    XSectionMap = &XSectionMap_sm;
+    XSectionTable = &XSectionTable_sm;
   } else {
     std::cout << "Warning ggh, vbf, wh, zh, wzh, tth or grav not found in histname!!!!" << std::endl;
     //exit(1);
   }
   
-  for (std::map<double, double>::const_iterator iter = XSectionMap->begin();  iter != XSectionMap->end(); ++iter) {
-    gr->SetPoint(gr->GetN(),iter->first, iter->second );
+  for (size_t i=0; i<XSectionTable->size(); ++i) {
+    gr->SetPoint(gr->GetN(), MassMin+i*MassStep, (*XSectionTable)[i] );
   }
 	
 	return gr;
@@ -164,29 +265,16 @@ TGraph * Normalization_8TeV::GetSigmaGraph(TString process)
 TGraph * Normalization_8TeV::GetBrGraph()
 {
 	TGraph * gr = new TGraph();
-	for (std::map<double, double>::const_iterator iter = BranchingRatioMap.begin();  iter != BranchingRatioMap.end(); ++iter) {
-		gr->SetPoint(gr->GetN(),iter->first, iter->second );
+	for (size_t i=0; i<BranchingRatioTable.size(); ++i) {
+		gr->SetPoint(gr->GetN(), MassMin+i*MassStep, BranchingRatioTable[i] );
 	}
 	return gr;
 }
 
 double Normalization_8TeV::GetBR(double mass) {
 
-  for (std::map<double, double>::const_iterator iter = BranchingRatioMap.begin();  iter != BranchingRatioMap.end(); ++iter) {
-    if (mass==iter->first) return iter->second;
-    if (mass>iter->first) {
-      double lowmass = iter->first;
-      double lowbr = iter->second;
-      ++iter;
-      if (mass<iter->first) {
-        double highmass = iter->first;
-        double highbr = iter->second;
-        double br = (highbr-lowbr)/(highmass-lowmass)*(mass-lowmass)+lowbr;
-        return br;
-      }
-      --iter;
-    }
-  }
+  double br;
+  if (Interpolate(BranchingRatioTable, mass, br)) return br;
   
   std::cout << "Warning branching ratio outside range of 90-250GeV!!!!" << std::endl;
   //std::exit(1);
@@ -194,47 +282,35 @@ double Normalization_8TeV::GetBR(double mass) {
   
 }
 
-
-double Normalization_8TeV::GetXsection(double mass, TString HistName) {
-
-  std::map<double,double> *XSectionMap;
+std::vector<double> * Normalization_8TeV::GetXsectionTable(const TString & HistName) {
 
   if (HistName.Contains("ggh")) {
-    XSectionMap = &XSectionMap_ggh;
+    return &XSectionTable_ggh;
   } else if (HistName.Contains("vbf") && !HistName.Contains("vbfold")) {
-    XSectionMap = &XSectionMap_vbf;
+    return &XSectionTable_vbf;
   } else if (HistName.Contains("vbfold")) {
-    XSectionMap = &XSectionMap_vbfold;
+    return &XSectionTable_vbfold;
   } else if (HistName.Contains("wh") && !HistName.Contains("wzh")) {
-    XSectionMap = &XSectionMap_wh;
+    return &XSectionTable_wh;
   } else if (HistName.Contains("zh") && !HistName.Contains("wzh")) {
-    XSectionMap = &XSectionMap_zh;
+    return &XSectionTable_zh;
   } else if (HistName.Contains("wzh")) {
-    XSectionMap = &XSectionMap_wzh;
+    return &XSectionTable_wzh;
   } else if (HistName.Contains("tth")) {
-    XSectionMap = &XSectionMap_tth;
+    return &XSectionTable_tth;
   } else if (HistName.Contains("grav")) {
-    XSectionMap = &XSectionMap_sm;
-  } else {
-    std::cout << "Warning ggh, vbf, wh, zh, wzh, tth or grav not found in " << HistName << std::endl;
-    //exit(1);
-  }
+    return &XSectionTable_sm;
+  } 
+  std::cout << "Warning ggh, vbf, wh, zh, wzh, tth or grav not found in " << HistName << std::endl;
+  //exit(1);
+  return 0;
+}
 
-  for (std::map<double, double>::const_iterator iter = XSectionMap->begin();  iter != XSectionMap->end(); ++iter) {
-    if (mass==iter->first) return iter->second;
-    if (mass>iter->first) {
-      double lowmass = iter->first;
-      double lowxsec = iter->second;
-      ++iter;
-      if (mass<iter->first) {
-        double highmass = iter->first;
-        double highxsec = iter->second;
-        double xsec = (highxsec-lowxsec)/(highmass-lowmass)*(mass-lowmass)+lowxsec;
-        return xsec;
-      }
-      --iter;
-    }
-  }
+double Normalization_8TeV::GetXsection(double mass, TString HistName) {
+
+  std::vector<double> *XSectionTable = GetXsectionTable(HistName);
+  double xsec;
+  if (XSectionTable != 0 && Interpolate(*XSectionTable, mass, xsec)) return xsec;
 
   std::cout << "Warning cross section outside range of 80-300GeV!!!!" << std::endl;
   //exit(1);
@@ -4,6 +4,7 @@
 #include <vector>
 #include <map>
 #include <iostream>
+#include <string>
 
 #include "TH1F.h"
 #include "TGraph.h"
@@ -43,15 +44,26 @@ class Normalization_8TeV {
 	
 	std::map<int,std::pair<TString,double > > & SignalType() { return SignalTypeMap; }
  private:
-	std::map<double,double> BranchingRatioMap;
-	std::map<double,double> XSectionMap_ggh;
-	std::map<double,double> XSectionMap_vbf;
-	std::map<double,double> XSectionMap_vbfold;
-	std::map<double,double> XSectionMap_wh;
-	std::map<double,double> XSectionMap_zh;
-	std::map<double,double> XSectionMap_wzh;
-	std::map<double,double> XSectionMap_tth;
-  	std::map<double,double> XSectionMap_sm;
+	// reads a table written by buildSMHiggsSignalXSBR.writeTable; false if it was not made from key
+	bool ReadTables(const std::string & fname, const std::string & key);
+	// computes the tables in memory, one python call per value
+	void FillTables(int nMass);
+	void ClearTables();
+	std::vector<double> * GetXsectionTable(const TString & HistName);
+	// linear interpolation in a table; false outside the mass range
+	bool Interpolate(const std::vector<double> & table, double mass, double & val) const;
+
+	// values on the regular mass grid MassMin + i*MassStep
+	double MassMin, MassStep;
+	std::vector<double> BranchingRatioTable;
+	std::vector<double> XSectionTable_ggh;
+	std::vector<double> XSectionTable_vbf;
+	std::vector<double> XSectionTable_vbfold;
+	std::vector<double> XSectionTable_wh;
+	std::vector<double> XSectionTable_zh;
+	std::vector<double> XSectionTable_wzh;
+	std::vector<double> XSectionTable_tth;
+  	std::vector<double> XSectionTable_sm;
 
 	std::map<int,std::pair<TString,double > > SignalTypeMap;
 	
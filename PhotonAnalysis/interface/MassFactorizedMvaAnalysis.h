@@ -14,6 +14,7 @@
 #include "KFactorSmearer.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include "math.h"
 
 // ------------------------------------------------------------------------------------
@@ -33,6 +34,9 @@ class MassFactorizedMvaAnalysis : public StatAnalysis
     virtual int GetBDTBoundaryCategory(float,bool,bool);
 
     virtual void ResetAnalysis();
+
+    virtual BaseAnalysis * Clone() const { return new MassFactorizedMvaAnalysis(*this); };
+    virtual void MergeClone(BaseAnalysis &);
     //// virtual void Analysis(LoopAll&, Int_t); 
 
     void fillZeeControlPlots(const TLorentzVector & lead_p4, const  TLorentzVector & sublead_p4, 
@@ -76,6 +80,32 @@ class MassFactorizedMvaAnalysis : public StatAnalysis
 		      float syst_shift=0., bool skipSelection=false,
 		      BaseGenLevelSmearer *genSys=0, BaseSmearer *phoSys=0, BaseDiPhotonSmearer * diPhoSys=0); 
 
+    // Diphoton MVA results of the current event, keyed on the diphoton, its vertex and the state of the two 
+    //   photons entering the MVA inputs. Passes over the event (preselection, exclusive tags, systematic shifts) 
+    //   leaving both photons of a diphoton untouched reuse the first evaluation.
+#ifndef __CINT__
+    struct diphoMvaKey_t {
+	int diphoton, vertex;
+	float photons[8]; // smeared energy, energy, energy error and r9 of the leading and subleading photons
+	bool operator<(const diphoMvaKey_t & o) const {
+	    if( diphoton != o.diphoton ) { return diphoton < o.diphoton; }
+	    if( vertex != o.vertex ) { return vertex < o.vertex; }
+	    return std::lexicographical_compare(photons, photons+8, o.photons, o.photons+8);
+	};
+    };
+    struct diphoMvaEntry_t {
+	diphoMvaEntry_t() : hasInputs(false), hasMva(false) {};
+	bool hasInputs, hasMva;
+	float phoidLead, phoidSublead, vtxProb;
+	float mva, sigmaMrv, sigmaMwv;
+	std::vector<Float_t> mvaInputs;
+    };
+    std::map<diphoMvaKey_t,diphoMvaEntry_t> diphoMvaCache_;
+    diphoMvaEntry_t * diphoMvaCacheEntry(LoopAll & l, int diphotonId);
+#endif
+    int diphoMvaCacheRun_, diphoMvaCacheLumis_, diphoMvaCacheEvent_;
+    Long64_t diphoMvaCacheHits_, diphoMvaCacheMisses_;
+
     EnergySmearer  *eRegressionSmearer ; 
     DiPhoEfficiencySmearer *photonMvaIdSmearer ;
     
@@ -15,6 +15,9 @@
 #include "TMVA/Reader.h"
 #include "PhotonFix.h"
 #include <stdio.h>
+#include <math.h>
+#include <fstream>
+#include <cstdio>
 // #include "HiggsToGammaGamma/interface/GBRForest.h"
 //#include "../../../../HiggsToGammaGamma/interface/GBRForest.h"
 //#include "HiggsAnalysis/HiggsToGammaGamma/interface/GBRForest.h"
@@ -24,12 +27,44 @@
 #include "RooAbsPdf.h"
 //#include "HiggsAnalysis/GBRLikelihoodEGTools/interface/EGEnergyCorrectorSemiParm.h"
 #include "HiggsAnalysis/GBRLikelihood/interface/RooHybridBDTAutoPdf.h"
-#include "HiggsAnalysis/GBRLikelihood/interface/RooDoubleCBFast.h"
 #include "HiggsAnalysis/GBRLikelihood/interface/HybridGBRForest.h"
 #include "HiggsAnalysis/GBRLikelihood/interface/HybridGBRForestD.h"
 
 class JetHandler;
 
+// ------------------------------------------------------------------------------------
+// ofstream which can be copied along with the analysis when this is cloned for 
+// multi-threaded running. The copy is not attached to any file: the clone opens its 
+// own file (see LoopAll::WorkerFileName), which is then appended to the one of the 
+// main analysis with Append and deleted with Remove.
+class CloneableOfstream : public std::ofstream
+{
+ public:
+    CloneableOfstream() {};
+    CloneableOfstream(const CloneableOfstream &) : std::ofstream() {};
+
+    void open(const std::string & name) { fileName_ = name; std::ofstream::open(name.c_str()); };
+
+    // copies what the other stream wrote so far at the end of this one and empties its file
+    void Append(CloneableOfstream & other) {
+	if( other.fileName_.empty() ) { return; }
+	other.close();
+	std::ifstream in(other.fileName_.c_str());
+	if( is_open() && in.peek() != EOF ) { *this << in.rdbuf(); }
+	in.close();
+	other.std::ofstream::open(other.fileName_.c_str());
+    };
+    void Remove() {
+	if( fileName_.empty() ) { return; }
+	close();
+	std::remove(fileName_.c_str());
+	fileName_.clear();
+    };
+
+ private:
+    std::string fileName_;
+};
+
 // ------------------------------------------------------------------------------------
 class PhotonAnalysis : public BaseAnalysis
 {
@@ -57,6 +92,8 @@ class PhotonAnalysis : public BaseAnalysis
 
     virtual void ResetAnalysis();
 
+    virtual BaseAnalysis * Clone() const { return new PhotonAnalysis(*this); };
+
     float zero_;
     void GetRegressionCorrections(LoopAll&);
     void GetRegressionCorrectionsV5(LoopAll&); // 8 TeV
@@ -84,6 +121,8 @@ class PhotonAnalysis : public BaseAnalysis
     bool doTriggerSelection;
     bool useRunDTriggersForZee;
     std::vector<TriggerSelection> triggerSelections;
+    // run, input file and trigger selection for which the HLT menu was last resolved
+    int triggerMenuRun_, triggerMenuFile_, triggerMenuSel_;
 
     // Options
     float phoidMvaCut;
@@ -531,8 +570,8 @@ class PhotonAnalysis : public BaseAnalysis
     bool PhotonMatchElectron(LoopAll& l, TLorentzVector* pho_p4, int& el_match_ind);
     bool HLTPhotonPreselection(LoopAll& l, TLorentzVector* pho_p4, int phoind);
 
-    ofstream met_sync;
-    ofstream lep_sync;
+    CloneableOfstream met_sync;
+    CloneableOfstream lep_sync;
 
     // Pile-up reweighing
     void loadPuMap(const char * fname, TDirectory * dir, TH1 * target=0);
@@ -621,6 +660,63 @@ class PhotonAnalysis : public BaseAnalysis
     EnergySmearer *eCorrSmearer;      // corrections for energy scale  MC
     std::vector<float> corrected_pho_energy;
     std::vector<PhotonReducedInfo> photonInfoCollection;
+    // event the photonInfoCollection was filled for. Kept in the analysis, so that every worker clone has its own
+    int photonInfoRun_, photonInfoLumis_, photonInfoEvent_;
+    // warnings left to print about negative smearing weights
+    int genLevelSmearingWarnings_, singlePhotonSmearingWarnings_, diPhotonSmearingWarnings_;
+    // prompt/fake photon composition of the skimmed MC, booked as global histograms by SkimEvents
+    TH1F *promptFakeFractions_, *promptMotherStatus_, *fakeMotherStatus_;
+
+#ifndef __CINT__
+    // Nominal single photon smearing of the current event: state of each photon and cumulated weight in front of 
+    //  each smearer. Systematic variations restart the chain from the smearer under study.
+    struct smearedPhotonState_t {
+	TVector3 caloPosition;
+	float energy, corrEnergy, corrEnergyErr, r9, weight;
+	int iDet;
+	void save(const PhotonReducedInfo & pho, float pweight) {
+	    caloPosition = pho.caloPosition(), iDet = pho.iDet(), r9 = pho.r9(), weight = pweight;
+	    energy = pho.energy(), corrEnergy = pho.corrEnergy(), corrEnergyErr = pho.corrEnergyErr();
+	};
+	float restore(PhotonReducedInfo & pho) const {
+	    pho.setCaloPosition(caloPosition), pho.setDet(iDet), pho.setR9(r9);
+	    pho.setEnergy(energy), pho.setCorrEnergy(corrEnergy), pho.setCorrEnergyErr(corrEnergyErr);
+	    return weight;
+	};
+    };
+    std::vector<smearedPhotonState_t> preparedPhotonStates_;
+#endif
+    int preparedRun_, preparedLumis_, preparedEvent_, preparedNpho_;
+
+    // Values of syst_shift scanned by the systematics loops. Smearers are evaluated once for all of them 
+    //   the first time a shift is requested for a given input, and the other shifts are read back from the batch.
+    std::vector<float> systShifts_;
+    int systShiftIndex(float syst_shift) const;
+#ifndef __CINT__
+    struct photonSmearingBatch_t {
+	const BaseSmearer * smearer;
+	std::vector<char> status; // per photon: 0 not evaluated, 1 batched, 2 not supported by the smearer
+	std::vector<float> energies, weights;
+    };
+    photonSmearingBatch_t photonBatch_;
+    struct diPhotonSmearingBatch_t {
+	const BaseDiPhotonSmearer * smearer;
+	TLorentzVector p4;
+	TVector3 vtx, truevtx;
+	int category, cur_type;
+	float idmva1, idmva2;
+	bool ok;
+	std::vector<float> weights, idMVA1, idMVA2;
+    };
+    diPhotonSmearingBatch_t diPhotonBatch_;
+    struct genLevelSmearingBatch_t {
+	const BaseGenLevelSmearer * smearer;
+	TLorentzVector p4;
+	int npu, sample_type;
+	std::vector<float> weights;
+    };
+    genLevelSmearingBatch_t genLevelBatch_;
+#endif
 
 
 
@@ -646,22 +742,20 @@ class PhotonAnalysis : public BaseAnalysis
     HybridGBRForestD *_forestDeb;
     HybridGBRForestD *_forestDee;
 
-    RooRealVar *_mean;
-    RooRealVar *_tgt;
-    RooRealVar *_sigma;
-    RooRealVar *_n1;
-    RooRealVar *_n2;  
-    
-    RooAbsReal *_meanlim;
-    RooAbsReal *_sigmalim;
-    RooAbsReal *_n1lim;
-    RooAbsReal *_n2lim;        
-    RooAbsReal *alpha1;
-    RooAbsReal *alpha2;        
-    
-    RooAbsPdf *_pdf;
-    
-    RooArgList _args;
+    // the raw forest outputs are mapped into the allowed ranges of the double Crystal Ball parameters
+    // as RooRealConstraint does: offset + scale * sin(output)
+    static double regressionConstraint(double raw, double low, double high) {
+        double scale = 0.5*(high-low);
+        double offset = low + scale;
+        return offset + scale*sin(raw);
+    };
+#ifndef __CINT__
+    // mean and sigma of the energy response; the tail parameters do not enter the corrections
+    template<class ForestT> void regressionMeanSigma(ForestT * forest, const float * vals, double & mean, double & sigma) const {
+        sigma = regressionConstraint(forest->GetResponse(vals,0),0.0002,0.5);
+        mean = regressionConstraint(forest->GetResponse(vals,1),0.2,2.0);
+    };
+#endif
     
 
     //TFile *fgbr;
@@ -38,6 +38,10 @@ class StatAnalysis : public PhotonAnalysis
     
     virtual bool SelectEvents(LoopAll&, int);
     virtual void ResetAnalysis();
+
+    virtual BaseAnalysis * Clone() const { return new StatAnalysis(*this); };
+    virtual void MergeClone(BaseAnalysis &);
+    virtual void MergeCloneOutput(BaseAnalysis &);
     virtual bool Analysis(LoopAll&, Int_t);
     
     std::string efficiencyFile;
@@ -146,6 +150,56 @@ class StatAnalysis : public PhotonAnalysis
               int category, bool rightvtx, float evweight , TVector3* vtx, LoopAll &, 
               int muVtx=-1, int mu_ind=-1, int elVtx=-1, int el_ind=-1, float bdtoutput=-10);
 
+    // handles of the histograms filled for every event by fillControlPlots
+    enum controlPlot_t { cp_all_mass=0, cp_diphobdt, cp_process_id, cp_mass, cp_eta, cp_pt, cp_pt_rv, cp_nvtx, cp_nvtx_rv,
+			 cp_probmva_pt, cp_probmva_nvtx, cp_probmva_rv_nvtx, cp_vtxprob_pt, cp_vtxprob_nvtx, cp_vtx_nconv,
+			 cp_pho_pt, cp_pho1_pt, cp_pho2_pt, cp_pho_eta, cp_pho1_eta, cp_pho2_eta, cp_pho_r9, cp_pho1_r9, cp_pho2_r9,
+			 cp_pho_n, cp_pho_rawe, cp_uncorrmet, cp_uncorrmetPhi, cp_corrmet, cp_corrmetPhi,
+			 cp_vbf_mva, cp_vbf_mva0, cp_vbf_mva1, cp_vbf_mva2, cp_rho, 
+			 cp_vtx_mva, cp_vtx_dz=cp_vtx_mva+5, cp_nControlPlots=cp_vtx_dz+5 };
+    std::vector<int> controlPlotHandles_;
+    void resolveControlPlotHandles(LoopAll &);
+
+    // slots of the flat tree branches filled by fillOpTree, bound once by name in Init: fillOpTreeSlot writes
+    // to them directly and fills by name only the branches booked with another type (or not booked at all)
+    enum opTreeBranch_t { ot_njets10=0, ot_njets15, ot_njets20, ot_dRphojet1, ot_dRphojet2, ot_run, ot_lumis,
+                          ot_event, ot_itype, ot_nvtx, ot_rho, ot_xsec_weight, ot_full_weight, ot_pu_weight,
+                          ot_pu_n, ot_mass, ot_dipho_pt, ot_full_cat, ot_et1, ot_et2, ot_eta1, ot_eta2, ot_r91,
+                          ot_r92, ot_sieie1, ot_sieie2, ot_hoe1, ot_hoe2, ot_sigmaEoE1, ot_sigmaEoE2, ot_ptoM1,
+                          ot_ptoM2, ot_isEB1, ot_isEB2, ot_chiso1, ot_chiso2, ot_chisow1, ot_chisow2, ot_phoiso1,
+                          ot_phoiso2, ot_phoiso041, ot_phoiso042, ot_ecaliso03_1, ot_ecaliso03_2, ot_hcaliso03_1,
+                          ot_hcaliso03_2, ot_trkiso03_1, ot_trkiso03_2, ot_pfchiso2_1, ot_pfchiso2_2, ot_sieip1,
+                          ot_sieip2, ot_etawidth1, ot_phiwidth1, ot_etawidth2, ot_phiwidth2, ot_regrerr1,
+                          ot_regrerr2, ot_cosphi, ot_genmatch1, ot_genmatch2, ot_cicpf4cutlevel1,
+                          ot_cicpf4cutlevel2, ot_idmva1, ot_idmva2, ot_vbfcat, ot_MET, ot_MET_phi, ot_isorv1,
+                          ot_isowv1, ot_isorv2, ot_isowv2, ot_s4ratio1, ot_s4ratio2, ot_effSigma1, ot_effSigma2,
+                          ot_scraw1, ot_scraw2, ot_vtx_x, ot_vtx_y, ot_vtx_z, ot_gv_x, ot_gv_y, ot_gv_z,
+                          ot_dijet_leadEta, ot_dijet_subleadEta, ot_dijet_LeadJPt, ot_dijet_SubJPt, ot_dijet_dEta,
+                          ot_dijet_Zep, ot_dijet_dPhi, ot_dijet_Mjj, ot_dijet_MVA, ot_issyst, ot_sigmaMrvoM,
+                          ot_sigmaMwvoM, ot_vtxprob, ot_ptbal, ot_ptasym, ot_logspt2, ot_p2conv, ot_nconv,
+                          ot_vtxmva, ot_vtxdz, ot_dipho_mva, ot_dipho_mva_cat, ot_nOpTreeBranches };
+    struct opTreeSlot_t {
+	opTreeSlot_t() : name(0), f(0), d(0), i(0) {};
+	const char * name;
+	float * f;
+	double * d;
+	int * i;
+    };
+    std::vector<opTreeSlot_t> opTreeSlots_;
+    void bindOpTreeSlots(LoopAll &);
+    void fillOpTreeSlot(LoopAll & l, int ib, float x) {
+	opTreeSlot_t & slot = opTreeSlots_[ib];
+	if( slot.f ) { *slot.f = x; } else if( slot.d ) { *slot.d = x; } else { l.FillTree(slot.name, x); }
+    };
+    void fillOpTreeSlot(LoopAll & l, int ib, double x) {
+	opTreeSlot_t & slot = opTreeSlots_[ib];
+	if( slot.d ) { *slot.d = x; } else if( slot.f ) { *slot.f = x; } else { l.FillTree(slot.name, x); }
+    };
+    void fillOpTreeSlot(LoopAll & l, int ib, int x) {
+	opTreeSlot_t & slot = opTreeSlots_[ib];
+	if( slot.i ) { *slot.i = x; } else { l.FillTree(slot.name, x); }
+    };
+
     void fillSignalEfficiencyPlots(float weight, LoopAll & l );
 
     void rescaleClusterVariables(LoopAll &l);
@@ -177,7 +231,7 @@ class StatAnalysis : public PhotonAnalysis
     // RooStuff
     RooContainer *rooContainer;
 
-    ofstream eventListText;
+    CloneableOfstream eventListText;
     //vector<double> weights;
     TFile *kfacFile;
     
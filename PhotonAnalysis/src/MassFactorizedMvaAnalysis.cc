@@ -20,6 +20,9 @@ MassFactorizedMvaAnalysis::MassFactorizedMvaAnalysis()  :
     forceStdPlotsOnZee = false;
     doInterferenceSmear=false;
     doCosThetaDependentInterferenceSmear=false;
+
+    diphoMvaCacheRun_ = diphoMvaCacheLumis_ = diphoMvaCacheEvent_ = -1;
+    diphoMvaCacheHits_ = diphoMvaCacheMisses_ = 0;
 }
 
 // ----------------------------------------------------------------------------------------------------
@@ -43,6 +46,7 @@ void MassFactorizedMvaAnalysis::Term(LoopAll& l)
 
     eventListText.close();
     std::cout << " nevents " <<  nevents << " " << sumwei << std::endl;
+    std::cout << " diphoton MVA cache hits " << diphoMvaCacheHits_ << " misses " << diphoMvaCacheMisses_ << std::endl;
     
     // default categories: Jan16
     bdtCategoryBoundaries.push_back(-0.05);
@@ -52,6 +56,15 @@ void MassFactorizedMvaAnalysis::Term(LoopAll& l)
     bdtCategoryBoundaries.push_back(1.);
 }
 
+// ----------------------------------------------------------------------------------------------------
+void MassFactorizedMvaAnalysis::MergeClone(BaseAnalysis & clone)
+{
+    StatAnalysis::MergeClone(clone);
+    MassFactorizedMvaAnalysis & other = dynamic_cast<MassFactorizedMvaAnalysis &>(clone);
+    diphoMvaCacheHits_ += other.diphoMvaCacheHits_;
+    diphoMvaCacheMisses_ += other.diphoMvaCacheMisses_;
+}
+
 // ----------------------------------------------------------------------------------------------------
 void MassFactorizedMvaAnalysis::Init(LoopAll& l) 
 {
@@ -94,6 +107,7 @@ void MassFactorizedMvaAnalysis::Init(LoopAll& l)
         << std::endl;
 
     PhotonAnalysis::Init(l);
+    bindOpTreeSlots(l);
 
     // Avoid reweighing from histo conainer
     for(size_t ind=0; ind<l.histoContainer.size(); ind++) {
@@ -469,8 +483,42 @@ void MassFactorizedMvaAnalysis::Init(LoopAll& l)
 
 
 
+MassFactorizedMvaAnalysis::diphoMvaEntry_t * MassFactorizedMvaAnalysis::diphoMvaCacheEntry(LoopAll & l, int diphotonId) {
+
+    // the sigmaE rescaling modifies the photons every time the MVA is computed: no caching
+    if( applySigmaECorrection ) { return 0; }
+
+    if( l.run != diphoMvaCacheRun_ || l.lumis != diphoMvaCacheLumis_ || l.event != diphoMvaCacheEvent_ ) {
+        diphoMvaCache_.clear();
+        diphoMvaCacheRun_ = l.run, diphoMvaCacheLumis_ = l.lumis, diphoMvaCacheEvent_ = l.event;
+    }
+
+    diphoMvaKey_t key;
+    key.diphoton = diphotonId;
+    key.vertex = l.dipho_vtxind[diphotonId];
+    int phos[2] = { l.dipho_leadind[diphotonId], l.dipho_subleadind[diphotonId] };
+    for(int ii=0; ii<2; ++ii) {
+        PhotonReducedInfo & info = photonInfoCollection[phos[ii]];
+        key.photons[4*ii]   = smeared_pho_energy[phos[ii]];
+        key.photons[4*ii+1] = info.energy();
+        key.photons[4*ii+2] = info.corrEnergyErr();
+        key.photons[4*ii+3] = info.r9();
+    }
+    return &diphoMvaCache_[key];
+}
+
 float MassFactorizedMvaAnalysis::GetDiphoMva(LoopAll & l, int diphotonId, bool doMCSmearinglocal, float syst_shift) {
     
+    diphoMvaEntry_t * cached = diphoMvaCacheEntry(l, diphotonId);
+    if( cached != 0 && cached->hasMva ) {
+        ++diphoMvaCacheHits_;
+        sigmaMrv = cached->sigmaMrv;
+        sigmaMwv = cached->sigmaMwv;
+        l.tmva_dipho_MIT_buf = cached->mvaInputs;
+        l.tmva_dipho_MIT_cache[diphotonId] = cached->mvaInputs;
+        return cached->mva;
+    }
+
     int cur_type = l.itype[l.current];
     
     TLorentzVector lead_p4, sublead_p4, Higgs;
@@ -573,9 +621,18 @@ float MassFactorizedMvaAnalysis::GetDiphoMva(LoopAll & l, int diphotonId, bool d
         phoid_mvaout_sublead = idmvascale->Eval(phoid_mvaout_sublead);
     }
     
-    return l.diphotonMVA(diphotonId,l.dipho_leadind[diphotonId],l.dipho_subleadind[diphotonId],l.dipho_vtxind[diphotonId] ,
-			 vtxProb,lead_p4,sublead_p4,sigmaMrv,sigmaMwv,sigmaMrv,bdtTrainingPhilosophy.c_str(),bdtTrainingType.c_str(),
-			 phoid_mvaout_lead,phoid_mvaout_sublead);
+    float mva = l.diphotonMVA(diphotonId,l.dipho_leadind[diphotonId],l.dipho_subleadind[diphotonId],l.dipho_vtxind[diphotonId] ,
+			      vtxProb,lead_p4,sublead_p4,sigmaMrv,sigmaMwv,sigmaMrv,bdtTrainingPhilosophy.c_str(),bdtTrainingType.c_str(),
+			      phoid_mvaout_lead,phoid_mvaout_sublead);
+    if( cached != 0 ) {
+        ++diphoMvaCacheMisses_;
+        cached->hasMva = true;
+        cached->mva = mva;
+        cached->sigmaMrv = sigmaMrv;
+        cached->sigmaMwv = sigmaMwv;
+        cached->mvaInputs = l.tmva_dipho_MIT_buf;
+    }
+    return mva;
 }
 
 
@@ -2117,12 +2174,28 @@ void MassFactorizedMvaAnalysis::ComputeDiphoMvaInputs(LoopAll &l, float &phoid_m
     sigmaMwv = massResolutionCalculator->massResolutionWrongVtx();
     
     vtxAna_.setPairID(diphoton_id); 
+
+    // vertex probability and photon ID are stored along with the diphoton MVA
+    diphoMvaEntry_t * cached = diphoMvaCacheEntry(l, diphoton_id);
+    if( cached != 0 && cached->hasInputs ) {
+        vtxProb = cached->vtxProb;
+        phoid_mvaout_lead = cached->phoidLead;
+        phoid_mvaout_sublead = cached->phoidSublead;
+        return;
+    }
+
     vtxProb = vtxAna_.vertexProbability(vtx_mva);
     
     phoid_mvaout_lead = l.photonIDMVA(l.dipho_leadind[diphoton_id],l.dipho_vtxind[diphoton_id], 
 				      lead_p4,bdtTrainingType.c_str());
     phoid_mvaout_sublead = l.photonIDMVA(l.dipho_subleadind[diphoton_id],l.dipho_vtxind[diphoton_id],
 					 sublead_p4,bdtTrainingType.c_str());
+    if( cached != 0 ) {
+        cached->hasInputs = true;
+        cached->vtxProb = vtxProb;
+        cached->phoidLead = phoid_mvaout_lead;
+        cached->phoidSublead = phoid_mvaout_sublead;
+    }
     return;
 }
 
@@ -4,6 +4,7 @@
 
 #include "PhotonReducedInfo.h"
 #include "Sorters.h"
+#include "RootLock.h"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -38,6 +39,7 @@ Double_t CosAngle(TLorentzVector& p4_1, TLorentzVector& p4_2)
 // ----------------------------------------------------------------------------------------------------
 PhotonAnalysis::PhotonAnalysis()  :
     runStatAnalysis(false), doTriggerSelection(false),
+    triggerMenuRun_(-1), triggerMenuFile_(-1), triggerMenuSel_(-1),
     name_("PhotonAnalysis"),
     vtxAna_(vtxAlgoParams), vtxConv_(vtxAlgoParams),
     tmvaPerVtxMethod("BDTG"),
@@ -49,6 +51,11 @@ PhotonAnalysis::PhotonAnalysis()  :
     addConversionToMva=true;
     mvaVertexSelection=false;
     useDefaultVertex=false;
+    preparedRun_=-1, preparedLumis_=-1, preparedEvent_=-1, preparedNpho_=-1;
+    photonInfoRun_=-1, photonInfoLumis_=-1, photonInfoEvent_=-1;
+    genLevelSmearingWarnings_=10, singlePhotonSmearingWarnings_=10, diPhotonSmearingWarnings_=10;
+    promptFakeFractions_=0, promptMotherStatus_=0, fakeMotherStatus_=0;
+    photonBatch_.smearer=0, diPhotonBatch_.smearer=0, genLevelBatch_.smearer=0;
     forcedRho = -1.;
 
     reRunVtx = false;
@@ -446,14 +453,32 @@ float PhotonAnalysis::getPuWeight(int n_pu, int sample_type, SampleContainer* co
 //    return 1.;
 //}
 
+// ----------------------------------------------------------------------------------------------------
+int PhotonAnalysis::systShiftIndex(float syst_shift) const
+{
+    std::vector<float>::const_iterator it = std::find(systShifts_.begin(), systShifts_.end(), syst_shift);
+    return ( it == systShifts_.end() ? -1 : it - systShifts_.begin() );
+}
+
 // ----------------------------------------------------------------------------------------------------
 void PhotonAnalysis::applyGenLevelSmearings(double & genLevWeight, const TLorentzVector & gP4, int npu, int sample_type, BaseGenLevelSmearer * sys, float syst_shift)
 {
-    static int nwarnings=10;
+    int & nwarnings = genLevelSmearingWarnings_;
     for(std::vector<BaseGenLevelSmearer*>::iterator si=genLevelSmearers_.begin(); si!=genLevelSmearers_.end(); si++){
     float genWeight=1;
     if( sys != 0 && *si == *sys ) {
-        (*si)->smearEvent(genWeight, gP4, npu, sample_type, syst_shift );
+        int ishift = systShiftIndex(syst_shift);
+        if( ishift >= 0 ) {
+            genLevelSmearingBatch_t & batch = genLevelBatch_;
+            if( batch.smearer != *si || batch.p4 != gP4 || batch.npu != npu || batch.sample_type != sample_type ) {
+                batch.smearer = *si, batch.p4 = gP4, batch.npu = npu, batch.sample_type = sample_type;
+                batch.weights.assign(systShifts_.size(),1.);
+                (*si)->smearEventShifts(gP4, npu, sample_type, systShifts_.size(), &systShifts_[0], &batch.weights[0] );
+            }
+            genWeight = batch.weights[ishift];
+        } else {
+            (*si)->smearEvent(genWeight, gP4, npu, sample_type, syst_shift );
+        }
     } else {
         (*si)->smearEvent(genWeight, gP4, npu, sample_type, 0. );
     }
@@ -482,14 +507,13 @@ void PhotonAnalysis::applySinglePhotonSmearings(std::vector<float> & smeared_pho
 
     )
 {
-    static int nwarnings = 10;
-    static int cache_run = -1, cache_lumis = -1, cache_event = -1;
+    int & nwarnings = singlePhotonSmearingWarnings_;
     bool fillInfo = false;
-    if( l.run != cache_run || l.lumis != cache_lumis || l.event != cache_event ) {
+    if( l.run != photonInfoRun_ || l.lumis != photonInfoLumis_ || l.event != photonInfoEvent_ ) {
 	fillInfo = true;
-	cache_run   = l.run  ;
-	cache_lumis = l.lumis;
-	cache_event = l.event;
+	photonInfoRun_   = l.run  ;
+	photonInfoLumis_ = l.lumis;
+	photonInfoEvent_ = l.event;
     }
 
     /// if( sys ) std::cout << "applySinglePhotonSmearings " << fillInfo << " " << syst_shift << " " << ( sys != 0 ? sys->name() : " " ) <<std::endl;
@@ -497,6 +521,36 @@ void PhotonAnalysis::applySinglePhotonSmearings(std::vector<float> & smeared_pho
     if( fillInfo ) {
 	photonInfoCollection.clear();
     }
+
+    // The nominal pass records the state of the photons in front of each smearer. Systematic passes on the same
+    //   event then restart from the smearer under study (or from the first one modifying other smearers).
+    bool doSmearing = ( cur_type != 0 && doMCSmearing );
+    int nsmearers = photonSmearers_.size();
+    bool prepare = doSmearing && sys == 0 && syst_shift == 0.;
+    int firstSmearer = 0, batchShift = -1;
+    if( prepare ) {
+	preparedPhotonStates_.resize(l.pho_n*(nsmearers+1));
+	preparedRun_ = l.run, preparedLumis_ = l.lumis, preparedEvent_ = l.event, preparedNpho_ = l.pho_n;
+	photonBatch_.smearer = 0;
+    } else if( doSmearing && sys != 0 && preparedRun_ == l.run && preparedLumis_ == l.lumis && preparedEvent_ == l.event 
+	       && preparedNpho_ == l.pho_n ) {
+	for(; firstSmearer<nsmearers; ++firstSmearer) {
+	    BaseSmearer * smearer = photonSmearers_[firstSmearer];
+	    if( smearer == *sys || smearer->hasSideEffects() ) { break; }
+	}
+	// when the chain restarts from the smearer under study, its input is the same for all the shifts
+	//   and the smearer can be evaluated for all of them at once
+	if( firstSmearer < nsmearers && photonSmearers_[firstSmearer] == *sys ) {
+	    batchShift = systShiftIndex(syst_shift);
+	    if( batchShift >= 0 && photonBatch_.smearer != sys ) {
+		photonBatch_.smearer = sys;
+		photonBatch_.status.assign(l.pho_n,0);
+		photonBatch_.energies.resize(l.pho_n*systShifts_.size());
+		photonBatch_.weights.resize(l.pho_n*systShifts_.size());
+	    }
+	}
+    }
+
     smeared_pho_energy.resize(l.pho_n,0.);
     smeared_pho_r9.resize(l.pho_n,0.);
     smeared_pho_weight.resize(l.pho_n,0.);
@@ -528,10 +582,26 @@ void PhotonAnalysis::applySinglePhotonSmearings(std::vector<float> & smeared_pho
 
         float pweight = 1.;
         // smear MC. But apply energy corrections and scale adjustement to data
-        if( cur_type != 0 && doMCSmearing ) {
-            for(std::vector<BaseSmearer *>::iterator si=photonSmearers_.begin(); si!= photonSmearers_.end(); ++si ) {
+        if( doSmearing ) {
+	    smearedPhotonState_t * state = ( preparedPhotonStates_.empty() ? 0 : &preparedPhotonStates_[ipho*(nsmearers+1)] );
+	    if( firstSmearer > 0 ) {
+		// smearers in front of firstSmearer all take their nominal values
+		pweight = state[firstSmearer].restore(phoInfo);
+	    }
+            for(std::vector<BaseSmearer *>::iterator si=photonSmearers_.begin()+firstSmearer; si!= photonSmearers_.end(); ++si ) {
+		if( prepare ) { state[si-photonSmearers_.begin()].save(phoInfo,pweight); }
                 float sweight = 1.;
-		if( sys != 0 && *si == *sys ) {
+		char * batched = ( batchShift >= 0 && si-photonSmearers_.begin() == firstSmearer ? &photonBatch_.status[ipho] : 0 );
+		if( batched != 0 && *batched == 0 ) {
+		    int nshifts = systShifts_.size();
+		    float * energies = &photonBatch_.energies[ipho*nshifts], * weights = &photonBatch_.weights[ipho*nshifts];
+		    std::fill(weights, weights+nshifts, 1.);
+		    *batched = ( (*si)->smearPhotonShifts(phoInfo,l.run,nshifts,&systShifts_[0],energies,weights) ? 1 : 2 );
+		}
+		if( batched != 0 && *batched == 1 ) {
+		    phoInfo.setEnergy(photonBatch_.energies[ipho*systShifts_.size()+batchShift]);
+		    sweight = photonBatch_.weights[ipho*systShifts_.size()+batchShift];
+		} else if( sys != 0 && *si == *sys ) {
 		    // move the smearer under study by syst_shift
 		    (*si)->smearPhoton(phoInfo,sweight,l.run,syst_shift);
 		    /// if( sys ) {
@@ -557,6 +627,7 @@ void PhotonAnalysis::applySinglePhotonSmearings(std::vector<float> & smeared_pho
 		}
 		pweight *= sweight;
             }
+	    if( prepare ) { state[nsmearers].save(phoInfo,pweight); }
         } else if( cur_type == 0 ) {
             float sweight = 1.;
             if( doEcorrectionSmear )  {
@@ -643,11 +714,28 @@ void PhotonAnalysis::applyDiPhotonSmearings(TLorentzVector & Higgs, TVector3 & v
                         float & evweight, float & idmva1, float & idmva2,
                         BaseDiPhotonSmearer * sys, float syst_shift)
 {
-    static int nwarnings=10;
+    int & nwarnings = diPhotonSmearingWarnings_;
     float pth = Higgs.Pt();
     for(std::vector<BaseDiPhotonSmearer *>::iterator si=diPhotonSmearers_.begin(); si!= diPhotonSmearers_.end(); ++si ) {
         float rewei=1.;
-	if( sys != 0 && *si == *sys ) {
+	int ishift = ( sys != 0 && *si == *sys ? systShiftIndex(syst_shift) : -1 );
+	if( ishift >= 0 ) {
+	    diPhotonSmearingBatch_t & batch = diPhotonBatch_;
+	    if( batch.smearer != *si || batch.p4 != Higgs || batch.vtx != vtx || batch.truevtx != truevtx || batch.category != category 
+		|| batch.cur_type != cur_type || batch.idmva1 != idmva1 || batch.idmva2 != idmva2 ) {
+		batch.smearer = *si, batch.p4 = Higgs, batch.vtx = vtx, batch.truevtx = truevtx, batch.category = category;
+		batch.cur_type = cur_type, batch.idmva1 = idmva1, batch.idmva2 = idmva2;
+		int nshifts = systShifts_.size();
+		batch.weights.assign(nshifts,1.), batch.idMVA1.assign(nshifts,idmva1), batch.idMVA2.assign(nshifts,idmva2);
+		batch.ok = (*si)->smearDiPhotonShifts( Higgs, vtx, category, cur_type, truevtx, nshifts, &systShifts_[0],
+						       &batch.weights[0], &batch.idMVA1[0], &batch.idMVA2[0] );
+	    }
+	    if( batch.ok ) {
+		rewei = batch.weights[ishift], idmva1 = batch.idMVA1[ishift], idmva2 = batch.idMVA2[ishift];
+	    } else {
+		(*si)->smearDiPhoton( Higgs, vtx, rewei, category, cur_type, truevtx, idmva1, idmva2, syst_shift );
+	    }
+	} else if( sys != 0 && *si == *sys ) {
 	    (*si)->smearDiPhoton( Higgs, vtx, rewei, category, cur_type, truevtx, idmva1, idmva2, syst_shift );
 	} else {
 	    (*si)->smearDiPhoton( Higgs, vtx, rewei, category, cur_type, truevtx, idmva1, idmva2, 0. );
@@ -1400,33 +1488,6 @@ void PhotonAnalysis::Init(LoopAll& l)
                 fgbr->GetObject("EGRegressionForest_EE", _forestee);
                 fgbr->Close();
 
-            //recreate pdf with constraint transformations (can't load directly from file due to weird RooWorkspace IO features)
-            
-            _tgt = new RooRealVar("tgt","",1.);
-            _mean = new RooRealVar("mean","",1.);
-            _sigma = new RooRealVar("sigma","",1.);
-            _n1 = new RooRealVar("n1","",2.);
-            _n2 = new RooRealVar("n2","",2.);
-            
-            _sigmalim = new RooRealConstraint("sigmalim","",*_sigma,0.0002,0.5);
-            _meanlim = new RooRealConstraint("meanlim","",*_mean,0.2,2.0);
-            _n1lim = new RooRealConstraint("n1lim","",*_n1,1.01,110.);
-            _n2lim = new RooRealConstraint("n2lim","",*_n2,1.01,110.);     
-            
-            _pdf = new RooDoubleCBFast("sigpdf","",*_tgt,RooFit::RooConst(1.),
-                           *_sigmalim,RooFit::RooConst(2.0),*_n1lim,RooFit::RooConst(1.0),*_n2lim);
-            
-            //add to RooArgList for proper garbage collection
-            _args.addOwned(*_tgt);
-            _args.addOwned(*_mean);
-            _args.addOwned(*_sigma);
-            _args.addOwned(*_n1);
-            _args.addOwned(*_n2);
-            _args.addOwned(*_sigmalim);
-            _args.addOwned(*_meanlim);
-            _args.addOwned(*_n1lim);
-            _args.addOwned(*_n2lim);
-            _args.addOwned(*_pdf);    
        } 
        else if (regressionVersion==8){ // This is for 7 TeV (we would use V8)
           //initialize eval vector
@@ -1441,38 +1502,6 @@ void PhotonAnalysis::Init(LoopAll& l)
                 fgbr->Close();      
           }
           
-          //recreate pdf with constraint transformations (can't load directly from file due to weird RooWorkspace IO features)
-          
-          _tgt = new RooRealVar("tgt","",1.);
-          _mean = new RooRealVar("mean","",1.);
-          _sigma = new RooRealVar("sigma","",0.01);
-          _n1 = new RooRealVar("n1","",2.);
-          _n2 = new RooRealVar("n2","",2.);
-          
-          _sigmalim = new RooRealConstraint("sigmalim","",*_sigma,0.0002,0.5);
-          _meanlim = new RooRealConstraint("meanlim","",*_mean,0.2,2.0);
-          _n1lim = new RooRealConstraint("n1lim","",*_n1,1.01,5000.);
-          _n2lim = new RooRealConstraint("n2lim","",*_n2,1.01,5000.);
-          
-          RooConstVar *alpha1 = new RooConstVar("alpha1","",2.0);
-          RooConstVar *alpha2 = new RooConstVar("alpha2","",1.0);
-          
-          _pdf = new RooDoubleCBFast("sigpdf","",*_tgt,*_meanlim,*_sigmalim,*alpha1,*_n1lim,*alpha2,*_n2lim);
-          
-          //add to RooArgList for proper garbage collection
-          _args.addOwned(*_tgt);
-          _args.addOwned(*_mean);
-          _args.addOwned(*_sigma);
-          _args.addOwned(*_n1);
-          _args.addOwned(*_n2);
-          _args.addOwned(*alpha1);
-          _args.addOwned(*alpha2);
-          _args.addOwned(*_sigmalim);
-          _args.addOwned(*_meanlim);
-          _args.addOwned(*_n1lim);
-          _args.addOwned(*_n2lim);
-          _args.addOwned(*_pdf);        
-
        }
        else {  
         std::cout << "PhotonAnalysis -- Regression versions 5 and 8 are implemented only!" << std::endl;
@@ -2320,9 +2349,6 @@ void PhotonAnalysis::MetCorrections2012_Simple(LoopAll& l,TLorentzVector lead_p4
 
 bool PhotonAnalysis::SkimEvents(LoopAll& l, int jentry)
 {
-    static TH1F * promptFakeFractions = 0;
-    static TH1F * promptMotherStatus = 0;
-    static TH1F * fakeMotherStatus = 0;
     if( run7TeV4Xanalysis ) { l.version=12; }
     
     
@@ -2352,16 +2378,26 @@ bool PhotonAnalysis::SkimEvents(LoopAll& l, int jentry)
         }
 
 	// get the trigger data
+	//   the menu only changes at run boundaries: it is read and resolved into accepted bits once per run and file
+	int iselIndex = isel - triggerSelections.begin();
+	bool newMenu = ( l.run != triggerMenuRun_ || l.current != triggerMenuFile_ || iselIndex != triggerMenuSel_ );
+	triggerMenuRun_ = l.run, triggerMenuFile_ = l.current, triggerMenuSel_ = iselIndex;
 	if( l.version < 13 ) {
 	    l.b_hlt1_bit->GetEntry(jentry);
-	    l.b_hlt_path_names_HLT1->GetEntry(jentry);
-	    if( !  isel->pass( *(l.hlt_path_names_HLT1), *(l.hlt1_bit) ) ) {
+	    if( newMenu ) {
+		l.b_hlt_path_names_HLT1->GetEntry(jentry);
+		isel->setMenu( *(l.hlt_path_names_HLT1) );
+	    }
+	    if( !  isel->pass( *(l.hlt1_bit) ) ) {
 		return false;
 	    }
 	} else {
 	    l.b_hlt_bit->GetEntry(jentry);
-	    l.b_hlt_path_names_HLT->GetEntry(jentry);
-	    if( !  isel->pass( *(l.hlt_path_names_HLT), *(l.hlt_bit) ) ) {
+	    if( newMenu ) {
+		l.b_hlt_path_names_HLT->GetEntry(jentry);
+		isel->setMenu( *(l.hlt_path_names_HLT) );
+	    }
+	    if( !  isel->pass( *(l.hlt_bit) ) ) {
 		return false;
 	    }
 	}
@@ -2383,13 +2419,13 @@ bool PhotonAnalysis::SkimEvents(LoopAll& l, int jentry)
         }
 
         if( filetype != 0 && ! (keepPP && keepPF && keepFF) ) {
-            if( promptFakeFractions == 0 ) {
-                promptFakeFractions = new TH1F("promptFakeFractions","promptFakeFractions",3,-0.5,2.5);
-                promptMotherStatus = new TH1F("promptMotherStatus","promptMotherStatus",20,-0.5,20);
-                fakeMotherStatus = new TH1F("fakeMotherStatus","fakeMotherStatus",20,-0.5,20);
-                l.AddGlobalHisto(promptFakeFractions);
-                l.AddGlobalHisto(promptMotherStatus);
-                l.AddGlobalHisto(fakeMotherStatus);
+            if( promptFakeFractions_ == 0 ) {
+                promptFakeFractions_ = new TH1F("promptFakeFractions","promptFakeFractions",3,-0.5,2.5);
+                promptMotherStatus_ = new TH1F("promptMotherStatus","promptMotherStatus",20,-0.5,20);
+                fakeMotherStatus_ = new TH1F("fakeMotherStatus","fakeMotherStatus",20,-0.5,20);
+                l.AddGlobalHisto(promptFakeFractions_);
+                l.AddGlobalHisto(promptMotherStatus_);
+                l.AddGlobalHisto(fakeMotherStatus_);
             }
             
             l.b_weight->GetEntry(jentry);
@@ -2419,14 +2455,14 @@ bool PhotonAnalysis::SkimEvents(LoopAll& l, int jentry)
                 int mother_id = abs( l.gp_pdgid[ l.gp_mother[ip] ] );
                 if( mother_id <= 25 ) { 
                     ++np; 
-                    promptMotherStatus->Fill((float)l.gp_status[l.gp_mother[ip]],l.weight);
+                    promptMotherStatus_->Fill((float)l.gp_status[l.gp_mother[ip]],l.weight);
                 } else {
-                    fakeMotherStatus->Fill((float)l.gp_status[l.gp_mother[ip]],l.weight);
+                    fakeMotherStatus_->Fill((float)l.gp_status[l.gp_mother[ip]],l.weight);
                 }
                 if( np >= 2 ) { break; }
             }
             /// std::cout << "N prompt photons: " << np << std::endl;
-            promptFakeFractions->Fill((float)np,l.weight);
+            promptFakeFractions_->Fill((float)np,l.weight);
             if( np >= 2 && ! keepPP ) { return false; }
             if( np == 1 && ! keepPF ) { return false; }
             if( np == 0 && ! keepFF ) { return false; }
@@ -3909,6 +3945,7 @@ bool PhotonAnalysis::VBFTag2012(int & ijet1, int & ijet2,
             if(nm1 && myVBF_Mgg>massMin && myVBF_Mgg<massMax) {
                 l.FillCutPlots(0,1,"_nminus1",eventweight,myweight);
             }
+            R__LOCKGUARD(gRootLock);
             if (!multiclassVbfSelection || vbfVsDiphoVbfSelection ){
                 myVBF_MVA = tmvaVbfReader_->EvaluateMVA(mvaVbfMethod);
                 tag       = (myVBF_MVA > mvaVbfCatBoundaries.back());
@@ -3945,6 +3982,7 @@ bool PhotonAnalysis::VBFTag2012(int & ijet1, int & ijet2,
     
     if( mvaVbfSpin && (mvaVbfSelection || multiclassVbfSelection) )
     {
+        R__LOCKGUARD(gRootLock);
         myVBFSpin_Discriminant = tmvaVbfSpinReader_->EvaluateMVA(mvaVbfSpinMethod);
     }
     
@@ -3988,8 +4026,11 @@ bool PhotonAnalysis::VBFTag2013(int & ijet1, int & ijet2, LoopAll& l, int& dipho
         
         int vbfcat=-1;
         myVBFDIPHObdt   = l.dipho_BDT[diphotonVBF_id];
-        myVBF_MVA       = (useGbrVbfMva ? gbrVbfReader_->eval()      : tmvaVbfReader_->EvaluateMVA(mvaVbfMethod)           );
-        myVBFcombined   = (useGbrVbfMva ? gbrVbfDiphoReader_->eval() : tmvaVbfDiphoReader_->EvaluateMVA(mvaVbfDiphoMethod) );
+        {
+            R__LOCKGUARD(gRootLock);
+            myVBF_MVA       = (useGbrVbfMva ? gbrVbfReader_->eval()      : tmvaVbfReader_->EvaluateMVA(mvaVbfMethod)           );
+            myVBFcombined   = (useGbrVbfMva ? gbrVbfDiphoReader_->eval() : tmvaVbfDiphoReader_->EvaluateMVA(mvaVbfDiphoMethod) );
+        }
 
         if(PADEBUG) std::cout<<"dipho dijet pt/m combined "<<myVBFDIPHObdt<<" "<<myVBF_MVA<<" "<<myVBFDiPhoPtOverM<<" "<<myVBFcombined<<std::endl;
 
@@ -4035,7 +4076,7 @@ bool PhotonAnalysis::FillDijetVariables(int & ijet1, int & ijet2, LoopAll& l, in
 
     if(diphoton_id==-1) return filled;
     
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
 
     if( jetid_flags == 0 ) {
         if(PADEBUG) std::cout<<"FillDijetVariable -- no id flags, re-making"<<std::endl;
@@ -4121,7 +4162,7 @@ bool PhotonAnalysis::VHhadronicTag2011(LoopAll& l, int& diphotonVHhad_id, float*
 
     if(diphotonVHhad_id==-1) return tag;
 
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
     if( jetid_flags == 0 ) {
         switchJetIdVertex( l, l.dipho_vtxind[diphotonVHhad_id] );
         id_flags.resize(l.jet_algoPF1_n);
@@ -4286,7 +4327,7 @@ bool PhotonAnalysis::VHhadronicTag2012(LoopAll& l, int& diphotonVHhad_id, float*
 
     if(diphotonVHhad_id==-1) return tag;
 
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
     if( jetid_flags == 0 ) {
         switchJetIdVertex( l, l.dipho_vtxind[diphotonVHhad_id] );
         id_flags.resize(l.jet_algoPF1_n);
@@ -4420,7 +4461,7 @@ bool PhotonAnalysis::VHhadronicBtag2012(LoopAll& l, int& diphotonVHhadBtag_id, f
 
     if(diphotonVHhadBtag_id==-1) return tag;
 
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
     if( jetid_flags == 0 ) {
         switchJetIdVertex( l, l.dipho_vtxind[diphotonVHhadBtag_id] );
         id_flags.resize(l.jet_algoPF1_n);
@@ -4583,7 +4624,7 @@ bool PhotonAnalysis::TTHhadronicTag2012(LoopAll& l, int& diphotonTTHhad_id, floa
 
     if(diphotonTTHhad_id==-1) return tag;
 
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
     if( jetid_flags == 0 ) {
         switchJetIdVertex( l, l.dipho_vtxind[diphotonTTHhad_id] );
         id_flags.resize(l.jet_algoPF1_n);
@@ -4813,7 +4854,7 @@ bool PhotonAnalysis::TTHleptonicTag2012(LoopAll& l, int& diphotonTTHlep_id, floa
     if(isLep_ele!=1 && isLep_mu !=1) return false;
    
 
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
     if( jetid_flags == 0 ) {
 	switchJetIdVertex( l, l.dipho_vtxind[diphotonTTHlep_id] );
 	id_flags.resize(l.jet_algoPF1_n);
@@ -5975,7 +6016,7 @@ int PhotonAnalysis::VHNumberOfJets(LoopAll& l, int diphotonVHlep_id, int vertex,
   int Njet_lepcat = 0;
 
   bool * jetid_flags=0; //PU-JET VETO
-  static std::vector<unsigned char> id_flags;
+  std::vector<unsigned char> id_flags;
   switchJetIdVertex( l, l.dipho_vtxind[diphotonVHlep_id] );
   id_flags.resize(l.jet_algoPF1_n);
   for(int ijet=0; ijet<l.jet_algoPF1_n; ++ijet ) {
@@ -6044,7 +6085,7 @@ void PhotonAnalysis::GetRegressionCorrectionsV8(LoopAll &l){
 void PhotonAnalysis::GetSinglePhotonRegressionCorrectionV7(LoopAll &l, int ipho, double *ecor, double *ecorerr){
     // V7 7TeV Endcap use
 
-    double cbalpha1,cbn1,cbalpha2,cbn2,pdfpeakval,cbmean,cbsigma;
+    double cbmean,cbsigma;
 
     double phoE = ((TLorentzVector*)l.pho_p4->At(ipho))->Energy();
     double r9=l.pho_r9[ipho];
@@ -6111,22 +6152,8 @@ void PhotonAnalysis::GetSinglePhotonRegressionCorrectionV7(LoopAll &l, int ipho,
 
     double den =  l.sc_pre[sc_index]+l.sc_raw[sc_index];
       
-    //set raw response variables from GBRForest
-    _sigma->setVal(_forestDee->GetResponse(&_vals[0],0));
-    _mean->setVal(_forestDee->GetResponse(&_vals[0],1));
-    _n1->setVal(_forestDee->GetResponse(&_vals[0],2));
-    _n2->setVal(_forestDee->GetResponse(&_vals[0],3));
-    
     //retrieve final pdf parameter values from transformed forest outputs
-    cbmean = _meanlim->getVal();
-    cbsigma = _sigmalim->getVal();
-    cbalpha1 = 2.0;  //alpha hardcoded in this version of the regression
-    cbn1 = _n1lim->getVal();
-    cbalpha2 = 1.0;  //alpha hardcoded in this version of the regression
-    cbn2 = _n2lim->getVal();
-    
-    _tgt->setVal(cbmean); //evaluate pdf at peak position  
-    pdfpeakval = _pdf->getVal(*_tgt);
+    regressionMeanSigma(_forestDee,&_vals[0],cbmean,cbsigma);
       
     //set final energy and relative energy resolution
     *ecor = den*cbmean;
@@ -6150,7 +6177,7 @@ void PhotonAnalysis::GetSinglePhotonRegressionCorrectionV6(LoopAll &l, int ipho,
    
     // V6 7TeV Barrel use  
 
-    double cbalpha1,cbn1,cbalpha2,cbn2,pdfpeakval,cbmean,cbsigma;
+    double cbmean,cbsigma;
 
     double phoE = ((TLorentzVector*)l.pho_p4->At(ipho))->Energy();
     double r9=l.pho_r9[ipho];
@@ -6230,22 +6257,8 @@ void PhotonAnalysis::GetSinglePhotonRegressionCorrectionV6(LoopAll &l, int ipho,
 
 
     double den = l.sc_raw[sc_index];
-    //set raw response variables from GBRForest
-    _sigma->setVal(_forestDeb->GetResponse(&_vals[0],0));
-    _mean->setVal(_forestDeb->GetResponse(&_vals[0],1));
-    _n1->setVal(_forestDeb->GetResponse(&_vals[0],2));
-    _n2->setVal(_forestDeb->GetResponse(&_vals[0],3));
-  
     //retrieve final pdf parameter values from transformed forest outputs
-    cbmean = _meanlim->getVal();
-    cbsigma = _sigmalim->getVal();
-    cbalpha1 = 2.0;  //alpha hardcoded in this version of the regression
-    cbn1 = _n1lim->getVal();
-    cbalpha2 = 1.0;  //alpha hardcoded in this version of the regression
-    cbn2 = _n2lim->getVal();
-  
-    _tgt->setVal(cbmean); //evaluate pdf at peak position  
-    pdfpeakval = _pdf->getVal(*_tgt);
+    regressionMeanSigma(_forestDeb,&_vals[0],cbmean,cbsigma);
     
     //set final energy and relative energy resolution
     *ecor = den*cbmean;
@@ -6260,7 +6273,7 @@ void PhotonAnalysis::GetRegressionCorrectionsV5(LoopAll &l){
     // On the fly energy regression values
     for (int ipho=0;ipho<l.pho_n;ipho++){
 
-        double ecor,ecorerr,cbalpha1,cbn1,cbalpha2,cbn2,pdfpeakval;
+        double ecor,ecorerr;
 
         double phoE = ((TLorentzVector*)l.pho_p4->At(ipho))->Energy();
         double r9=l.pho_r9[ipho];
@@ -6358,26 +6371,12 @@ void PhotonAnalysis::GetRegressionCorrectionsV5(LoopAll &l){
             forest = _forestee;
         }
 
-        _tgt->setVal(1.0); //evaluate pdf at peak position
-
-        //set raw response variables from GBRForest
-        _sigma->setVal(forest->GetResponse(&_vals[0],0));
-        _mean->setVal(forest->GetResponse(&_vals[0],1));
-        _n1->setVal(forest->GetResponse(&_vals[0],2));
-        _n2->setVal(forest->GetResponse(&_vals[0],3));
-
         //retrieve final pdf parameter values from transformed forest outputs
-        // cbsigma (sigmalim->getVal()) is the sigmaE/E so in the branch we save cbsigma*ecor (ie the absolute error in GeV) 
-        ecor = den/_meanlim->getVal();
-        ecorerr = _sigmalim->getVal()*ecor;
-
-        cbalpha1 = 2.0;  //alpha hardcoded in this version of the regression
-        cbn1 = _n1lim->getVal();
-        cbalpha2 = 1.0;  //alpha hardcoded in this version of the regression
-        cbn2 = _n2lim->getVal();
-
-        // note ecor is now the corrected energy (save this directly)
-        pdfpeakval = _pdf->getVal(*_tgt);
+        // cbsigma is the sigmaE/E so in the branch we save cbsigma*ecor (ie the absolute error in GeV) 
+        double cbmean, cbsigma;
+        regressionMeanSigma(forest,&_vals[0],cbmean,cbsigma);
+        ecor = den/cbmean;
+        ecorerr = cbsigma*ecor;
 
 
         //// // Set vectors used in reduction;
@@ -6424,7 +6423,7 @@ std::pair<int, int> PhotonAnalysis::SelectBtaggedAndHighestPtJets(LoopAll& l,int
 
     float ptJets_thresh=25.;
 
-    static std::vector<unsigned char> id_flags;
+    std::vector<unsigned char> id_flags;
     if( jetid_flags == 0 ) {
       ((PhotonAnalysis*) NULL)->switchJetIdVertex( l, l.dipho_vtxind[diphoton_id] );
       id_flags.resize(l.jet_algoPF1_n);
@@ -98,11 +98,11 @@ void StatAnalysis::Init(LoopAll& l)
     nevents=0., sumwei=0.;
     sumaccept=0., sumsmear=0., sumev=0.;
 
-    met_sync.open ("met_sync.txt");
+    met_sync.open (l.WorkerFileName("met_sync.txt"));
 
     std::string outputfilename = (std::string) l.histFileName;
     eventListText.open(Form("%s",l.outputTextFileName.c_str()));
-    lep_sync.open ("lep_sync.txt");
+    lep_sync.open (l.WorkerFileName("lep_sync.txt"));
     //eventListText.open(Form("%s_ascii_events.txt",outputfilename.c_str()));
     FillSignalLabelMap(l);
     //
@@ -133,6 +133,7 @@ void StatAnalysis::Init(LoopAll& l)
 
     // call the base class initializer
     PhotonAnalysis::Init(l);
+    bindOpTreeSlots(l);
 
     // Avoid reweighing from histo conainer
     for(size_t ind=0; ind<l.histoContainer.size(); ind++) {
@@ -739,6 +740,13 @@ bool StatAnalysis::Analysis(LoopAll& l, Int_t jentry)
 
         // fill steps for syst uncertainty study
         float systStep = systRange / (float)nSystSteps;
+        if( systShifts_.empty() ) {
+            // the smearers evaluate all the shifts at once, see PhotonAnalysis::systShiftIndex
+            for(float syst_shift=-systRange; syst_shift<=systRange; syst_shift+=systStep ) {
+                if( syst_shift == 0. ) { continue; } // skip the central value
+                systShifts_.push_back(syst_shift);
+            }
+        }
 
         float syst_mass, syst_weight, syst_diphotonMVA;
         int syst_category;
@@ -753,8 +761,8 @@ bool StatAnalysis::Analysis(LoopAll& l, Int_t jentry)
             for(std::vector<BaseGenLevelSmearer*>::iterator si=systGenLevelSmearers_.begin(); si!=systGenLevelSmearers_.end(); si++){
                 mass_errors.clear(), weights.clear(), categories.clear(), mva_errors.clear();
 
-                for(float syst_shift=-systRange; syst_shift<=systRange; syst_shift+=systStep ) {
-                    if( syst_shift == 0. ) { continue; } // skip the central value
+                for(std::vector<float>::iterator ishift=systShifts_.begin(); ishift!=systShifts_.end(); ++ishift ) {
+                    float syst_shift = *ishift;
                     syst_mass     =  0., syst_category = -1, syst_weight   =  0.;
 
                     // re-analyse the event without redoing the event selection as we use nominal values for the single photon
@@ -773,8 +781,8 @@ bool StatAnalysis::Analysis(LoopAll& l, Int_t jentry)
             for(std::vector<BaseDiPhotonSmearer *>::iterator si=systDiPhotonSmearers_.begin(); si!= systDiPhotonSmearers_.end(); ++si ) {
                 mass_errors.clear(), weights.clear(), categories.clear(), mva_errors.clear();
 
-                for(float syst_shift=-systRange; syst_shift<=systRange; syst_shift+=systStep ) {
-                    if( syst_shift == 0. ) { continue; } // skip the central value
+                for(std::vector<float>::iterator ishift=systShifts_.begin(); ishift!=systShifts_.end(); ++ishift ) {
+                    float syst_shift = *ishift;
                     syst_mass     =  0., syst_category = -1, syst_weight   =  0.;
 
                     // re-analyse the event without redoing the event selection as we use nominal values for the single photon
@@ -796,8 +804,8 @@ bool StatAnalysis::Analysis(LoopAll& l, Int_t jentry)
         for(std::vector<BaseSmearer *>::iterator  si=systPhotonSmearers_.begin(); si!= systPhotonSmearers_.end(); ++si ) {
             mass_errors.clear(), weights.clear(), categories.clear(), mva_errors.clear();
 
-            for(float syst_shift=-systRange; syst_shift<=systRange; syst_shift+=systStep ) {
-                if( syst_shift == 0. ) { continue; } // skip the central value
+            for(std::vector<float>::iterator ishift=systShifts_.begin(); ishift!=systShifts_.end(); ++ishift ) {
+                float syst_shift = *ishift;
                 syst_mass     =  0., syst_category = -1, syst_weight   =  0.;
 
                 // re-analyse the event redoing the event selection this time
@@ -1636,7 +1644,24 @@ void StatAnalysis::computeSpinCategory(LoopAll &l, int &category, TLorentzVector
 }
 
 // ----------------------------------------------------------------------------------------------------
+void StatAnalysis::resolveControlPlotHandles(LoopAll & l)
+{
+    static const char * names[cp_vtx_mva] = { "all_mass", "diphobdt", "process_id", "mass", "eta", "pt", "pt_rv", "nvtx", "nvtx_rv",
+                                              "probmva_pt", "probmva_nvtx", "probmva_rv_nvtx", "vtxprob_pt", "vtxprob_nvtx", "vtx_nconv",
+                                              "pho_pt", "pho1_pt", "pho2_pt", "pho_eta", "pho1_eta", "pho2_eta", "pho_r9", "pho1_r9", "pho2_r9",
+                                              "pho_n", "pho_rawe", "uncorrmet", "uncorrmetPhi", "corrmet", "corrmetPhi",
+                                              "vbf_mva", "vbf_mva0", "vbf_mva1", "vbf_mva2", "rho" };
+    controlPlotHandles_.resize(cp_nControlPlots);
+    for(int ih=0; ih<cp_vtx_mva; ++ih) {
+        controlPlotHandles_[ih] = l.HistoHandle(names[ih]);
+    }
+    for(int ivtx=0; ivtx<5; ++ivtx) {
+        controlPlotHandles_[cp_vtx_mva+ivtx] = l.HistoHandle(Form("vtx_mva_%d",ivtx));
+        controlPlotHandles_[cp_vtx_dz+ivtx] = l.HistoHandle(Form("vtx_dz_%d",ivtx));
+    }
+}
 
+// ----------------------------------------------------------------------------------------------------
 void StatAnalysis::fillControlPlots(const TLorentzVector & lead_p4, const  TLorentzVector & sublead_p4, const TLorentzVector & Higgs,
         float lead_r9, float sublead_r9, int diphoton_id,
         int category, bool isCorrectVertex, float evweight, TVector3* vtx, LoopAll & l,
@@ -1644,83 +1669,85 @@ void StatAnalysis::fillControlPlots(const TLorentzVector & lead_p4, const  TLore
 {
     int cur_type = l.itype[l.current];
     float mass = Higgs.M();
+    if( controlPlotHandles_.empty() ) { resolveControlPlotHandles(l); }
+    const std::vector<int> & hdl = controlPlotHandles_;
     if(category!=-10){  // really this is nomva cut but -1 means all together here
         if( category>=0 ) {
             fillControlPlots( lead_p4, sublead_p4, Higgs, lead_r9, sublead_r9, diphoton_id, -1, isCorrectVertex, evweight,
                     vtx, l, muVtx, mu_ind, elVtx, el_ind, diphobdt_output );
         }
-        l.FillHist("all_mass",category+1, Higgs.M(), evweight);
+        l.FillHist(hdl[cp_all_mass],category+1, Higgs.M(), evweight);
         if( mass>=massMin && mass<=massMax  ) {
-            l.FillHist("diphobdt",category+1, diphobdt_output, evweight);
-            l.FillHist("process_id",category+1, l.process_id, evweight);
-            l.FillHist("mass",category+1, Higgs.M(), evweight);
-            l.FillHist("eta",category+1, Higgs.Eta(), evweight);
-            l.FillHist("pt",category+1, Higgs.Pt(), evweight);
-            if( isCorrectVertex ) { l.FillHist("pt_rv",category+1, Higgs.Pt(), evweight); }
-            l.FillHist("nvtx",category+1, l.vtx_std_n, evweight);
-            if( isCorrectVertex ) { l.FillHist("nvtx_rv",category+1, l.vtx_std_n, evweight); }
+            l.FillHist(hdl[cp_diphobdt],category+1, diphobdt_output, evweight);
+            l.FillHist(hdl[cp_process_id],category+1, l.process_id, evweight);
+            l.FillHist(hdl[cp_mass],category+1, Higgs.M(), evweight);
+            l.FillHist(hdl[cp_eta],category+1, Higgs.Eta(), evweight);
+            l.FillHist(hdl[cp_pt],category+1, Higgs.Pt(), evweight);
+            if( isCorrectVertex ) { l.FillHist(hdl[cp_pt_rv],category+1, Higgs.Pt(), evweight); }
+            l.FillHist(hdl[cp_nvtx],category+1, l.vtx_std_n, evweight);
+            if( isCorrectVertex ) { l.FillHist(hdl[cp_nvtx_rv],category+1, l.vtx_std_n, evweight); }
 
             vtxAna_.setPairID(diphoton_id);
             float vtxProb = vtxAna_.vertexProbability(l.vtx_std_evt_mva->at(diphoton_id), l.vtx_std_n);
-            l.FillHist2D("probmva_pt",category+1, Higgs.Pt(), l.vtx_std_evt_mva->at(diphoton_id), evweight);
-            l.FillHist2D("probmva_nvtx",category+1, l.vtx_std_n, l.vtx_std_evt_mva->at(diphoton_id), evweight);
+            l.FillHist2D(hdl[cp_probmva_pt],category+1, Higgs.Pt(), l.vtx_std_evt_mva->at(diphoton_id), evweight);
+            l.FillHist2D(hdl[cp_probmva_nvtx],category+1, l.vtx_std_n, l.vtx_std_evt_mva->at(diphoton_id), evweight);
             if( isCorrectVertex ) {
-                l.FillHist2D("probmva_rv_nvtx",category+1, l.vtx_std_n, l.vtx_std_evt_mva->at(diphoton_id), evweight);
+                l.FillHist2D(hdl[cp_probmva_rv_nvtx],category+1, l.vtx_std_n, l.vtx_std_evt_mva->at(diphoton_id), evweight);
             }
-            l.FillHist2D("vtxprob_pt",category+1, Higgs.Pt(), vtxProb, evweight);
-            l.FillHist2D("vtxprob_nvtx",category+1, l.vtx_std_n, vtxProb, evweight);
+            l.FillHist2D(hdl[cp_vtxprob_pt],category+1, Higgs.Pt(), vtxProb, evweight);
+            l.FillHist2D(hdl[cp_vtxprob_nvtx],category+1, l.vtx_std_n, vtxProb, evweight);
             std::vector<int> & vtxlist = l.vtx_std_ranked_list->at(diphoton_id);
             size_t maxv = std::min(vtxlist.size(),(size_t)5);
             for(size_t ivtx=0; ivtx<maxv; ++ivtx) {
                 int vtxid = vtxlist.at(ivtx);
-                l.FillHist(Form("vtx_mva_%d",ivtx),category+1,vtxAna_.mva(ivtx),evweight);
+                l.FillHist(hdl[cp_vtx_mva+ivtx],category+1,vtxAna_.mva(ivtx),evweight);
                 if( ivtx > 0 ) {
-                    l.FillHist(Form("vtx_dz_%d",ivtx),category+1,
+                    l.FillHist(hdl[cp_vtx_dz+ivtx],category+1,
                             vtxAna_.vertexz(ivtx)-vtxAna_.vertexz(l.dipho_vtxind[diphoton_id]),evweight);
                 }
             }
-            l.FillHist("vtx_nconv",vtxAna_.nconv(0));
+            l.FillHist(hdl[cp_vtx_nconv],0,vtxAna_.nconv(0));
 
-            l.FillHist("pho_pt",category+1,lead_p4.Pt(), evweight);
-            l.FillHist("pho1_pt",category+1,lead_p4.Pt(), evweight);
-            l.FillHist("pho_eta",category+1,lead_p4.Eta(), evweight);
-            l.FillHist("pho1_eta",category+1,lead_p4.Eta(), evweight);
-            l.FillHist("pho_r9",category+1, lead_r9, evweight);
-            l.FillHist("pho1_r9",category+1, lead_r9, evweight);
+            l.FillHist(hdl[cp_pho_pt],category+1,lead_p4.Pt(), evweight);
+            l.FillHist(hdl[cp_pho1_pt],category+1,lead_p4.Pt(), evweight);
+            l.FillHist(hdl[cp_pho_eta],category+1,lead_p4.Eta(), evweight);
+            l.FillHist(hdl[cp_pho1_eta],category+1,lead_p4.Eta(), evweight);
+            l.FillHist(hdl[cp_pho_r9],category+1, lead_r9, evweight);
+            l.FillHist(hdl[cp_pho1_r9],category+1, lead_r9, evweight);
 
-            l.FillHist("pho_pt",category+1,sublead_p4.Pt(), evweight);
-            l.FillHist("pho2_pt",category+1,sublead_p4.Pt(), evweight);
-            l.FillHist("pho_eta",category+1,sublead_p4.Eta(), evweight);
-            l.FillHist("pho2_eta",category+1,sublead_p4.Eta(), evweight);
-            l.FillHist("pho_r9",category+1, sublead_r9, evweight);
-            l.FillHist("pho2_r9",category+1, sublead_r9, evweight);
+            l.FillHist(hdl[cp_pho_pt],category+1,sublead_p4.Pt(), evweight);
+            l.FillHist(hdl[cp_pho2_pt],category+1,sublead_p4.Pt(), evweight);
+            l.FillHist(hdl[cp_pho_eta],category+1,sublead_p4.Eta(), evweight);
+            l.FillHist(hdl[cp_pho2_eta],category+1,sublead_p4.Eta(), evweight);
+            l.FillHist(hdl[cp_pho_r9],category+1, sublead_r9, evweight);
+            l.FillHist(hdl[cp_pho2_r9],category+1, sublead_r9, evweight);
 
-            l.FillHist("pho_n",category+1,l.pho_n, evweight);
+            l.FillHist(hdl[cp_pho_n],category+1,l.pho_n, evweight);
 
-            l.FillHist("pho_rawe",category+1,l.sc_raw[l.pho_scind[l.dipho_leadind[diphoton_id]]], evweight);
-            l.FillHist("pho_rawe",category+1,l.sc_raw[l.pho_scind[l.dipho_subleadind[diphoton_id]]], evweight);
+            l.FillHist(hdl[cp_pho_rawe],category+1,l.sc_raw[l.pho_scind[l.dipho_leadind[diphoton_id]]], evweight);
+            l.FillHist(hdl[cp_pho_rawe],category+1,l.sc_raw[l.pho_scind[l.dipho_subleadind[diphoton_id]]], evweight);
 
             TLorentzVector myMet = l.METCorrection2012B(lead_p4, sublead_p4, moriond2013MetCorrection);
             float corrMet    = myMet.Pt();
             float corrMetPhi = myMet.Phi();
 
-            l.FillHist("uncorrmet",     category+1, l.met_pfmet, evweight);
-            l.FillHist("uncorrmetPhi",  category+1, l.met_phi_pfmet, evweight);
-            l.FillHist("corrmet",       category+1, corrMet,    evweight);
-            l.FillHist("corrmetPhi",    category+1, corrMetPhi, evweight);
+            l.FillHist(hdl[cp_uncorrmet],     category+1, l.met_pfmet, evweight);
+            l.FillHist(hdl[cp_uncorrmetPhi],  category+1, l.met_phi_pfmet, evweight);
+            l.FillHist(hdl[cp_corrmet],       category+1, corrMet,    evweight);
+            l.FillHist(hdl[cp_corrmetPhi],    category+1, corrMetPhi, evweight);
 
             if( mvaVbfSelection ) {
                 if (!multiclassVbfSelection && !combinedmvaVbfSelection) {
-                    l.FillHist("vbf_mva",category+1,myVBF_MVA,evweight);
+                    l.FillHist(hdl[cp_vbf_mva],category+1,myVBF_MVA,evweight);
                 } else {
                     if( combinedmvaVbfSelection ) { 
-                        l.FillHist("vbf_mva0",category+1,myVBF_MVA,evweight);
-                        l.FillHist("vbf_mva1",category+1,diphobdt_output,evweight);
-			l.FillHist("vbf_mva2",category+1,myVBFcombined,evweight);
+                        l.FillHist(hdl[cp_vbf_mva0],category+1,myVBF_MVA,evweight);
+                        l.FillHist(hdl[cp_vbf_mva1],category+1,diphobdt_output,evweight);
+			l.FillHist(hdl[cp_vbf_mva2],category+1,myVBFcombined,evweight);
                     } else { 
-                        l.FillHist("vbf_mva0",category+1,myVBF_MVA0,evweight);
-                        l.FillHist("vbf_mva1",category+1,myVBF_MVA1,evweight);
-                        l.FillHist("vbf_mva2",category+1,myVBF_MVA2,evweight);
+                        l.FillHist(hdl[cp_vbf_mva0],category+1,myVBF_MVA0,evweight);
+                        l.FillHist(hdl[cp_vbf_mva1],category+1,myVBF_MVA1,evweight);
+                        l.FillHist(hdl[cp_vbf_mva2],category+1,myVBF_MVA2,evweight);
                     }
                 }
 
@@ -1731,7 +1758,7 @@ void StatAnalysis::fillControlPlots(const TLorentzVector & lead_p4, const  TLore
                     l.FillCutPlots(category+1,1,"_sequential",evweight,myweight);
                 }
             }
-            l.FillHist("rho",category+1,l.rho_algo1,evweight);
+            l.FillHist(hdl[cp_rho],category+1,l.rho_algo1,evweight);
 
 
             if(category!=-1){
@@ -1980,6 +2007,30 @@ void StatAnalysis::ResetAnalysis(){
     }
 }
 
+// ----------------------------------------------------------------------------------------------------
+void StatAnalysis::MergeClone(BaseAnalysis & clone)
+{
+    StatAnalysis & other = dynamic_cast<StatAnalysis &>(clone);
+    nevents += other.nevents;
+    sumwei += other.sumwei;
+    sumaccept += other.sumaccept;
+    sumsmear += other.sumsmear;
+    sumev += other.sumev;
+    MergeCloneOutput(clone);
+    other.eventListText.Remove();
+    other.met_sync.Remove();
+    other.lep_sync.Remove();
+}
+
+// ----------------------------------------------------------------------------------------------------
+void StatAnalysis::MergeCloneOutput(BaseAnalysis & clone)
+{
+    StatAnalysis & other = dynamic_cast<StatAnalysis &>(clone);
+    eventListText.Append(other.eventListText);
+    met_sync.Append(other.met_sync);
+    lep_sync.Append(other.lep_sync);
+}
+
 void dumpJet(std::ostream & eventListText, int lab, LoopAll & l, int ijet)
 {
     eventListText << std::setprecision(4) << std::scientific
@@ -2031,12 +2082,44 @@ void dumpPhoton(std::ostream & eventListText, int lab,
         ;
 }
 
+// ----------------------------------------------------------------------------------------------------
+void StatAnalysis::bindOpTreeSlots(LoopAll & l)
+{
+    static const char * names[ot_nOpTreeBranches] = { "njets10", "njets15", "njets20", "dRphojet1", "dRphojet2", "run", "lumis",
+                                                      "event", "itype", "nvtx", "rho", "xsec_weight", "full_weight", "pu_weight",
+                                                      "pu_n", "mass", "dipho_pt", "full_cat", "et1", "et2", "eta1", "eta2",
+                                                      "r91", "r92", "sieie1", "sieie2", "hoe1", "hoe2", "sigmaEoE1", "sigmaEoE2",
+                                                      "ptoM1", "ptoM2", "isEB1", "isEB2", "chiso1", "chiso2", "chisow1",
+                                                      "chisow2", "phoiso1", "phoiso2", "phoiso041", "phoiso042", "ecaliso03_1",
+                                                      "ecaliso03_2", "hcaliso03_1", "hcaliso03_2", "trkiso03_1", "trkiso03_2",
+                                                      "pfchiso2_1", "pfchiso2_2", "sieip1", "sieip2", "etawidth1", "phiwidth1",
+                                                      "etawidth2", "phiwidth2", "regrerr1", "regrerr2", "cosphi", "genmatch1",
+                                                      "genmatch2", "cicpf4cutlevel1", "cicpf4cutlevel2", "idmva1", "idmva2",
+                                                      "vbfcat", "MET", "MET_phi", "isorv1", "isowv1", "isorv2", "isowv2",
+                                                      "s4ratio1", "s4ratio2", "effSigma1", "effSigma2", "scraw1", "scraw2",
+                                                      "vtx_x", "vtx_y", "vtx_z", "gv_x", "gv_y", "gv_z", "dijet_leadEta",
+                                                      "dijet_subleadEta", "dijet_LeadJPt", "dijet_SubJPt", "dijet_dEta",
+                                                      "dijet_Zep", "dijet_dPhi", "dijet_Mjj", "dijet_MVA", "issyst",
+                                                      "sigmaMrvoM", "sigmaMwvoM", "vtxprob", "ptbal", "ptasym", "logspt2",
+                                                      "p2conv", "nconv", "vtxmva", "vtxdz", "dipho_mva", "dipho_mva_cat" };
+    opTreeSlots_.resize(ot_nOpTreeBranches);
+    for(int ib=0; ib<ot_nOpTreeBranches; ++ib) {
+        opTreeSlot_t & slot = opTreeSlots_[ib];
+        slot.name = names[ib];
+        slot.f = l.GetTreeSlot<float>(slot.name);
+        slot.d = l.GetTreeSlot<double>(slot.name);
+        slot.i = l.GetTreeSlot<int>(slot.name);
+    }
+}
+
 void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const TLorentzVector & sublead_p4, Float_t vtxProb,
         std::pair<int, int> diphoton_index, Int_t diphoton_id, Float_t phoid_mvaout_lead, Float_t phoid_mvaout_sublead,
         Float_t weight, Float_t mass, Float_t sigmaMrv, Float_t sigmaMwv,
         const TLorentzVector & Higgs, Float_t diphobdt_output, Int_t category, bool VBFevent, Float_t myVBF_Mjj, Float_t myVBFLeadJPt, 
         Float_t myVBFSubJPt, Int_t nVBFDijetJetCategories, bool isSyst, std::string name1) {
 
+    if( opTreeSlots_.empty() ) { bindOpTreeSlots(l); }
+
     int vbfcat=-1;
     if(VBFevent){
         vbfcat=l.DijetSubCategory(myVBF_Mjj,myVBFLeadJPt,myVBFSubJPt,nVBFDijetJetCategories);
@@ -2054,9 +2137,9 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
 	    njets20 += 1.;
     }
 
-    l.FillTree("njets10", njets10);
-    l.FillTree("njets15", njets15);
-    l.FillTree("njets20", njets20);
+    fillOpTreeSlot(l, ot_njets10, njets10);
+    fillOpTreeSlot(l, ot_njets15, njets15);
+    fillOpTreeSlot(l, ot_njets20, njets20);
 
 
     if (vbfIjet1 != -1 && vbfIjet2 !=-1) {
@@ -2071,74 +2154,74 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
         float dr1 = std::min(dr11, dr21);
         float dr2 = std::min(dr12, dr22);
         
-        l.FillTree("dRphojet1", (float)dr1);
-        l.FillTree("dRphojet2", (float)dr2);
+        fillOpTreeSlot(l, ot_dRphojet1, (float)dr1);
+        fillOpTreeSlot(l, ot_dRphojet2, (float)dr2);
     } else {
-        l.FillTree("dRphojet1", (float)9999.);
-        l.FillTree("dRphojet2", (float)9999.);
-    }
-
-    l.FillTree("run", (float)l.run);
-    l.FillTree("lumis", (float)l.lumis);
-    l.FillTree("event", (double)l.event);
-    l.FillTree("itype", (float)l.itype[l.current]);
-    l.FillTree("nvtx", (float)l.vtx_std_n);
-    l.FillTree("rho", (float)l.rho_algo1);
-    l.FillTree("xsec_weight", (float)l.sampleContainer[l.current_sample_index].weight());
-    l.FillTree("full_weight", (float)weight);
+        fillOpTreeSlot(l, ot_dRphojet1, (float)9999.);
+        fillOpTreeSlot(l, ot_dRphojet2, (float)9999.);
+    }
+
+    fillOpTreeSlot(l, ot_run, (float)l.run);
+    fillOpTreeSlot(l, ot_lumis, (float)l.lumis);
+    fillOpTreeSlot(l, ot_event, (double)l.event);
+    fillOpTreeSlot(l, ot_itype, (float)l.itype[l.current]);
+    fillOpTreeSlot(l, ot_nvtx, (float)l.vtx_std_n);
+    fillOpTreeSlot(l, ot_rho, (float)l.rho_algo1);
+    fillOpTreeSlot(l, ot_xsec_weight, (float)l.sampleContainer[l.current_sample_index].weight());
+    fillOpTreeSlot(l, ot_full_weight, (float)weight);
     float pu_weight = weight/l.sampleContainer[l.current_sample_index].weight();
-    l.FillTree("pu_weight", (float)pu_weight);
-    l.FillTree("pu_n", (float)l.pu_n);
-    l.FillTree("mass", (float)mass);
-    l.FillTree("dipho_pt", (float)Higgs.Pt());
-    l.FillTree("full_cat", (float)category);
-
-    l.FillTree("et1", (float)lead_p4.Et());
-    l.FillTree("et2", (float)sublead_p4.Et());
-    l.FillTree("eta1", (float)lead_p4.Eta());
-    l.FillTree("eta2", (float)sublead_p4.Eta());
-    l.FillTree("r91", (float)l.pho_r9[diphoton_index.first]);
-    l.FillTree("r92", (float)l.pho_r9[diphoton_index.second]);
-    l.FillTree("sieie1", (float)l.pho_sieie[diphoton_index.first]);
-    l.FillTree("sieie2", (float)l.pho_sieie[diphoton_index.second]); 
-    l.FillTree("hoe1", l.pho_hoe[diphoton_index.first]);
-    l.FillTree("hoe2", l.pho_hoe[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_pu_weight, (float)pu_weight);
+    fillOpTreeSlot(l, ot_pu_n, (float)l.pu_n);
+    fillOpTreeSlot(l, ot_mass, (float)mass);
+    fillOpTreeSlot(l, ot_dipho_pt, (float)Higgs.Pt());
+    fillOpTreeSlot(l, ot_full_cat, (float)category);
+
+    fillOpTreeSlot(l, ot_et1, (float)lead_p4.Et());
+    fillOpTreeSlot(l, ot_et2, (float)sublead_p4.Et());
+    fillOpTreeSlot(l, ot_eta1, (float)lead_p4.Eta());
+    fillOpTreeSlot(l, ot_eta2, (float)sublead_p4.Eta());
+    fillOpTreeSlot(l, ot_r91, (float)l.pho_r9[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_r92, (float)l.pho_r9[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_sieie1, (float)l.pho_sieie[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_sieie2, (float)l.pho_sieie[diphoton_index.second]); 
+    fillOpTreeSlot(l, ot_hoe1, l.pho_hoe[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_hoe2, l.pho_hoe[diphoton_index.second]);
     //l.FillTree("conv1", (int)l.pho_isconv[diphoton_index.first]);
     //l.FillTree("conv2", (int)l.pho_isconv[diphoton_index.second]);
     
-    l.FillTree("sigmaEoE1", (float)l.pho_regr_energyerr[diphoton_index.first]/(float)l.pho_regr_energy[diphoton_index.first]);
-    l.FillTree("sigmaEoE2", (float)l.pho_regr_energyerr[diphoton_index.second]/(float)l.pho_regr_energy[diphoton_index.second]);
-    l.FillTree("ptoM1", (float)lead_p4.Pt()/mass);
-    l.FillTree("ptoM2", (float)sublead_p4.Pt()/mass);
-    l.FillTree("isEB1", (int)l.pho_isEB[diphoton_index.first]);
-    l.FillTree("isEB2", (int)l.pho_isEB[diphoton_index.second]);
-    l.FillTree("chiso1", (float)((*l.pho_pfiso_mycharged03)[diphoton_index.first][l.dipho_vtxind[diphoton_id]]));
-    l.FillTree("chiso2", (float)((*l.pho_pfiso_mycharged03)[diphoton_index.second][l.dipho_vtxind[diphoton_id]]));
-    l.FillTree("chisow1", l.pho_pfiso_charged_badvtx_04[diphoton_index.first]);
-    l.FillTree("chisow2", l.pho_pfiso_charged_badvtx_04[diphoton_index.second]);
-    l.FillTree("phoiso1", l.pho_pfiso_myphoton03[diphoton_index.first]);
-    l.FillTree("phoiso2", l.pho_pfiso_myphoton03[diphoton_index.second]);
-    l.FillTree("phoiso041", l.pho_pfiso_myphoton04[diphoton_index.first]);
-    l.FillTree("phoiso042", l.pho_pfiso_myphoton04[diphoton_index.second]);
-    l.FillTree("ecaliso03_1", l.pho_ecalsumetconedr03[diphoton_index.first]);
-    l.FillTree("ecaliso03_2", l.pho_ecalsumetconedr03[diphoton_index.second]);
-    l.FillTree("hcaliso03_1", l.pho_hcalsumetconedr03[diphoton_index.first]);
-    l.FillTree("hcaliso03_2", l.pho_hcalsumetconedr03[diphoton_index.second]);
-    l.FillTree("trkiso03_1",  l.pho_trksumpthollowconedr03[diphoton_index.first]);
-    l.FillTree("trkiso03_2",  l.pho_trksumpthollowconedr03[diphoton_index.second]);
-    l.FillTree("pfchiso2_1", (float)((*l.pho_pfiso_mycharged02)[diphoton_index.first][l.dipho_vtxind[diphoton_id]]));
-    l.FillTree("pfchiso2_2", (float)((*l.pho_pfiso_mycharged02)[diphoton_index.second][l.dipho_vtxind[diphoton_id]]));
-    l.FillTree("sieip1", l.pho_sieip[diphoton_index.first]);
-    l.FillTree("sieip2", l.pho_sieip[diphoton_index.second]);
-    l.FillTree("etawidth1", l.pho_etawidth[diphoton_index.first]);
-    l.FillTree("phiwidth1", l.sc_sphi[l.pho_scind[diphoton_index.first]]);
-    l.FillTree("etawidth2", l.pho_etawidth[diphoton_index.second]);
-    l.FillTree("phiwidth2", l.sc_sphi[l.pho_scind[diphoton_index.second]]);
-    l.FillTree("regrerr1", l.pho_regr_energyerr[diphoton_index.first]);
-    l.FillTree("regrerr2", l.pho_regr_energyerr[diphoton_index.second]);
-    l.FillTree("cosphi", (float)TMath::Cos(lead_p4.Phi()-sublead_p4.Phi()));
-    l.FillTree("genmatch1", (float)l.pho_genmatched[diphoton_index.first]);
-    l.FillTree("genmatch2", (float)l.pho_genmatched[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_sigmaEoE1, (float)l.pho_regr_energyerr[diphoton_index.first]/(float)l.pho_regr_energy[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_sigmaEoE2, (float)l.pho_regr_energyerr[diphoton_index.second]/(float)l.pho_regr_energy[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_ptoM1, (float)lead_p4.Pt()/mass);
+    fillOpTreeSlot(l, ot_ptoM2, (float)sublead_p4.Pt()/mass);
+    fillOpTreeSlot(l, ot_isEB1, (int)l.pho_isEB[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_isEB2, (int)l.pho_isEB[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_chiso1, (float)((*l.pho_pfiso_mycharged03)[diphoton_index.first][l.dipho_vtxind[diphoton_id]]));
+    fillOpTreeSlot(l, ot_chiso2, (float)((*l.pho_pfiso_mycharged03)[diphoton_index.second][l.dipho_vtxind[diphoton_id]]));
+    fillOpTreeSlot(l, ot_chisow1, l.pho_pfiso_charged_badvtx_04[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_chisow2, l.pho_pfiso_charged_badvtx_04[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_phoiso1, l.pho_pfiso_myphoton03[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_phoiso2, l.pho_pfiso_myphoton03[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_phoiso041, l.pho_pfiso_myphoton04[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_phoiso042, l.pho_pfiso_myphoton04[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_ecaliso03_1, l.pho_ecalsumetconedr03[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_ecaliso03_2, l.pho_ecalsumetconedr03[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_hcaliso03_1, l.pho_hcalsumetconedr03[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_hcaliso03_2, l.pho_hcalsumetconedr03[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_trkiso03_1,  l.pho_trksumpthollowconedr03[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_trkiso03_2,  l.pho_trksumpthollowconedr03[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_pfchiso2_1, (float)((*l.pho_pfiso_mycharged02)[diphoton_index.first][l.dipho_vtxind[diphoton_id]]));
+    fillOpTreeSlot(l, ot_pfchiso2_2, (float)((*l.pho_pfiso_mycharged02)[diphoton_index.second][l.dipho_vtxind[diphoton_id]]));
+    fillOpTreeSlot(l, ot_sieip1, l.pho_sieip[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_sieip2, l.pho_sieip[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_etawidth1, l.pho_etawidth[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_phiwidth1, l.sc_sphi[l.pho_scind[diphoton_index.first]]);
+    fillOpTreeSlot(l, ot_etawidth2, l.pho_etawidth[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_phiwidth2, l.sc_sphi[l.pho_scind[diphoton_index.second]]);
+    fillOpTreeSlot(l, ot_regrerr1, l.pho_regr_energyerr[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_regrerr2, l.pho_regr_energyerr[diphoton_index.second]);
+    fillOpTreeSlot(l, ot_cosphi, (float)TMath::Cos(lead_p4.Phi()-sublead_p4.Phi()));
+    fillOpTreeSlot(l, ot_genmatch1, (float)l.pho_genmatched[diphoton_index.first]);
+    fillOpTreeSlot(l, ot_genmatch2, (float)l.pho_genmatched[diphoton_index.second]);
     //l.FillTree("drtoeltk1", (float)l.pho_drtotk_25_99[diphoton_index.first]);
     //l.FillTree("drtoeltk2", (float)l.pho_drtotk_25_99[diphoton_index.second]);
 
@@ -2146,24 +2229,24 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
     int level1 = l.PhotonCiCPFSelectionLevel(diphoton_index.first, l.dipho_vtxind[diphoton_id], ph_passcut, 4, 0, 0);
     int level2 = l.PhotonCiCPFSelectionLevel(diphoton_index.second, l.dipho_vtxind[diphoton_id], ph_passcut, 4, 0, 0);
 
-    l.FillTree("cicpf4cutlevel1", (float)level1);
-    l.FillTree("cicpf4cutlevel2", (float)level2);
-    l.FillTree("idmva1", (float)phoid_mvaout_lead);
-    l.FillTree("idmva2", (float)phoid_mvaout_sublead);
-    l.FillTree("vbfcat", (float)vbfcat);
-    l.FillTree("MET", (float)l.shiftMET_pt);
-    l.FillTree("MET_phi", (float)l.shiftMET_phi);
+    fillOpTreeSlot(l, ot_cicpf4cutlevel1, (float)level1);
+    fillOpTreeSlot(l, ot_cicpf4cutlevel2, (float)level2);
+    fillOpTreeSlot(l, ot_idmva1, (float)phoid_mvaout_lead);
+    fillOpTreeSlot(l, ot_idmva2, (float)phoid_mvaout_sublead);
+    fillOpTreeSlot(l, ot_vbfcat, (float)vbfcat);
+    fillOpTreeSlot(l, ot_MET, (float)l.shiftMET_pt);
+    fillOpTreeSlot(l, ot_MET_phi, (float)l.shiftMET_phi);
 
     
     float val_isosumoet    = ((*l.pho_pfiso_mycharged03)[diphoton_index.first][l.dipho_vtxind[diphoton_id]] + l.pho_pfiso_myphoton03[diphoton_index.first] + 2.5 - l.rho_algo1*0.09)*50./lead_p4.Et();
     float val_isosumoetbad = (l.pho_pfiso_myphoton03[diphoton_index.first] + l.pho_pfiso_charged_badvtx_04[diphoton_index.first] + 2.5 - l.rho_algo1*0.23)*50./lead_p4.Et();
-    l.FillTree("isorv1", val_isosumoet);
-    l.FillTree("isowv1", val_isosumoetbad);
+    fillOpTreeSlot(l, ot_isorv1, val_isosumoet);
+    fillOpTreeSlot(l, ot_isowv1, val_isosumoetbad);
     
     float val_isosumoet2   = ((*l.pho_pfiso_mycharged03)[diphoton_index.second][l.dipho_vtxind[diphoton_id]] + l.pho_pfiso_myphoton03[diphoton_index.second] + 2.5 - l.rho_algo1*0.09)*50./lead_p4.Et();
     float val_isosumoetbad2= (l.pho_pfiso_myphoton03[diphoton_index.second] + l.pho_pfiso_charged_badvtx_04[diphoton_index.second] + 2.5 - l.rho_algo1*0.23)*50./lead_p4.Et();
-    l.FillTree("isorv2", val_isosumoet2);
-    l.FillTree("isowv2", val_isosumoetbad2);
+    fillOpTreeSlot(l, ot_isorv2, val_isosumoet2);
+    fillOpTreeSlot(l, ot_isowv2, val_isosumoetbad2);
     float s4ratio1 = l.pho_e2x2[diphoton_index.first]/l.pho_e5x5[diphoton_index.first];
     float rr2 = l.pho_eseffsixix[diphoton_index.first]*l.pho_eseffsixix[diphoton_index.first]+l.pho_eseffsiyiy[diphoton_index.first]*l.pho_eseffsiyiy[diphoton_index.first];
     float ESEffSigmaRR1 = 0.0; 
@@ -2178,10 +2261,10 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
         ESEffSigmaRR2 = sqrt(rr2);
     }
 
-    l.FillTree("s4ratio1", s4ratio1);
-    l.FillTree("s4ratio2", s4ratio2);
-    l.FillTree("effSigma1", ESEffSigmaRR1);
-    l.FillTree("effSigma2", ESEffSigmaRR2);
+    fillOpTreeSlot(l, ot_s4ratio1, s4ratio1);
+    fillOpTreeSlot(l, ot_s4ratio2, s4ratio2);
+    fillOpTreeSlot(l, ot_effSigma1, ESEffSigmaRR1);
+    fillOpTreeSlot(l, ot_effSigma2, ESEffSigmaRR2);
 
     ///float r1 = -1;
     ///float er1 = -1;
@@ -2205,7 +2288,7 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
 
     //l.FillTree("sceta1", (float)((TVector3*)l.sc_xyz->At(l.pho_scind[diphoton_index.first]))->Eta());
     //l.FillTree("scphi1", (float)((TVector3*)l.sc_xyz->At(l.pho_scind[diphoton_index.first]))->Phi());
-    l.FillTree("scraw1", l.sc_raw[l.pho_scind[diphoton_index.first]]);
+    fillOpTreeSlot(l, ot_scraw1, l.sc_raw[l.pho_scind[diphoton_index.first]]);
     //l.FillTree("e5x51", l.pho_e5x5[diphoton_index.first]);
     //l.FillTree("e3x31", l.pho_e3x3[diphoton_index.first]);
     //l.FillTree("sipip1", l.pho_sipip[diphoton_index.first]);
@@ -2233,7 +2316,7 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
 
     //l.FillTree("sceta2", (float)((TVector3*)l.sc_xyz->At(l.pho_scind[diphoton_index.second]))->Eta());
     //l.FillTree("scphi2", (float)((TVector3*)l.sc_xyz->At(l.pho_scind[diphoton_index.second]))->Phi());
-    l.FillTree("scraw2", l.sc_raw[l.pho_scind[diphoton_index.second]]);
+    fillOpTreeSlot(l, ot_scraw2, l.sc_raw[l.pho_scind[diphoton_index.second]]);
     //l.FillTree("e5x52", l.pho_e5x5[diphoton_index.second]);
     //l.FillTree("e3x32", l.pho_e3x3[diphoton_index.second]);
     //l.FillTree("sipip2", l.pho_sipip[diphoton_index.second]);
@@ -2260,39 +2343,39 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
     //l.FillTree("bphicry2", (float)999.);
     
     TVector3* vtx = (TVector3*)l.vtx_std_xyz->At(l.dipho_vtxind[diphoton_id]);
-    l.FillTree("vtx_x", (float)vtx->X());
-    l.FillTree("vtx_y", (float)vtx->Y());
-    l.FillTree("vtx_z", (float)vtx->Z());
+    fillOpTreeSlot(l, ot_vtx_x, (float)vtx->X());
+    fillOpTreeSlot(l, ot_vtx_y, (float)vtx->Y());
+    fillOpTreeSlot(l, ot_vtx_z, (float)vtx->Z());
 
     if (l.itype[l.current] != 0) {
         TVector3* gv = (TVector3*)l.gv_pos->At(0);
-        l.FillTree("gv_x", (float)gv->X());
-        l.FillTree("gv_y", (float)gv->Y());
-        l.FillTree("gv_z", (float)gv->Z());
+        fillOpTreeSlot(l, ot_gv_x, (float)gv->X());
+        fillOpTreeSlot(l, ot_gv_y, (float)gv->Y());
+        fillOpTreeSlot(l, ot_gv_z, (float)gv->Z());
     } else {
-        l.FillTree("gv_x", (float)9999.);
-        l.FillTree("gv_y", (float)9999.);
-        l.FillTree("gv_z", (float)9999.);
+        fillOpTreeSlot(l, ot_gv_x, (float)9999.);
+        fillOpTreeSlot(l, ot_gv_y, (float)9999.);
+        fillOpTreeSlot(l, ot_gv_z, (float)9999.);
     }
     
-    l.FillTree("dijet_leadEta",     myVBF_leadEta);
-    l.FillTree("dijet_subleadEta",  myVBF_subleadEta);
-    l.FillTree("dijet_LeadJPt",     myVBFLeadJPt);
-    l.FillTree("dijet_SubJPt",      myVBFSubJPt);
-    l.FillTree("dijet_dEta",        myVBFdEta);
-    l.FillTree("dijet_Zep",         myVBFZep);
-    l.FillTree("dijet_dPhi",        myVBFdPhi);
-    l.FillTree("dijet_Mjj",         myVBF_Mjj);
-    l.FillTree("dijet_MVA",         myVBF_MVA);
-
-    l.FillTree("issyst", (int)isSyst);
+    fillOpTreeSlot(l, ot_dijet_leadEta,     myVBF_leadEta);
+    fillOpTreeSlot(l, ot_dijet_subleadEta,  myVBF_subleadEta);
+    fillOpTreeSlot(l, ot_dijet_LeadJPt,     myVBFLeadJPt);
+    fillOpTreeSlot(l, ot_dijet_SubJPt,      myVBFSubJPt);
+    fillOpTreeSlot(l, ot_dijet_dEta,        myVBFdEta);
+    fillOpTreeSlot(l, ot_dijet_Zep,         myVBFZep);
+    fillOpTreeSlot(l, ot_dijet_dPhi,        myVBFdPhi);
+    fillOpTreeSlot(l, ot_dijet_Mjj,         myVBF_Mjj);
+    fillOpTreeSlot(l, ot_dijet_MVA,         myVBF_MVA);
+
+    fillOpTreeSlot(l, ot_issyst, (int)isSyst);
     l.FillTree("name1", name1);
 
     if(diphobdt_output>-2){
         vtxAna_.setPairID(diphoton_id);
         std::vector<int> & vtxlist = l.vtx_std_ranked_list->at(diphoton_id);
-        l.FillTree("sigmaMrvoM", (float)sigmaMrv/mass);
-        l.FillTree("sigmaMwvoM", (float)sigmaMwv/mass);
+        fillOpTreeSlot(l, ot_sigmaMrvoM, (float)sigmaMrv/mass);
+        fillOpTreeSlot(l, ot_sigmaMwvoM, (float)sigmaMwv/mass);
         
         //if (l.itype[l.current] == 3) {
         //    Int_t bin = weightHist->FindBin((float)Higgs.Pt());
@@ -2302,24 +2385,24 @@ void StatAnalysis::fillOpTree(LoopAll& l, const TLorentzVector & lead_p4, const
         //    l.FillTree("diphoptWeight", (float)1.);
         //}
         
-        l.FillTree("vtxprob", (float)vtxProb);
-        l.FillTree("ptbal", (float)vtxAna_.ptbal(vtxlist[0]));
-        l.FillTree("ptasym", (float)vtxAna_.ptasym(vtxlist[0]));
-        l.FillTree("logspt2", (float)vtxAna_.logsumpt2(vtxlist[0]));
-        l.FillTree("p2conv", (float)vtxAna_.pulltoconv(vtxlist[0]));
-        l.FillTree("nconv", (float)vtxAna_.nconv(vtxlist[0]));
+        fillOpTreeSlot(l, ot_vtxprob, (float)vtxProb);
+        fillOpTreeSlot(l, ot_ptbal, (float)vtxAna_.ptbal(vtxlist[0]));
+        fillOpTreeSlot(l, ot_ptasym, (float)vtxAna_.ptasym(vtxlist[0]));
+        fillOpTreeSlot(l, ot_logspt2, (float)vtxAna_.logsumpt2(vtxlist[0]));
+        fillOpTreeSlot(l, ot_p2conv, (float)vtxAna_.pulltoconv(vtxlist[0]));
+        fillOpTreeSlot(l, ot_nconv, (float)vtxAna_.nconv(vtxlist[0]));
         
         //for(size_t ii=0; ii<2; ++ii ) 
-        l.FillTree("vtxmva", (float)vtxAna_.mva(vtxlist[0]));
+        fillOpTreeSlot(l, ot_vtxmva, (float)vtxAna_.mva(vtxlist[0]));
         
         //for(size_t ii=1; ii<2; ++ii) 
         if (vtxlist.size() > 1)
-            l.FillTree("vtxdz", (float)(vtxAna_.vertexz(vtxlist[1])-vtxAna_.vertexz(vtxlist[0])));
+            fillOpTreeSlot(l, ot_vtxdz, (float)(vtxAna_.vertexz(vtxlist[1])-vtxAna_.vertexz(vtxlist[0])));
         else
-            l.FillTree("vtxdz", (float)-999.);
+            fillOpTreeSlot(l, ot_vtxdz, (float)-999.);
         
-        l.FillTree("dipho_mva", (float)diphobdt_output);
-        l.FillTree("dipho_mva_cat", (float)category);
+        fillOpTreeSlot(l, ot_dipho_mva, (float)diphobdt_output);
+        fillOpTreeSlot(l, ot_dipho_mva_cat, (float)category);
         if (diphobdt_output>=bdtCategoryBoundaries.back()) computeExclusiveCategory(l,category,diphoton_index,Higgs.Pt(),diphobdt_output); 
     }
 };
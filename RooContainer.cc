@@ -5,17 +5,19 @@
    
 #include "RooContainer.h"
 #include "RooMsgService.h"
+#include "RootLock.h"
 
 // CombinedLimit includes
 #include "HiggsAnalysis/CombinedLimit/interface/RooBernsteinFast.h"
 
 using namespace RooFit;
 
-RooContainer::RooContainer(int n, int s):ncat(n),nsigmas(s),make_systematics(false),save_systematics_data(false),verbosity_(false),fit_systematics(false),save_roodatahists(true){
+RooContainer::RooContainer(int n, int s):ncat(n),nsigmas(s),make_systematics(false),save_systematics_data(false),verbosity_(false),fit_systematics(false),save_roodatahists(true),save_dataset_keys(true){
 	
 // Set up the arrays which may be needed
 signalVector1 = new double[25];
 backgroundVector1 = new double[25];
+rangeSumBins_ = 0;
 
 blind_data = true;
 }
@@ -82,6 +84,10 @@ void RooContainer::SaveRooDataHists(bool save){
    save_roodatahists = save;
 }
 // ----------------------------------------------------------------------------------------------------
+void RooContainer::SaveDataSetKeys(bool save){
+   save_dataset_keys = save;
+}
+// ----------------------------------------------------------------------------------------------------
 void RooContainer::MakeSystematicStudy(std::vector<std::string> sys_names,std::vector<int> sys_types){
    make_systematics = true;
    std::vector<std::string>::iterator it = sys_names.begin();
@@ -468,6 +474,20 @@ void RooContainer::Save(){
   //setAllParametersConstant();
 
   ws.Write();
+
+  // One key per dataset: merging jobs read only these, instead of the whole workspace
+  if (save_dataset_keys){
+    std::cout << "RooContainer::Save -- Saving DataSet Keys "
+              << std::endl;
+    TDirectory *top = gDirectory;
+    TDirectory *dir = top->mkdir("cms_hgg_datasets");
+    dir->cd();
+    for (std::map<std::string,RooDataSet>::iterator it_data = data_.begin()
+        ;it_data!=data_.end();it_data++)	{
+	it_data->second.Write(it_data->first.c_str());
+    }
+    top->cd();
+  }
 }
 std::vector< std::pair<double,double> > RooContainer::GetFitNormalisationsAndErrors(std::string pdf_name, std::string data_name, double r1,double r2, bool external_fit){
  
@@ -548,26 +568,103 @@ std::vector<double> RooContainer::GetFitNormalisations(std::string pdf_name, std
 
 }
 // ----------------------------------------------------------------------------------------------------
-void RooContainer::InputDataPoint(std::string var_name, int cat, double x, double w){
+int RooContainer::makeInputHandle(std::string cat_name, std::string name, bool systematic){
 
-  if (cat < 0) return;
-  if (cat>-1 && cat<ncat){
+  std::map<std::string, RooDataSet>::iterator it_var  = data_.find(cat_name);
+  if (it_var == data_.end()) return -1;
+
+  input_handle_t handle;
+  handle.var   = m_data_var_ptr_[cat_name];
+  handle.min_x = m_var_min_[cat_name];
+  handle.max_x = m_var_max_[cat_name];
+  // Systematic sets are guaranteed to come from an already existing dataset
+  handle.data  = &(data_[name]);
+  handle.th1f  = &(m_th1f_[name]);
+  handle.systematic = systematic;
+  input_handles_.push_back(handle);
+  return input_handles_.size()-1;
+}
+
+// ----------------------------------------------------------------------------------------------------
+std::vector<int> & RooContainer::dataPointHandles(std::string var_name){
+
+  std::map<std::string,std::vector<int> >::iterator it = data_point_handles_.find(var_name);
+  if (it != data_point_handles_.end()) return it->second;
+
+  std::vector<int> & handles = data_point_handles_[var_name];
+  for (int cat=0;cat<ncat;cat++){
     std::string name = getcatName(var_name,cat);
-    std::map<std::string, RooDataSet>::iterator it_var  = data_.find(name);
-    if (it_var == data_.end()) 
-      std::cerr << "WARNING -- RooContainer::InputDataPoint -- No DataSet named "<< name << std::endl;
-    else{
-      double min_x = m_var_min_[name];
-      double max_x = m_var_max_[name];
+    handles.push_back(makeInputHandle(name,name,false));
+  }
+  return handles;
+}
 
-      if (x > min_x && x < max_x){
-        *(m_data_var_ptr_[name]) = x;
-        ((*it_var).second).add(RooArgSet(*(m_data_var_ptr_[name])),w);
+// ----------------------------------------------------------------------------------------------------
+std::vector<int> & RooContainer::systematicPointHandles(std::string s_name, std::string sys_name){
 
-        m_th1f_[name].Fill(x,w);
-      }
+  std::pair<std::string,std::string> key(s_name,sys_name);
+  std::map<std::pair<std::string,std::string>,std::vector<int> >::iterator it = syst_point_handles_.find(key);
+  if (it != syst_point_handles_.end()) return it->second;
+
+  std::vector<int> & handles = syst_point_handles_[key];
+  for (int cat=0;cat<ncat;cat++){
+    std::string cat_name = getcatName(s_name,cat);
+    for (int istep=0;istep<2*nsigmas;istep++){
+      int ishift = istep < nsigmas ? istep - nsigmas : istep - nsigmas + 1;
+      std::string name = getsysindexName( cat_name, sys_name, abs(ishift), (ishift > 0 ? 1 : -1) );
+      handles.push_back(makeInputHandle(cat_name,name,true));
     }
   }
+  return handles;
+}
+
+// ----------------------------------------------------------------------------------------------------
+int RooContainer::GetDataPointHandle(std::string var_name, int cat){
+
+  if (cat < 0 || cat >= ncat) return -1;
+  return dataPointHandles(var_name)[cat];
+}
+
+// ----------------------------------------------------------------------------------------------------
+int RooContainer::GetSystematicPointHandle(std::string s_name, std::string sys_name, int cat, int ishift){
+
+  if (cat < 0 || cat >= ncat || ishift == 0 || abs(ishift) > nsigmas) return -1;
+  int istep = ishift < 0 ? ishift + nsigmas : ishift + nsigmas - 1;
+  return systematicPointHandles(s_name,sys_name)[cat*2*nsigmas+istep];
+}
+
+// ----------------------------------------------------------------------------------------------------
+void RooContainer::InputDataPoint(int handle, double x, double w){
+
+  if (handle < 0) return;
+  input_handle_t & hdl = input_handles_[handle];
+  if (x > hdl.min_x && x < hdl.max_x){
+    // Only make systematic datasets if the save_systematics_data is on
+    if (!hdl.systematic || save_systematics_data){
+      R__LOCKGUARD(gRootLock);
+      *(hdl.var) = x;
+      hdl.data->add(RooArgSet(*(hdl.var)),w);
+    }
+    hdl.th1f->Fill(x,w);
+  }
+}
+
+// ----------------------------------------------------------------------------------------------------
+void RooContainer::InputSystematicPoint(int handle, double x, double w){
+  InputDataPoint(handle,x,w);
+}
+
+// ----------------------------------------------------------------------------------------------------
+void RooContainer::InputDataPoint(std::string var_name, int cat, double x, double w){
+
+  if (cat < 0) return;
+  if (cat>-1 && cat<ncat){
+    int handle = dataPointHandles(var_name)[cat];
+    if (handle < 0) 
+      std::cerr << "WARNING -- RooContainer::InputDataPoint -- No DataSet named "<< getcatName(var_name,cat) << std::endl;
+    else
+      InputDataPoint(handle,x,w);
+  }
 
   else {
     std::cerr << "WARNING -- RooContainer::InputDataPoint -- No Category Number " << cat 
@@ -605,39 +702,15 @@ void RooContainer::InputBinnedDataPoint(std::string var_name, int cat, double x,
 // ----------------------------------------------------------------------------------------------------
 void RooContainer::InputSystematicPoint(std::string s_name, std::string sys_name,int ishift, int cat,double val,double w){
 
-  
-  
 	if (cat>-1 && cat<ncat) {
 
-	  std::string cat_name = getcatName(s_name,cat);
-	  std::string name = getsysindexName( cat_name, sys_name, abs(ishift), (ishift > 0 ? 1 : -1) );
-	  
-	  std::map<std::string,RooDataSet>::iterator it_var  = data_.find(cat_name);
+	  int handle = GetSystematicPointHandle(s_name,sys_name,cat,ishift);
 	  
-	  if (it_var == data_.end()) 
-	    std::cerr << "WARNING -- RooContainer::InpusSystematicSet -- No DataSet named "<< cat_name << std::endl;
-	  
-	  else {
-	    
-	    // Safe to use this since creation of systematic set guaranteed to have come from an already existing dataset
-	    RooRealVar *ptr = m_data_var_ptr_[cat_name];
-	    double min_x = m_var_min_[cat_name];
-	    double max_x = m_var_max_[cat_name];
-	    
-	    RooDataSet & data_set = data_[name];
-	    TH1F & th1f_set = m_th1f_[name];
-	    
-	    if (val > min_x &&val < max_x ){
-
-		// Only make datasets if the save_systematics_data is on
-		if (save_systematics_data){
-	    	   *ptr = val;
-	    	   data_set.add(RooArgSet(*ptr),w);
-		}
-	    	th1f_set.Fill(val,w);
-	    }
-	  }
+	  if (handle < 0) 
+	    std::cerr << "WARNING -- RooContainer::InpusSystematicSet -- No DataSet named "<< getcatName(s_name,cat) << std::endl;
 	  
+	  else
+	    InputSystematicPoint(handle,val,w);
 	}
       
 }
@@ -660,6 +733,7 @@ void RooContainer::InputSystematicSet(std::string s_name, std::string sys_name,
 
   else{
   
+    std::vector<int> & handles = systematicPointHandles(s_name,sys_name);
     for(size_t istep=0; istep < x.size(); ++istep ) {
     
       int cat = cats[istep];
@@ -667,39 +741,13 @@ void RooContainer::InputSystematicSet(std::string s_name, std::string sys_name,
   
 	if (cat>-1 && cat<ncat) {
 
-	  /// int ishift = istep - nsigmas;
-	  /// if (ishift==0) ishift++;
-	  int ishift = (int) istep < nsigmas ? (int) istep - nsigmas : (int) istep - nsigmas + 1;
-
-	  std::string cat_name = getcatName(s_name,cat);
-	  std::string name = getsysindexName( cat_name, sys_name, abs(ishift), (ishift > 0 ? 1 : -1) );
+	  int handle = handles[cat*2*nsigmas+istep];
 	  
-	  std::map<std::string,RooDataSet>::iterator it_var  = data_.find(cat_name);
+	  if (handle < 0) 
+	    std::cerr << "WARNING -- RooContainer::InpusSystematicSet -- No DataSet named "<< getcatName(s_name,cat) << std::endl;
 	  
-	  if (it_var == data_.end()) 
-	    std::cerr << "WARNING -- RooContainer::InpusSystematicSet -- No DataSet named "<< cat_name << std::endl;
-	  
-	  else {
-	    
-	    // Safe to use this since creation of systematic set guaranteed to have come from an already existing dataset
-	    RooRealVar *ptr = m_data_var_ptr_[cat_name];
-	    double min_x = m_var_min_[cat_name];
-	    double max_x = m_var_max_[cat_name];
-	    
-	    	RooDataSet & data_set = data_[name];
-	    	TH1F & th1f_set = m_th1f_[name];
-	    
-	    	double val = x[istep];
-	    if (val > min_x &&val < max_x ){
-
-		// Only make datasets if the save_systematics_data is on
-		if (save_systematics_data){
-	    	   *ptr = val;
-	    	   data_set.add(RooArgSet(*ptr),w);
-		}
-	    	th1f_set.Fill(val,w);
-	    }
-	  }
+	  else 
+	    InputSystematicPoint(handle,x[istep],w);
 	  
 	}
       
@@ -1797,58 +1845,43 @@ void RooContainer::maxSigScan(double *maximumSignificance,int *frozen_counters,i
 	if (counters[movingCounterIndex] < 2) std::cout << "WHAT IS GOING ON?? " <<  movingCounterIndex << " " << counters[movingCounterIndex]<<std::endl;
 
 	if ( movingCounterIndex==N-1) {	
-	 if (not sweepmode){
-	    for (;counters[N-1]<=nBins;counters[N-1]+=g_step){
-		for (int j=0;j<=N-1;j++){
-			if (j==0){
-			  signalVector1[j] = (hs->Integral(1,counters[j]-1));
-			  backgroundVector1[j] = (hb->Integral(1,counters[j]-1));
-
-			} else {
-			  signalVector1[j] = (hs->Integral(counters[j-1],counters[j]-1));
-			  backgroundVector1[j] = (hb->Integral(counters[j-1],counters[j]-1));
-
-			}
-	   	 }
-		signalVector1[N]=(hs->Integral(counters[N-1],nBins));
-		backgroundVector1[N]=(hb->Integral(counters[N-1],nBins));
-		significance_now = calculateSigMulti(signalVector1,backgroundVector1,N+1);
-
-		if (significance_now>*maximumSignificance){
-			*maximumSignificance=significance_now;
-			for (int j=0;j<N;j++){
-				chosen_counters[j]=counters[j];	
-				if (chosen_counters[j] < 0) std::cout << "Freak OUT !!! - " << j << "  " << chosen_counters[j] <<std::endl;
-			}
+	 // broad scan moves the last boundary by g_step up to the end, fine scan by one up to g_step past the rough guess
+	 int laststep = (not sweepmode) ? g_step : 1;
+	 int lastmax = nBins;
+	 if (sweepmode && frozen_counters[N-1] + g_step < nBins) lastmax = frozen_counters[N-1] + g_step;
+
+	 // bins below counters[N-2] do not depend on the last boundary, sum their terms once
+	 // in the same order as calculateSigMulti so that the significance is unchanged
+	 double logtermsFixed=0, stermFixed=0;
+	 for (int j=0;j<N-1;j++){
+		signalVector1[j] = rangeSum(sigRangeSums_,(j==0 ? 1 : counters[j-1]),counters[j]-1);
+		backgroundVector1[j] = rangeSum(bkgRangeSums_,(j==0 ? 1 : counters[j-1]),counters[j]-1);
+		logtermsFixed+=(signalVector1[j]+backgroundVector1[j])*TMath::Log((signalVector1[j]+backgroundVector1[j])/backgroundVector1[j]);
+		stermFixed+=signalVector1[j];
+	 }
+	 int lastlow = (N==1) ? 1 : counters[N-2];
+	 for (;counters[N-1]<=lastmax;counters[N-1]+=laststep){
+		signalVector1[N-1] = rangeSum(sigRangeSums_,lastlow,counters[N-1]-1);
+		backgroundVector1[N-1] = rangeSum(bkgRangeSums_,lastlow,counters[N-1]-1);
+		signalVector1[N] = rangeSum(sigRangeSums_,counters[N-1],nBins);
+		backgroundVector1[N] = rangeSum(bkgRangeSums_,counters[N-1],nBins);
+
+		double logterms = logtermsFixed;
+		double sterm = stermFixed;
+		for (int j=N-1;j<=N;j++){
+		  logterms+=(signalVector1[j]+backgroundVector1[j])*TMath::Log((signalVector1[j]+backgroundVector1[j])/backgroundVector1[j]);
+		  sterm+=signalVector1[j];
 		}
-	     }
-	     maxSigScan(maximumSignificance,frozen_counters,chosen_counters,hs,hb,N,counters,movingCounterIndex-1);
-	 } else { // fine scanning
-	    int currmax = (nBins < frozen_counters[N-1] + g_step )? nBins : frozen_counters[N-1] + g_step;
-	    for (;counters[N-1]<=currmax;counters[N-1]++){
-		for (int j=0;j<=N-1;j++){
-			if (j==0){
-			  signalVector1[j] = (hs->Integral(1,counters[j]-1));
-			  backgroundVector1[j] = (hb->Integral(1,counters[j]-1));
+		significance_now = 1.4142*TMath::Sqrt(logterms - sterm);
 
-			} else {
-			  signalVector1[j] = (hs->Integral(counters[j-1],counters[j]-1));
-			  backgroundVector1[j] = (hb->Integral(counters[j-1],counters[j]-1));
-
-			}
-	   	 }	
-		signalVector1[N]=(hs->Integral(counters[N-1],nBins));
-		backgroundVector1[N]=(hb->Integral(counters[N-1],nBins));
-		significance_now = calculateSigMulti(signalVector1,backgroundVector1,N+1);
 		if (significance_now>*maximumSignificance){
 			*maximumSignificance=significance_now;
 			for (int j=0;j<N;j++){
-				chosen_counters[j]=counters[j];
+				chosen_counters[j]=counters[j];	
 			}
 		}
-	     }
-	     maxSigScan(maximumSignificance,frozen_counters,chosen_counters,hs,hb,N,counters,movingCounterIndex-1);
 	 }
+	 maxSigScan(maximumSignificance,frozen_counters,chosen_counters,hs,hb,N,counters,movingCounterIndex-1);
 	}
 
 
@@ -1901,6 +1934,37 @@ void RooContainer::maxSigScan(double *maximumSignificance,int *frozen_counters,i
 
 }
 
+// ----------------------------------------------------------------------------------------------------
+void RooContainer::fillRangeSums(TH1F *h, std::vector<double> &sums){
+
+	// Table of h->Integral(a,b) for 1<=a<=nBins and a<=b<=nBins+1, row a starting at rangeSumRow_[a].
+	// Each row is accumulated bin by bin, as TH1::Integral does, so the values are the same to the last bit.
+	int nBins = h->GetNbinsX();
+	rangeSumRow_.assign(nBins+2,0);
+	int nsums=0;
+	for (int a=1;a<=nBins;a++){
+		rangeSumRow_[a]=nsums;
+		nsums+=nBins+2-a;
+	}
+	sums.resize(nsums);
+	for (int a=1;a<=nBins;a++){
+		double integral=0;
+		double *row = &sums[rangeSumRow_[a]];
+		for (int b=a;b<=nBins+1;b++){
+			integral+=h->GetBinContent(b);
+			row[b-a]=integral;
+		}
+	}
+	rangeSumBins_=nBins;
+}
+
+double RooContainer::rangeSum(const std::vector<double> &sums, int a, int b){
+
+	// same conventions as TH1::Integral: a range ending before it starts runs up to the overflow
+	if (b<a || b>rangeSumBins_+1) b=rangeSumBins_+1;
+	return sums[rangeSumRow_[a]+b-a];
+}
+
 // ----------------------------------------------------------------------------------------------------
 std::vector<double> RooContainer::significanceOptimizedBinning(TH1F *hs,TH1F *hb,int nTargetBins){
 
@@ -1958,6 +2022,10 @@ std::vector<double> RooContainer::significanceOptimizedBinning(TH1F *hs,TH1F *hb
 	int 	chosenN=1;
 	int 	*finalCounters ;
 
+	// every candidate placement needs the signal and background in each bin range, tabulate them once
+	fillRangeSums(hsnew,sigRangeSums_);
+	fillRangeSums(hbnew,bkgRangeSums_);
+
 	g_step = (int)TMath::Exp(TMath::Log(nNewBins/2)/2);
 	if (g_step < 1) g_step=1;
 		
@@ -3311,6 +3379,22 @@ void RooContainer::AppendTH1F(std::string name, TH1F *extraHist){
 
 }
 
+// Add the content of another container with the same booking (e.g. filled by a different thread)
+void RooContainer::Merge(RooContainer &other){
+
+  for (std::map<std::string,RooDataSet>::iterator it_data = data_.begin()
+      ;it_data!=data_.end();it_data++){
+    std::map<std::string,RooDataSet>::iterator it_extra = other.data_.find(it_data->first);
+    if (it_extra != other.data_.end()) (it_data->second).append(it_extra->second);
+  }
+
+  for (std::map<std::string,TH1F>::iterator it_hist = m_th1f_.begin()
+      ;it_hist!=m_th1f_.end();it_hist++){
+    std::map<std::string,TH1F>::iterator it_extra = other.m_th1f_.find(it_hist->first);
+    if (it_extra != other.m_th1f_.end()) (it_hist->second).Add(&(it_extra->second));
+  }
+}
+
 //Getty type functions
 std::vector<std::string> RooContainer::GetDataSetNames(){
 
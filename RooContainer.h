@@ -69,6 +69,7 @@ class RooContainer {
     void SaveSystematicsData(bool save=true);
     void MakeSystematicPdfs(bool save=true);
     void SaveRooDataHists(bool save=true);
+    void SaveDataSetKeys(bool save=true);
     void MakeSystematicStudy(std::vector<std::string>,std::vector<int>);
     void AddObservable(std::string,double,double);
     void AddConstant(std::string,double);
@@ -113,6 +114,14 @@ class RooContainer {
 			   ,std::vector<double> x, std::vector<double> weights=std::vector<double>(0));
    void InputSystematicPoint(std::string s_name, std::string sys_name, int cat, int ishift,double x, double w=1);
 
+   // Handles resolve the dataset, observable, range and histogram of a (observable, category, systematic shift) 
+   // once, so that filling them in the event loop does not involve any string formatting or map lookup.
+   // They must be requested after the datasets have been created. -1 means that no such dataset exists.
+   int GetDataPointHandle(std::string,int);
+   int GetSystematicPointHandle(std::string s_name, std::string sys_name, int cat, int ishift);
+   void InputDataPoint(int handle,double x,double w=1.);
+   void InputSystematicPoint(int handle,double x,double w=1.);
+
    void RebinBinnedDataset(std::string,std::string,std::vector <std::vector<double> >, bool);
    void RebinBinnedDataset(std::string,std::string,std::vector<double> , bool);
    std::vector<std::vector<double> >OptimizedBinning(std::string,int,bool,bool,int direction=1);
@@ -130,6 +139,7 @@ class RooContainer {
 
    void AppendDataSet(std::string, RooDataSet*);
    void AppendTH1F(std::string, TH1F*);
+   void Merge(RooContainer &);
 
    std::vector<std::string> GetDataSetNames();
    std::vector<std::string> GetTH1FNames();
@@ -142,6 +152,9 @@ class RooContainer {
    bool save_systematics_data;
    bool verbosity_;
    bool save_roodatahists;
+   // also write each dataset as its own key in the cms_hgg_datasets directory, 
+   // so that they can be read back without the workspace (see LoopAll::MergeContainers)
+   bool save_dataset_keys;
 
   private:
 
@@ -193,7 +206,26 @@ class RooContainer {
    void getArgSetParameters(RooArgSet*,std::vector<double> &);
    void setArgSetParameters(RooArgSet*,std::vector<double> &);
 
+#ifndef __CINT__
+   struct input_handle_t {
+     RooDataSet *data;
+     RooRealVar *var;
+     TH1F *th1f;
+     double min_x, max_x;
+     bool systematic;
+   };
+   std::vector<input_handle_t> input_handles_;
+   // handles per observable indexed by category, and per observable and systematic indexed by category*2*nsigmas+step
+   std::map<std::string,std::vector<int> > data_point_handles_;
+   std::map<std::pair<std::string,std::string>,std::vector<int> > syst_point_handles_;
+#endif
+   int makeInputHandle(std::string,std::string,bool);
+   std::vector<int> & dataPointHandles(std::string);
+   std::vector<int> & systematicPointHandles(std::string,std::string);
+
    void maxSigScan(double *maximumSignificance,int *frozen_counters,int *chosen_counters,TH1F *hs, TH1F *hb, int N,int *counters, int movingCounterIndex);
+   void fillRangeSums(TH1F *h, std::vector<double> &sums);
+   double rangeSum(const std::vector<double> &sums, int a, int b);
 
    std::map<std::string,int> systematics_;
    std::map<std::string,std::pair<double,double> > global_systematics_;
@@ -242,6 +274,10 @@ class RooContainer {
    double *backgroundVector1;
    int g_step;
    int sweepmode;
+   // bin range integrals of the histograms being scanned by maxSigScan, filled by fillRangeSums
+   std::vector<double> sigRangeSums_, bkgRangeSums_;
+   std::vector<int> rangeSumRow_;
+   int rangeSumBins_;
   
    bool blind_data;
 
@@ -3,6 +3,7 @@
 
 #include "RooWorkspace.h"
 #include "RooFunctor.h"
+#include "RootLock.h"
 
 class RooFuncReader
 {
@@ -12,6 +13,7 @@ public:
 	void bookVariable(const std::string &name, float * ptr);
 	
 	double eval() {
+		R__LOCKGUARD(gRootLock);
 		for(size_t iv=0; iv<varsbuf_.size(); ++iv) {
 			varsbuf_[iv] = *(varsptrs_[iv]);
 		}
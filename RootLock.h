@@ -0,0 +1,12 @@
+#ifndef ROOTLOCK
+#define ROOTLOCK
+
+#include "TVirtualMutex.h"
+
+/** lock around the calls into the parts of ROOT which are not thread-safe: TMVA::Reader (booking lookups
+    and evaluation, including the inputs shared among readers) and RooFit (dataset filling, function evaluation).
+    It is only created by LoopAll::CreateWorkers when the event loop runs on several threads:
+    in single-threaded jobs it stays null and R__LOCKGUARD(gRootLock) does nothing. */
+R__EXTERN TVirtualMutex * gRootLock;
+
+#endif
@@ -1,6 +1,7 @@
 #include "SampleContainer.h"
 #include <utility>
 #include <iostream>
+#include <algorithm>
 
 SampleContainer::~SampleContainer() 
 {}
@@ -26,6 +27,9 @@ SampleContainer::SampleContainer(const float * extw) :
 	hasEventList = false;
 	pileup = "";
 	forceVersion = 0;
+	lumisCompiled = false;
+	eventsCompiled = false;
+	lastLumiRange = -1;
 }
 
 void SampleContainer::computeWeight(float intL) {
@@ -41,6 +45,7 @@ void SampleContainer::computeWeight(float intL) {
 void SampleContainer::addGoodLumi(int run, int lumi1, int lumi2 )
 {
 	hasLumiSelection = true;
+	lumisCompiled = false;
 	goodLumis[run].push_back( std::make_pair(lumi1,lumi2) );
 }
 
@@ -49,5 +54,76 @@ void SampleContainer::addGoodLumi(int run, int lumi1, int lumi2 )
 void SampleContainer::addEventToList(int run, int lumi, int event )
 {
 	hasEventList = true;
+	eventsCompiled = false;
 	eventList[run].push_back( std::make_pair(lumi,event) );
 }
+
+// ----------------------------------------------------------------------------------------------------------------------
+void SampleContainer::compileLumis()
+{
+	lumiRanges.clear();
+	for(std::map<int, std::vector<std::pair<int,int> > >::iterator irun=goodLumis.begin(); irun!=goodLumis.end(); ++irun) {
+		for(std::vector<std::pair<int,int> >::iterator it=irun->second.begin(); it!=irun->second.end(); ++it) {
+			if( it->second < it->first ) { continue; }
+			lumiRange_t range = { irun->first, it->first, it->second };
+			lumiRanges.push_back(range);
+		}
+	}
+	std::sort(lumiRanges.begin(),lumiRanges.end());
+	// merge overlapping and adjacent ranges, so that at most one range can contain a given lumi section
+	size_t nmerged = 0;
+	for(size_t ii=0; ii<lumiRanges.size(); ++ii) {
+		if( nmerged > 0 && lumiRanges[nmerged-1].run == lumiRanges[ii].run && 
+		    (long long)lumiRanges[ii].first <= (long long)lumiRanges[nmerged-1].last + 1 ) {
+			lumiRanges[nmerged-1].last = std::max(lumiRanges[nmerged-1].last,lumiRanges[ii].last);
+		} else {
+			lumiRanges[nmerged++] = lumiRanges[ii];
+		}
+	}
+	lumiRanges.resize(nmerged);
+	lastLumiRange = -1;
+	lumisCompiled = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------------------
+void SampleContainer::compileEvents()
+{
+	events.clear();
+	for(std::map<int, std::vector<std::pair<int,int> > >::iterator irun=eventList.begin(); irun!=eventList.end(); ++irun) {
+		for(std::vector<std::pair<int,int> >::iterator it=irun->second.begin(); it!=irun->second.end(); ++it) {
+			eventId_t id = { irun->first, it->first, it->second };
+			events.push_back(id);
+		}
+	}
+	std::sort(events.begin(),events.end());
+	eventsCompiled = true;
+}
+
+// ----------------------------------------------------------------------------------------------------------------------
+bool SampleContainer::isGoodLumi(int run, int lumi)
+{
+	if( ! lumisCompiled ) { compileLumis(); }
+	
+	// consecutive events mostly come from the same lumi range
+	if( lastLumiRange >= 0 ) {
+		const lumiRange_t & last = lumiRanges[lastLumiRange];
+		if( run == last.run && lumi >= last.first && lumi <= last.last ) { return true; }
+	}
+	
+	// last range starting at or before the lumi section
+	lumiRange_t probe = { run, lumi, lumi };
+	std::vector<lumiRange_t>::iterator it = std::upper_bound(lumiRanges.begin(),lumiRanges.end(),probe);
+	if( it == lumiRanges.begin() ) { return false; }
+	--it;
+	if( it->run != run || lumi > it->last ) { return false; }
+	lastLumiRange = it - lumiRanges.begin();
+	return true;
+}
+
+// ----------------------------------------------------------------------------------------------------------------------
+bool SampleContainer::isInEventList(int run, int lumi, int event)
+{
+	if( ! eventsCompiled ) { compileEvents(); }
+	eventId_t id = { run, lumi, event };
+	return std::binary_search(events.begin(),events.end(),id);
+}
@@ -25,9 +25,17 @@ class SampleContainer {
   void addGoodLumi(int run, int lumi1, int lumi2 );
 
   void addEventToList(int run, int lumi, int event );
+
+  /** check a lumi section against 'goodLumis' and an event against 'eventList'.
+      The first call after the lists have been modified compiles them into sorted
+      arrays of merged lumi ranges and of events, which are then searched by bisection. */
+  bool isGoodLumi(int run, int lumi);
+  bool isInEventList(int run, int lumi, int event);
   
   bool isdata() const { return itype == 0; };
   float weight() const { return ( (extweight!=0 && *extweight > 0 && ! isdata()) ? (*extweight)*intweight : intweight); };
+  const float * extWeight() const { return extweight; };
+  void setExtWeight(const float * extw) { extweight = extw; };
   
   int itype;
   int ind;
@@ -51,6 +59,25 @@ class SampleContainer {
   const float * extweight;
   float intweight;
 
+#ifndef __CINT__
+  struct lumiRange_t {
+	  int run, first, last;
+	  bool operator<(const lumiRange_t & o) const { return run < o.run || (run == o.run && first < o.first); };
+  };
+  struct eventId_t {
+	  int run, lumi, event;
+	  bool operator<(const eventId_t & o) const { 
+		  return run < o.run || (run == o.run && (lumi < o.lumi || (lumi == o.lumi && event < o.event))); 
+	  };
+  };
+  void compileLumis();
+  void compileEvents();
+  bool lumisCompiled, eventsCompiled;
+  std::vector<lumiRange_t> lumiRanges;
+  std::vector<eventId_t> events;
+  int lastLumiRange;
+#endif
+
 
 };
 
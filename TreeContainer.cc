@@ -35,49 +35,83 @@ int TreeContainer::getTreeVal() {
 }
 
 
-void TreeContainer::AddTreeBranch(std::string name,int type){
+namespace {
+  /// address of the value of a new branch: the given one if any, a new element of values otherwise
+  template<class T> T * branchAddress(void * address, std::list<T> & values, const T & init) {
+    if (address) return (T*)address;
+    values.push_back(init);
+    return &(values.back());
+  }
+  
+  template<class T> void getSlot(const std::map<std::string,T*> & branches, const std::string & name, T * & address) {
+    typename std::map<std::string,T*>::const_iterator it = branches.find(name);
+    address = (it!=branches.end() ? it->second : 0);
+  }
+}
+
+void * TreeContainer::AddTreeBranch(std::string name,int type, void * address){
 
   if (type==0){	// Int_t
-    int_branches.insert(std::pair<std::string,int> (name,-999) );	
-    tr_->Branch(name.c_str(),&(int_branches[name]),Form("%s/Int_t",name.c_str()));
+    int * value = branchAddress(address, int_values, -999);
+    int_branches.insert(std::pair<std::string,int*> (name,value) );	
+    tr_->Branch(name.c_str(),int_branches[name],Form("%s/Int_t",name.c_str()));
     if (TCDEBUG)	std::cout << "TreeContainer -- Creating Int Branch " << name << std::endl;
+    return int_branches[name];
   }
   else if (type==1){	// Unsigned Int_t
-    uint_branches.insert(std::pair<std::string,unsigned int> (name,999.) );	
-    tr_->Branch(name.c_str(),&(uint_branches[name]),Form("%s/UInt_t",name.c_str()));
+    unsigned int * value = branchAddress(address, uint_values, (unsigned int)999);
+    uint_branches.insert(std::pair<std::string,unsigned int*> (name,value) );	
+    tr_->Branch(name.c_str(),uint_branches[name],Form("%s/UInt_t",name.c_str()));
     if (TCDEBUG)	std::cout << "TreeContainer -- Creating UInt Branch " << name << std::endl;
+    return uint_branches[name];
   }
   else if (type==2){	// Float_t
-    float_branches.insert(std::pair<std::string,float> (name,-999.) );
-    tr_->Branch(name.c_str(),&(float_branches[name]),Form("%s/Float_t",name.c_str()));
+    float * value = branchAddress(address, float_values, (float)-999.);
+    float_branches.insert(std::pair<std::string,float*> (name,value) );
+    tr_->Branch(name.c_str(),float_branches[name],Form("%s/Float_t",name.c_str()));
     if (TCDEBUG)	std::cout << "TreeContainer -- Creating Float Branch " << name << std::endl;
+    return float_branches[name];
   }
   else if (type==3){	// Double_t
-    double_branches.insert(std::pair<std::string,double> (name,-999.) );	
-    tr_->Branch(name.c_str(),&(double_branches[name]),Form("%s/Double_t",name.c_str()));
+    double * value = branchAddress(address, double_values, -999.);
+    double_branches.insert(std::pair<std::string,double*> (name,value) );	
+    tr_->Branch(name.c_str(),double_branches[name],Form("%s/Double_t",name.c_str()));
     if (TCDEBUG)	std::cout << "TreeContainer -- Creating Double Branch " << name << std::endl;
+    return double_branches[name];
   }
   else if (type==4) {     // std::string
-    string_branches.insert(std::pair<std::string, std::string> (name, ""));	
+    std::string * value = branchAddress(address, string_values, std::string(""));
+    string_branches.insert(std::pair<std::string, std::string*> (name, value));	
     //tr_->Branch(name.c_str(), &(string_branches[name]),Form("%s/C",name.c_str()));
-    tr_->Branch(name.c_str(), "std::string", &(string_branches[name]));
+    tr_->Branch(name.c_str(), "std::string", string_branches[name]);
     if (TCDEBUG)	std::cout << "TreeContainer -- Creating String Branch " << name << std::endl;
+    return string_branches[name];
   }
   else if (type==5){
-    bool_branches.insert(std::pair<std::string,bool> (name,false) );
-    tr_->Branch(name.c_str(),&(bool_branches[name]),Form("%s/Bool_t",name.c_str()));
+    bool * value = branchAddress(address, bool_values, false);
+    bool_branches.insert(std::pair<std::string,bool*> (name,value) );
+    tr_->Branch(name.c_str(),bool_branches[name],Form("%s/Bool_t",name.c_str()));
     if (TCDEBUG) std::cout << "TreeContainer -- Creating Bool Branch " << name << std::endl;
+    return bool_branches[name];
     
   } else { 
     std::cerr << "TreeContainer -- No Type " << type << std::endl;
   }
+  return 0;
 }
 
+void TreeContainer::GetSlot(const std::string & name, float * & address){ getSlot(float_branches, name, address); }
+void TreeContainer::GetSlot(const std::string & name, double * & address){ getSlot(double_branches, name, address); }
+void TreeContainer::GetSlot(const std::string & name, int * & address){ getSlot(int_branches, name, address); }
+void TreeContainer::GetSlot(const std::string & name, unsigned int * & address){ getSlot(uint_branches, name, address); }
+void TreeContainer::GetSlot(const std::string & name, std::string * & address){ getSlot(string_branches, name, address); }
+void TreeContainer::GetSlot(const std::string & name, bool * & address){ getSlot(bool_branches, name, address); }
+
 void TreeContainer::FillFloat(std::string name, float x){
 
-  std::map<std::string,float>::iterator it = float_branches.find(name);
+  std::map<std::string,float*>::iterator it = float_branches.find(name);
   if (it!=float_branches.end()){
-    (*it).second = x;
+    *(it->second) = x;
   } else {
     std::cerr << "TreeContainer -- No Float Tree trying Double" << name << std::endl;
     FillDouble(name,x);
@@ -86,9 +120,9 @@ void TreeContainer::FillFloat(std::string name, float x){
 
 void TreeContainer::FillInt(std::string name, int x){
   
-  std::map<std::string,int>::iterator it = int_branches.find(name);
+  std::map<std::string,int*>::iterator it = int_branches.find(name);
   if (it!=int_branches.end()){
-    (*it).second = x;
+    *(it->second) = x;
   } else {
     std::cerr << "TreeContainer -- No Int Tree " << name << std::endl;
   }
@@ -96,9 +130,9 @@ void TreeContainer::FillInt(std::string name, int x){
 
 void TreeContainer::FillUInt(std::string name, unsigned int x){
   
-  std::map<std::string,unsigned int>::iterator it = uint_branches.find(name);
+  std::map<std::string,unsigned int*>::iterator it = uint_branches.find(name);
   if (it!=uint_branches.end()){
-    (*it).second = x;
+    *(it->second) = x;
   } else {
     std::cerr << "TreeContainer -- No UInt Tree " << name << std::endl;
   }
@@ -106,9 +140,9 @@ void TreeContainer::FillUInt(std::string name, unsigned int x){
 
 void TreeContainer::FillDouble(std::string name, double x){
   
-  std::map<std::string,double>::iterator it = double_branches.find(name);
+  std::map<std::string,double*>::iterator it = double_branches.find(name);
   if (it!=double_branches.end()){
-    (*it).second = x;
+    *(it->second) = x;
   } else {	
     std::cerr << "TreeContainer -- No Double Tree trying Float " << name << std::endl;
     FillFloat(name,x);
@@ -116,18 +150,18 @@ void TreeContainer::FillDouble(std::string name, double x){
 }
 
 void TreeContainer::FillString(std::string name, std::string x) {
-  std::map<std::string,std::string>::iterator it = string_branches.find(name);
+  std::map<std::string,std::string*>::iterator it = string_branches.find(name);
   if (it!=string_branches.end()){
-    (*it).second = x;
+    *(it->second) = x;
   } else {	
     std::cerr << "TreeContainer -- No Double Tree " << name << std::endl;
   }
 }
 
 void TreeContainer::FillBool(std::string name, bool x){
-  std::map<std::string,bool>::iterator it = bool_branches.find(name);
+  std::map<std::string,bool*>::iterator it = bool_branches.find(name);
   if (it!=bool_branches.end()){
-    (*it).second = x;
+    *(it->second) = x;
   } else {
     std::cerr << "TreeeContainer -- No Bool Tree " << name << std::endl;
   }
@@ -154,19 +188,19 @@ void TreeContainer::Save(TFile* f) {
 }
 
 void TreeContainer::resetDefaults(){
-  for (std::map<std::string,int>::iterator it = int_branches.begin();it!=int_branches.end() ;it++){
-    (*it).second=-999;
+  for (std::map<std::string,int*>::iterator it = int_branches.begin();it!=int_branches.end() ;it++){
+    *((*it).second)=-999;
   }
-  for (std::map<std::string,unsigned int>::iterator it = uint_branches.begin();it!=uint_branches.end() ;it++){
-    (*it).second=999;
+  for (std::map<std::string,unsigned int*>::iterator it = uint_branches.begin();it!=uint_branches.end() ;it++){
+    *((*it).second)=999;
   }
-  for (std::map<std::string,float>::iterator it = float_branches.begin();it!=float_branches.end() ;it++){
-    (*it).second=-999.;
+  for (std::map<std::string,float*>::iterator it = float_branches.begin();it!=float_branches.end() ;it++){
+    *((*it).second)=-999.;
   }
-  for (std::map<std::string,double>::iterator it = double_branches.begin();it!=double_branches.end() ;it++){
-    (*it).second=-999.;
+  for (std::map<std::string,double*>::iterator it = double_branches.begin();it!=double_branches.end() ;it++){
+    *((*it).second)=-999.;
   }
-  for (std::map<std::string,bool>::iterator it = bool_branches.begin();it!=bool_branches.end() ;it++){
-    (*it).second=-999.;
+  for (std::map<std::string,bool*>::iterator it = bool_branches.begin();it!=bool_branches.end() ;it++){
+    *((*it).second)=-999.;
   }
 }
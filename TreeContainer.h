@@ -4,6 +4,7 @@
 #include <TFile.h>
 #include <TTree.h>
 #include <map>
+#include <list>
 #include <string>
 
 class TreeContainer {
@@ -20,7 +21,18 @@ class TreeContainer {
   void FillString(std::string, std::string);
   void FillBool(std::string, bool);
 
-  void AddTreeBranch(std::string, int);
+  /** books a branch of the given type. The value is stored in the container, unless the address of a variable
+      of the right type is passed, in which case the branch is bound to it (and reset to the default after each fill).
+      @return the address of the branch value */
+  void * AddTreeBranch(std::string, int, void * address=0);
+  
+  /** set the address of the value of a booked branch; 0 if there is no such branch of this type */
+  void GetSlot(const std::string &, float * &);
+  void GetSlot(const std::string &, double * &);
+  void GetSlot(const std::string &, int * &);
+  void GetSlot(const std::string &, unsigned int * &);
+  void GetSlot(const std::string &, std::string * &);
+  void GetSlot(const std::string &, bool * &);
   template<class T> void AddExternalBranch(const char * name, T* addr) { tr_->Branch(name,addr); };
   template <class T> void AddExternalBranch(const char * name, T* addr, const char*  type) { tr_->Branch(name,addr,type); };
   template <class T> void AddExternalBranch(const char * name, T* addr, int bufsize, int splitlevel) { tr_->Branch(name,addr,bufsize,splitlevel); };
@@ -42,12 +54,20 @@ class TreeContainer {
   std::string dirName;
    
   TTree *tr_;
-  std::map<std::string, double>         double_branches;
-  std::map<std::string, float>          float_branches;
-  std::map<std::string, int>            int_branches;
-  std::map<std::string, unsigned int>   uint_branches;
-  std::map<std::string, std::string>    string_branches;
-  std::map<std::string, bool>           bool_branches;
+  // addresses of the branch values, either in the lists below or in variables shared with other containers
+  std::map<std::string, double*>        double_branches;
+  std::map<std::string, float*>         float_branches;
+  std::map<std::string, int*>           int_branches;
+  std::map<std::string, unsigned int*>  uint_branches;
+  std::map<std::string, std::string*>   string_branches;
+  std::map<std::string, bool*>          bool_branches;
+
+  std::list<double>       double_values;
+  std::list<float>        float_values;
+  std::list<int>          int_values;
+  std::list<unsigned int> uint_values;
+  std::list<std::string>  string_values;
+  std::list<bool>         bool_values;
 
   void resetDefaults();
 
@@ -15,23 +15,41 @@ public:
 };
 
 // ----------------------------------------------------------------------------------------------------
-bool TriggerSelection::pass(const std::vector<std::string> & menu, const std::vector<unsigned short> & bits) 
+void TriggerSelection::setMenu(const std::vector<std::string> & menu) 
 {
+	menu_ = menu;
+	accept_.assign(menu.size(),0);
 	// loop over requestedpath names
 	for(std::vector<std::string>::iterator it=paths.begin(); it!=paths.end(); ++it ) {
 		// is the path in the menu?
 		std::vector<std::string>::const_iterator jt=find_if(menu.begin(),menu.end(), bind2nd(IsSubstring(),*it) );
 		if( jt != menu.end() ) {
-			// if yes check if the bit fired
+			// if yes accept the corresponding bit
 			int ibit = jt - menu.begin();
 			// std::cerr << "TriggerSelection found path " << *it << " " << *jt << " bit " << ibit << std::endl;
-			if( find(bits.begin(),bits.end(),ibit) != bits.end() ) { 
-				/// std::cerr << "Fired" << std::endl;
-				return true; 
-			}
+			accept_[ibit] = 1;
 		} else {
 			std::cerr << "TriggerSelection did not find path " << *it << std::endl;
 		}
 	} // loop over all paths for which we would accept the event
+}
+
+// ----------------------------------------------------------------------------------------------------
+bool TriggerSelection::pass(const std::vector<unsigned short> & bits) const
+{
+	for(std::vector<unsigned short>::const_iterator it=bits.begin(); it!=bits.end(); ++it ) {
+		if( *it < accept_.size() && accept_[*it] ) { 
+			return true; 
+		}
+	}
 	return false;
 }
+
+// ----------------------------------------------------------------------------------------------------
+bool TriggerSelection::pass(const std::vector<std::string> & menu, const std::vector<unsigned short> & bits) 
+{
+	if( menu.size() != menu_.size() || menu != menu_ ) {
+		setMenu(menu);
+	}
+	return pass(bits);
+}
@@ -10,12 +10,22 @@ class TriggerSelection
 public:
 	TriggerSelection(int first, int last) : firstrun(first), lastrun(last) {};
 	bool operator == (int run) { return run>=firstrun && ( lastrun<0 || run<=lastrun); }; 
-	void addpath(const std::string & x) { paths.push_back(x); };
+	void addpath(const std::string & x) { paths.push_back(x); menu_.clear(); accept_.clear(); };
 	
+	/// resolve the requested paths against the HLT menu into a mask of accepted bits. 
+	///   Menus only change at run boundaries, so this is needed once per run.
+	void setMenu(const std::vector<std::string> & menu);
+	/// check the fired bits against the mask built by the last setMenu
+	bool pass(const std::vector<unsigned short> & bits) const;
+	/// same as setMenu(menu) followed by pass(bits); the menu is only resolved when it changes
 	bool pass(const std::vector<std::string> & menu, const std::vector<unsigned short> & bits);  
 	
 	int firstrun,  lastrun;
 	std::vector<std::string> paths;
+
+private:
+	std::vector<std::string> menu_;
+	std::vector<char> accept_;
 };
 
 #endif
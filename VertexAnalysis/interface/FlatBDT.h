@@ -0,0 +1,76 @@
+#ifndef hgg_FlatBDT_h
+#define hgg_FlatBDT_h
+
+#include <vector>
+#include <string>
+
+class TXMLEngine;
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+/**
+ *
+ * \class FlatBDT
+ * Compiled boosted decision tree read from a TMVA BDT weights file.
+ *
+ * All the trees are stored in one contiguous node table and evaluated without going through TMVA::Reader.
+ * The response reproduces MethodBDT::GetMvaValue: weighted average of the leaf values for AdaBoost-like
+ * forests, 2/(1+exp(-2*sum))-1 for gradient boosting.
+ * Only plain BDT methods without input variable transformations or preselection cuts are supported:
+ * load returns false otherwise, and the caller is expected to stay with the Reader.
+ *
+ * usage example:
+ * <code>
+ * FlatBDT bdt;
+ * if( bdt.load("aux/TMVAClassification_BDTvtxprob2012.weights.xml") ) {
+ *     bdt.evaluate(inputs,nrows,mvas); // inputs is [nrows x bdt.nVariables()]
+ * }
+ * </code>
+ */
+class FlatBDT
+{
+public:
+	FlatBDT();
+
+	// read the weights file; if variables is not empty, the input variables must match it (same order)
+	bool load(const std::string & weightsFile, const std::vector<std::string> & variables=std::vector<std::string>());
+	void clear();
+
+	bool valid() const { return ! roots_.empty(); };
+	int nVariables() const { return variables_.size(); };
+	int nTrees() const { return roots_.size(); };
+	const std::vector<std::string> & variables() const { return variables_; };
+
+	// single row evaluation
+	double evaluate(const float * x) const;
+	// evaluate nrows rows of nVariables() inputs each, looping over trees in the outer loop
+	void evaluate(const float * x, int nrows, float * out) const;
+
+private:
+	bool loadXML(TXMLEngine & xml, void * root, const std::vector<std::string> & variables);
+	int addNode(TXMLEngine & xml, void * node);
+	double response(double sum) const;
+
+	bool gradBoost_;
+	bool useYesNoLeaf_;
+	bool regression_;
+	double norm_;
+
+	std::vector<std::string> variables_;
+
+	/** node table. Intermediate nodes have non-negative indexes, leaves are encoded as ~ileaf.
+	    The daughter to follow is ge_ when x[cutIndex_] >= cutValue_, lt_ otherwise. */
+	std::vector<int> cutIndex_;
+	std::vector<float> cutValue_;
+	std::vector<int> lt_, ge_;
+	std::vector<float> leafValue_;
+
+	std::vector<int> roots_;
+	std::vector<double> boostWeights_;
+};
+
+#endif
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 8
+// End:
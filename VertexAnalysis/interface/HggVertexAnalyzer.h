@@ -11,9 +11,12 @@
 #include "TLorentzVector.h"
 #include "TVector2.h"
 #include "TVector3.h"
-#include "TMatrixDSym.h"
 #include "TF2.h"
 
+#ifndef __CINT__
+#include "FlatBDT.h"
+#endif
+
 namespace TMVA { class Reader; }
 
 class VertexAlgoParameters;
@@ -176,8 +179,15 @@ private:
 	// TMVA interface
 	static std::vector<getter_t> varmeths_;
 	static std::vector<float> vars_;
+	static std::vector<std::string> varnames_;
+
+	/// per-vertex BDTs compiled from the weights booked in the readers (invalid if the method is not supported)
+	std::map<std::pair<TMVA::Reader *,std::string>,FlatBDT> compiledMvas_;
+	const FlatBDT * compiledMva(TMVA::Reader & reader, const std::string & method);
 #endif
 	void fillVariables(int iv);
+	/// MVA inputs for all the vertices, laid out as [vertex][variable]
+	std::vector<float> mvaInputs_;
 	
 	std::vector<int> preselection();
 	void newpair(int ipair);
@@ -196,7 +206,6 @@ private:
 	std::vector<std::vector<float> > mva_, rcomb_;
 	
 	// buffers
-	std::vector<std::vector<TLorentzVector> > diPhoton_;
 	std::vector<std::vector<float> > diphopt_;
 	std::vector<std::vector<float> > diphopx_;
 	std::vector<std::vector<float> > diphopy_;
@@ -220,8 +229,6 @@ private:
 	std::vector<std::vector<float> > ptmax_;
 	std::vector<std::vector<float> > nchthr_;
 	std::vector<std::vector<float> > nch_;
-	std::vector<std::vector<std::vector<float> > > tksPt_;
-	std::vector<std::vector<TMatrixDSym> > sphers_;
 	std::vector<std::vector<float> > sumpr_;
 	std::vector<std::vector<float> > spher_;
 	std::vector<std::vector<float> > tspher_;
@@ -229,15 +236,10 @@ private:
 	std::vector<std::vector<float> > threejetC_;
 	std::vector<std::vector<float> > fourjetD_;
 
-	std::vector<std::vector<TVector3> > vtxP_;
-	std::vector<std::vector<TVector2> > vtxPt_;
 	std::vector<std::vector<float> > ptvtx_;
 	std::vector<std::vector<float> > pxvtx_;
 	std::vector<std::vector<float> > pyvtx_;
 
-	std::vector<std::vector<TVector2> > diPhotonPt_;
-	std::vector<std::vector<float> > diPhotonPz_;
-	
 	std::vector<std::vector<float> > acosA_;
 	std::vector<std::vector<float> > ptasym_;
 
@@ -257,6 +259,30 @@ private:
 	std::vector<int> pho1_, pho2_;
 	std::vector<int> * ppho1_, * ppho2_;
 	int ninvalid_idxs_;
+
+	/** per-pair kinematic buffers, not persisted.
+	    One contiguous block of nPairKinVars*nvtx_ doubles per photon pair, laid out as [variable][vertex].
+	    The sphericity tensor is stored as its packed lower triangle.
+	*/
+	enum pairKinVar_t { kDiPhoPx=0, kDiPhoPy, kDiPhoPz, kDiPhoE, kVtxPx, kVtxPy, kVtxPz, 
+			    kSpher00, kSpher10, kSpher11, kSpher20, kSpher21, kSpher22, nPairKinVars };
+	std::vector<double> pairKin_;
+	double * pairKin(int ipair, int var) { return &pairKin_[(ipair*nPairKinVars+var)*nvtx_]; };
+	/// sorted track pts of the vertex being analyzed
+	std::vector<float> tksPt_;
+	/// vertex to tracks association, for adapters that only provide the track to vertex one
+	std::vector<unsigned short> vtxTracksBuf_;
+	std::vector<int> vtxTracksSizeBuf_;
+
+	/// per-vertex vectors released by clear(), recycled for the next pairs
+	std::vector<std::vector<float> > pairVarPool_;
+	void newPairVar(std::vector<std::vector<float> > & var, float init);
+	void releasePairVars(size_t npairs);
+#ifndef __CINT__
+	typedef std::vector<std::vector<float> > HggVertexAnalyzer::* pair_var_member_t;
+	typedef std::vector<std::pair<pair_var_member_t,float> > pair_var_list_t;
+	static const pair_var_list_t & pairVars();
+#endif
 	
 	std::vector<std::vector<float> > * pmva, * prcomb ;
 	std::vector<float>               * pvertexz ;
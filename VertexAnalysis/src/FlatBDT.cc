@@ -0,0 +1,266 @@
+#include "../interface/FlatBDT.h"
+
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include "TXMLEngine.h"
+
+using namespace std;
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace {
+	const int badNode = INT_MIN;
+
+	/// read an attribute the same way TMVA does (stream extraction into the target type)
+	template<class T> bool readAttr(TXMLEngine & xml, XMLNodePointer_t node, const char * name, T & val)
+	{
+		const char * attr = xml.GetAttr(node,name);
+		if( attr == 0 ) { return false; }
+		std::istringstream str(attr);
+		str >> val;
+		return ! str.fail();
+	}
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+FlatBDT::FlatBDT() :
+	gradBoost_(false), useYesNoLeaf_(true), regression_(false), norm_(0.)
+{}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+void FlatBDT::clear()
+{
+	gradBoost_ = false;
+	useYesNoLeaf_ = true;
+	regression_ = false;
+	norm_ = 0.;
+	variables_.clear();
+	cutIndex_.clear();
+	cutValue_.clear();
+	lt_.clear();
+	ge_.clear();
+	leafValue_.clear();
+	roots_.clear();
+	boostWeights_.clear();
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool FlatBDT::load(const std::string & weightsFile, const std::vector<std::string> & variables)
+{
+	clear();
+	TXMLEngine xml;
+	XMLDocPointer_t doc = xml.ParseFile(weightsFile.c_str());
+	if( doc == 0 ) {
+		std::cerr << "FlatBDT: cannot parse " << weightsFile << std::endl;
+		return false;
+	}
+	bool ok = loadXML(xml,xml.DocGetRootElement(doc),variables);
+	xml.FreeDoc(doc);
+	if( ! ok ) {
+		std::cerr << "FlatBDT: " << weightsFile << " cannot be compiled, keeping TMVA::Reader" << std::endl;
+		clear();
+	}
+	return ok;
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+bool FlatBDT::loadXML(TXMLEngine & xml, void * root, const std::vector<std::string> & variables)
+{
+	if( root == 0 || strcmp(xml.GetNodeName(root),"MethodSetup") != 0 ) { return false; }
+	const char * method = xml.GetAttr(root,"Method");
+	if( method == 0 || strncmp(method,"BDT::",5) != 0 ) { return false; }
+
+	std::string boostType;
+	XMLNodePointer_t weights = 0;
+	for(XMLNodePointer_t child = xml.GetChild(root); child != 0; child = xml.GetNext(child) ) {
+		std::string name = xml.GetNodeName(child);
+		if( name == "Options" ) {
+			for(XMLNodePointer_t opt = xml.GetChild(child); opt != 0; opt = xml.GetNext(opt) ) {
+				const char * optName = xml.GetAttr(opt,"name");
+				const char * content = xml.GetNodeContent(opt);
+				if( optName == 0 || content == 0 ) { continue; }
+				if( strcmp(optName,"BoostType") == 0 ) {
+					boostType = content;
+				} else if( strcmp(optName,"UseYesNoLeaf") == 0 ) {
+					useYesNoLeaf_ = ( strcmp(content,"True") == 0 || strcmp(content,"1") == 0 );
+				}
+			}
+		} else if( name == "Variables" ) {
+			for(XMLNodePointer_t var = xml.GetChild(child); var != 0; var = xml.GetNext(var) ) {
+				const char * expr = xml.GetAttr(var,"Expression");
+				if( expr == 0 ) { return false; }
+				size_t ivar = variables_.size();
+				if( ! variables.empty() ) {
+					const char * label = xml.GetAttr(var,"Label");
+					if( ivar >= variables.size() || ( variables[ivar] != expr && (label == 0 || variables[ivar] != label) ) ) {
+						std::cerr << "FlatBDT: variable " << ivar << " is " << expr << " in the weights file" << std::endl;
+						return false;
+					}
+				}
+				variables_.push_back(expr);
+			}
+		} else if( name == "Transformations" ) {
+			int ntrans = 0;
+			if( readAttr(xml,child,"NTransformations",ntrans) && ntrans != 0 ) { return false; }
+		} else if( name == "Weights" ) {
+			weights = child;
+		}
+	}
+	if( weights == 0 || variables_.empty() || ( ! variables.empty() && variables.size() != variables_.size() ) ) { return false; }
+
+	// only plain AdaBoost (or bagging) and gradient boosting have the simple response reproduced here
+	if( boostType == "Grad" ) {
+		gradBoost_ = true;
+	} else if( boostType != "AdaBoost" && boostType != "Bagging" ) {
+		return false;
+	}
+
+	// event preselection cuts are applied by the method before the forest
+	if( xml.HasAttr(weights,"PreselectionLowBkgVar0") ) { return false; }
+	int analysisType = 0;
+	if( ! readAttr(xml,weights,"AnalysisType",analysisType) && ! readAttr(xml,weights,"TreeType",analysisType) ) { return false; }
+	regression_ = ( analysisType == 1 );
+
+	for(XMLNodePointer_t tree = xml.GetChild(weights); tree != 0; tree = xml.GetNext(tree) ) {
+		if( strcmp(xml.GetNodeName(tree),"BinaryTree") != 0 ) { continue; }
+		double boostWeight = 1.;
+		readAttr(xml,tree,"boostWeight",boostWeight);
+		XMLNodePointer_t top = xml.GetChild(tree);
+		while( top != 0 && strcmp(xml.GetNodeName(top),"Node") != 0 ) { top = xml.GetNext(top); }
+		if( top == 0 ) { return false; }
+		int inode = addNode(xml,top);
+		if( inode == badNode ) { return false; }
+		roots_.push_back(inode);
+		boostWeights_.push_back(boostWeight);
+		norm_ += boostWeight;
+	}
+
+	return ! roots_.empty();
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+int FlatBDT::addNode(TXMLEngine & xml, void * node)
+{
+	int nType = 0;
+	readAttr(xml,node,"nType",nType);
+	XMLNodePointer_t left = 0, right = 0;
+	for(XMLNodePointer_t child = xml.GetChild(node); child != 0; child = xml.GetNext(child) ) {
+		const char * pos = xml.GetAttr(child,"pos");
+		if( strcmp(xml.GetNodeName(child),"Node") != 0 || pos == 0 ) { continue; }
+		if( *pos == 'l' ) { left = child; }
+		else if( *pos == 'r' ) { right = child; }
+	}
+
+	// leaf: same value as DecisionTree::CheckEvent
+	if( nType != 0 ) {
+		float value = 0.;
+		if( regression_ ) {
+			if( ! readAttr(xml,node,"res",value) ) { return badNode; }
+		} else if( useYesNoLeaf_ && ! gradBoost_ ) {
+			value = nType;
+		} else if( ! readAttr(xml,node,"purity",value) ) {
+			// old weight files only store the signal and background yields
+			float nS = 0., nB = 0.;
+			if( ! readAttr(xml,node,"nS",nS) || ! readAttr(xml,node,"nB",nB) ) { return badNode; }
+			value = ( nS + nB > 0. ? nS / (nS + nB) : 0. );
+		}
+		leafValue_.push_back(value);
+		return ~(int)(leafValue_.size()-1);
+	}
+
+	// intermediate node
+	int ncoef = 0, ivar = -1, cType = 1;
+	float cut = 0.;
+	readAttr(xml,node,"NCoef",ncoef);
+	if( ncoef != 0 || left == 0 || right == 0 || ! readAttr(xml,node,"IVar",ivar) || ivar < 0 || ivar >= nVariables() ||
+	    ! readAttr(xml,node,"Cut",cut) || ! readAttr(xml,node,"cType",cType) ) {
+		return badNode;
+	}
+	int inode = cutIndex_.size();
+	cutIndex_.push_back(ivar);
+	cutValue_.push_back(cut);
+	lt_.push_back(badNode);
+	ge_.push_back(badNode);
+
+	int ileft = addNode(xml,left);
+	int iright = addNode(xml,right);
+	if( ileft == badNode || iright == badNode ) { return badNode; }
+	// cType selects whether the right daughter is the one passing the cut
+	ge_[inode] = cType ? iright : ileft;
+	lt_[inode] = cType ? ileft : iright;
+
+	return inode;
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+double FlatBDT::response(double sum) const
+{
+	if( gradBoost_ ) {
+		return 2.0/(1.0+exp(-2.0*sum))-1;
+	}
+	return ( norm_ > std::numeric_limits<double>::epsilon() ? sum / norm_ : 0. );
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+double FlatBDT::evaluate(const float * x) const
+{
+	assert( valid() );
+	double sum = 0.;
+	for(int itree=0; itree<nTrees(); ++itree) {
+		int inode = roots_[itree];
+		while( inode >= 0 ) {
+			inode = x[cutIndex_[inode]] >= cutValue_[inode] ? ge_[inode] : lt_[inode];
+		}
+		sum += ( gradBoost_ ? 1. : boostWeights_[itree] ) * leafValue_[~inode];
+	}
+	return response(sum);
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+void FlatBDT::evaluate(const float * x, int nrows, float * out) const
+{
+	assert( valid() );
+	const int nvars = nVariables();
+	const int ntrees = nTrees();
+	const int * cutIndex = cutIndex_.empty() ? 0 : &cutIndex_[0];
+	const float * cutValue = cutIndex_.empty() ? 0 : &cutValue_[0];
+	const int * lt = cutIndex_.empty() ? 0 : &lt_[0];
+	const int * ge = cutIndex_.empty() ? 0 : &ge_[0];
+	const float * leafValue = &leafValue_[0];
+
+	// rows are processed in blocks, so that the sums stay on the stack
+	const int blockSize = 64;
+	double sum[blockSize];
+	for(int first=0; first<nrows; first+=blockSize) {
+		const int nblock = std::min(blockSize,nrows-first);
+		const float * xblock = x + first*nvars;
+		std::fill(sum,sum+nblock,0.);
+		for(int itree=0; itree<ntrees; ++itree) {
+			const int root = roots_[itree];
+			const double weight = gradBoost_ ? 1. : boostWeights_[itree];
+			for(int irow=0; irow<nblock; ++irow) {
+				const float * xrow = xblock + irow*nvars;
+				int inode = root;
+				while( inode >= 0 ) {
+					inode = xrow[cutIndex[inode]] >= cutValue[inode] ? ge[inode] : lt[inode];
+				}
+				sum[irow] += weight * leafValue[~inode];
+			}
+		}
+		for(int irow=0; irow<nblock; ++irow) {
+			out[first+irow] = response(sum[irow]);
+		}
+	}
+}
+
+// Local Variables:
+// mode: c++
+// c-basic-offset: 8
+// End:
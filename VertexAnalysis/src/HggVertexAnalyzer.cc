@@ -8,25 +8,123 @@
 #include <algorithm>
 #include <numeric>
 #include <iterator>
+#include <iostream>
 
 #include <assert.h>
 
-#include "TMatrixDSym.h"
-#include "TMatrixDSymEigen.h"
-#include "TVectorD.h"
 #include "TTree.h"
 #include "TBranch.h"
 
 #include "TMVA/Reader.h"
+#include "TMVA/MethodBase.h"
+
+#include "RootLock.h"
 
 using namespace std;
 
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------
 const float HggVertexAnalyzer::spherPwr_(1.5);
 
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace {
+	/// Fixed size symmetric 3x3 matrix, used for the sphericity tensor
+	struct SymMatrix3 
+	{
+		double m00, m10, m11, m20, m21, m22;
+
+		SymMatrix3(const double * packed, int stride) : 
+			m00(packed[0]), m10(packed[stride]), m11(packed[2*stride]), 
+			m20(packed[3*stride]), m21(packed[4*stride]), m22(packed[5*stride]) 
+		{};
+		
+		SymMatrix3 & operator *= (double s) { 
+			m00 *= s; m10 *= s; m11 *= s; m20 *= s; m21 *= s; m22 *= s; 
+			return *this; 
+		};
+		
+		/// eigenvalues in descending order (cyclic Jacobi rotations)
+		void eigenValues(double * eig) const 
+		{
+			double a[3][3] = { { m00, m10, m20 }, { m10, m11, m21 }, { m20, m21, m22 } };
+			for(int isweep=0; isweep<50; ++isweep) {
+				double off = fabs(a[1][0]) + fabs(a[2][0]) + fabs(a[2][1]);
+				if( off == 0. || off != off ) { break; }
+				for(int ip=0; ip<2; ++ip) {
+					for(int iq=ip+1; iq<3; ++iq) {
+						if( a[iq][ip] == 0. ) { continue; }
+						double theta = 0.5 * (a[iq][iq] - a[ip][ip]) / a[iq][ip];
+						double t = 1. / (fabs(theta) + sqrt(theta*theta + 1.));
+						if( theta < 0. ) { t = -t; }
+						double c = 1. / sqrt(t*t + 1.), s = t * c;
+						for(int k=0; k<3; ++k) {
+							double akp = a[k][ip], akq = a[k][iq];
+							a[k][ip] = c*akp - s*akq;
+							a[k][iq] = s*akp + c*akq;
+						}
+						for(int k=0; k<3; ++k) {
+							double apk = a[ip][k], aqk = a[iq][k];
+							a[ip][k] = c*apk - s*aqk;
+							a[iq][k] = s*apk + c*aqk;
+						}
+					}
+				}
+			}
+			eig[0] = a[0][0]; eig[1] = a[1][1]; eig[2] = a[2][2];
+			sort(eig,eig+3,greater<double>());
+		};
+	};
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+const HggVertexAnalyzer::pair_var_list_t & HggVertexAnalyzer::pairVars()
+{
+	static pair_var_list_t vars;
+	if( vars.empty() ) {
+		vars.push_back( make_pair(&HggVertexAnalyzer::rcomb_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::mva_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::pulltoconv_, 1000.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::limpulltoconv_, 1000.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::ptbal_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::thrust_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumpt_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumpt2_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumpt2in_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumpt2out_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumawy_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumtwd_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumtrv_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumweight_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::ptmax_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::nchthr_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::nch_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::nchpho1_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::nchpho2_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::sumpr_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::spher_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::tspher_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::aplan_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::threejetC_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::fourjetD_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::diphopt_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::diphopx_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::diphopy_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::ptvtx_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::pxvtx_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::pyvtx_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::acosA_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::ptasym_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::ptmax3_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::ptratio_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::pzasym_, 0.) );
+		vars.push_back( make_pair(&HggVertexAnalyzer::awytwdasym_, 0.) );
+	}
+	return vars;
+}
+
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------
 vector<float> HggVertexAnalyzer::vars_;
 vector<HggVertexAnalyzer::getter_t> HggVertexAnalyzer::varmeths_;
+vector<string> HggVertexAnalyzer::varnames_;
 
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------
 HggVertexAnalyzer::dict_t & HggVertexAnalyzer::dictionary() 
@@ -402,6 +500,7 @@ void HggVertexAnalyzer::bookVariables(TMVA::Reader & reader,const std::vector<st
 {
 	vars_.resize(order.size(),0.);
 	varmeths_.resize(order.size(),0);
+	varnames_ = order;
 	for(size_t ivar=0; ivar<order.size(); ++ivar) {
 		reader.AddVariable( order[ivar], &vars_[ivar] );
 		varmeths_[ivar] = dictionary()[order[ivar]].first;
@@ -452,6 +551,8 @@ void HggVertexAnalyzer::fillVariables(int iv)
 float HggVertexAnalyzer::perEventMva(TMVA::Reader & reader,const  std::string & method, const std::vector<int> & rankedVertexes, 
 				     float deltaZRescale )
 {
+	// the reader inputs are static members, shared among all the instances
+	R__LOCKGUARD(gRootLock);
 	int v0      = rankedVertexes[0];
 	float z0    = vertexz(v0);
 	evt_diphoPt = diphopt(v0);
@@ -469,6 +570,7 @@ float HggVertexAnalyzer::perEventMva(TMVA::Reader & reader,const  std::string &
 float HggVertexAnalyzer::vertexProbability(float perEventMva,float nvtx)
 {
 	if( vertexProbability_ == 0 && params_.vtxProbFormula != "" ) {
+		R__LOCKGUARD(gRootLock);
 		vertexProbability_ = new TF2("vtxProb",params_.vtxProbFormula.c_str());
 	}
 	assert(vertexProbability_!=0);
@@ -552,12 +654,47 @@ void HggVertexAnalyzer::evaluate(TMVA::Reader &reader, const std::string & metho
 	/// assert( (size_t)ipair_ < pho1_.size() );
 	nvtx_ = sumpt2_[ipair_].size();
 	mva_.resize(ipair_+1); mva_[ipair_].resize(nvtx_,0.);
+	if( nvtx_ == 0 ) { return; }
+	
+	const FlatBDT * forest = compiledMva(reader,method);
+	if( forest != 0 ) {
+		// fill the inputs for all the vertices and run the forest on them in one go
+		int nvars = forest->nVariables();
+		mvaInputs_.resize(nvtx_*nvars);
+		for(int ivar=0; ivar<nvars; ++ivar) {
+			getter_t getter = varmeths_[ivar];
+			for(int ii=0; ii<nvtx_; ++ii) {
+				mvaInputs_[ii*nvars+ivar] = ((*this).*getter)(ii);
+			}
+		}
+		forest->evaluate(&mvaInputs_[0],nvtx_,&mva_[ipair_][0]);
+		return;
+	}
+	
+	// the reader inputs are static members, shared among all the instances
+	R__LOCKGUARD(gRootLock);
 	for(int ii=0; ii<nvtx_; ++ii) {
 		fillVariables(ii);
 		mva_[ipair_][ii] = reader.EvaluateMVA(method);
 	}
 }
 
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+const FlatBDT * HggVertexAnalyzer::compiledMva(TMVA::Reader & reader, const std::string & method)
+{
+	std::pair<TMVA::Reader *,std::string> key(&reader,method);
+	std::map<std::pair<TMVA::Reader *,std::string>,FlatBDT>::iterator it = compiledMvas_.find(key);
+	if( it == compiledMvas_.end() ) {
+		R__LOCKGUARD(gRootLock);
+		it = compiledMvas_.insert( std::make_pair(key,FlatBDT()) ).first;
+		TMVA::MethodBase * mb = dynamic_cast<TMVA::MethodBase *>(reader.FindMVA(method));
+		if( mb != 0 && it->second.load( mb->GetWeightFileName().Data(), varnames_ ) ) {
+			std::cout << "HggVertexAnalyzer: evaluating " << method << " with " << it->second.nTrees() << " compiled trees" << std::endl;
+		}
+	}
+	return it->second.valid() ? &it->second : 0;
+}
+
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------
 std::vector<int> HggVertexAnalyzer::rankprod(const vector<string> & vars)
 {
@@ -621,63 +758,40 @@ int HggVertexAnalyzer::pairID(int pho1, int pho2)
 void HggVertexAnalyzer::clear()
 {
 	/// std::cerr << "HggVertexAnalyzer::clear" << std::endl;
-	mva_.clear();
-	rcomb_.clear();
+	releasePairVars(0);
 	
 	pho1_.clear();
 	pho2_.clear();
 
 	nconv_.clear();
 	nlegs_.clear();
-	pulltoconv_.clear();
-	limpulltoconv_.clear();
-	ptbal_.clear();
-	thrust_.clear();
-	sumpt_.clear();
-	sumpt2_.clear();
-	sumpt2in_.clear();
-	sumpt2out_.clear();
-	sumawy_.clear();
-	sumtwd_.clear();
-	sumtrv_.clear();
-	sumweight_.clear();
-	ptmax_.clear();
-	nchthr_.clear();
-	nch_.clear();
-	nchpho1_.clear();
-	nchpho2_.clear();
-	vtxP_.clear();
-	tksPt_.clear();
-	sphers_.clear();
-	sumpr_.clear();
-	spher_.clear();
-	tspher_.clear();
-	aplan_.clear();
-	threejetC_.clear();
-	fourjetD_.clear();
-	
-	diphopt_.clear();
-	diphopx_.clear();
-	diphopy_.clear();
-	diPhotonPt_.clear();
-	vtxPt_.clear();
-	ptvtx_.clear();
-	pxvtx_.clear();
-	pyvtx_.clear();
-	diPhotonPz_.clear();
-	
-	acosA_.clear();
-	ptasym_.clear();
-	
-	ptmax3_.clear();
-	thrust_.clear();
-	
-	ptratio_.clear();
-	pzasym_.clear();
 	
-	awytwdasym_.clear();
-	
-	diPhoton_.clear();
+	pairKin_.clear();
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+void HggVertexAnalyzer::newPairVar(std::vector<std::vector<float> > & var, float init)
+{
+	var.resize(ipair_+1);
+	if( ! pairVarPool_.empty() ) {
+		var[ipair_].swap(pairVarPool_.back());
+		pairVarPool_.pop_back();
+	}
+	var[ipair_].assign(nvtx_,init);
+}
+
+// -------------------------------------------------------------------------------------------------------------------------------------------------------------
+void HggVertexAnalyzer::releasePairVars(size_t npairs)
+{
+	const pair_var_list_t & vars = pairVars();
+	for(pair_var_list_t::const_iterator ivar=vars.begin(); ivar!=vars.end(); ++ivar) {
+		std::vector<std::vector<float> > & var = this->*(ivar->first);
+		for(size_t ipair=npairs; ipair<var.size(); ++ipair) {
+			pairVarPool_.push_back(std::vector<float>());
+			pairVarPool_.back().swap(var[ipair]);
+		}
+		var.resize(std::min(npairs,var.size()));
+	}
 }
 
 // -------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -708,59 +822,10 @@ void HggVertexAnalyzer::discardLastDipho()
 	pho1_.resize(ipair_);
 	pho2_.resize(ipair_);
 	
-	rcomb_.resize(ipair_);
-	mva_.resize(ipair_);
 	nconv_.resize(ipair_,0.);
 	nlegs_.resize(ipair_,0.);
-	pulltoconv_.resize(ipair_);
-	limpulltoconv_.resize(ipair_);
-	ptbal_.resize(ipair_);
-	thrust_.resize(ipair_);
-	sumpt_.resize(ipair_);
-	sumpt2_.resize(ipair_);
-	sumpt2in_.resize(ipair_);
-	sumpt2out_.resize(ipair_);
-	sumawy_.resize(ipair_);
-	sumtwd_.resize(ipair_);
-	sumtrv_.resize(ipair_);
-	sumweight_.resize(ipair_);
-	ptmax_.resize(ipair_);
-	nchthr_.resize(ipair_);
-	nch_.resize(ipair_);
-	nchpho1_.resize(ipair_);
-	nchpho2_.resize(ipair_);
-	vtxP_.resize(ipair_);
-	tksPt_.resize(ipair_);
-	sphers_.resize(ipair_);
-	sumpr_.resize(ipair_);
-	spher_.resize(ipair_);
-	tspher_.resize(ipair_);
-	aplan_.resize(ipair_);
-	threejetC_.resize(ipair_);
-	fourjetD_.resize(ipair_);
-	
-	diphopt_.resize(ipair_);
-	diphopx_.resize(ipair_);
-	diphopy_.resize(ipair_);
-	diPhotonPt_.resize(ipair_);
-	vtxPt_.resize(ipair_);
-	ptvtx_.resize(ipair_);
-	pxvtx_.resize(ipair_);
-	pyvtx_.resize(ipair_);
-	diPhotonPz_.resize(ipair_);
-		
-	acosA_.resize(ipair_);
-	ptasym_.resize(ipair_);
-		
-	ptmax3_.resize(ipair_);
-	thrust_.resize(ipair_);
-	
-	ptratio_.resize(ipair_);
-	pzasym_.resize(ipair_);
-		
-	awytwdasym_.resize(ipair_);
-	
-	diPhoton_.resize(ipair_);
+	releasePairVars(ipair_);
+	pairKin_.resize(ipair_*nPairKinVars*nvtx_);
 	
 	ipair_ -= 1;
 }
@@ -783,72 +848,29 @@ void HggVertexAnalyzer::analyze(const VertexInfoAdapter & e, const PhotonInfo &
 		ninvalid_idxs_=0;
 
 		// initilise
-		rcomb_.resize(ipair_+1); rcomb_[ipair_].resize(nvtx,0.);
-		mva_.resize(ipair_+1); mva_[ipair_].resize(nvtx,0.);
 		nconv_.resize(ipair_+1,0.);
 		nlegs_.resize(ipair_+1,0.);
 		vertexz_.resize(nvtx,0.);
-		pulltoconv_.resize(ipair_+1); pulltoconv_[ipair_].resize(nvtx,1000.);
-		limpulltoconv_.resize(ipair_+1); limpulltoconv_[ipair_].resize(nvtx,1000.);
-		ptbal_.resize(ipair_+1); ptbal_[ipair_].resize(nvtx,0.);
-		thrust_.resize(ipair_+1); thrust_[ipair_].resize(nvtx,0.);
-		sumpt_.resize(ipair_+1); sumpt_[ipair_].resize(nvtx,0.);
-		sumpt2_.resize(ipair_+1); sumpt2_[ipair_].resize(nvtx,0.);
-		sumpt2in_.resize(ipair_+1); sumpt2in_[ipair_].resize(nvtx,0.);
-		sumpt2out_.resize(ipair_+1); sumpt2out_[ipair_].resize(nvtx,0.);
-		sumawy_.resize(ipair_+1); sumawy_[ipair_].resize(nvtx,0.);
-		sumtwd_.resize(ipair_+1); sumtwd_[ipair_].resize(nvtx,0.);
-		sumtrv_.resize(ipair_+1); sumtrv_[ipair_].resize(nvtx,0.);
-		sumweight_.resize(ipair_+1); sumweight_[ipair_].resize(nvtx,0.);
-		ptmax_.resize(ipair_+1); ptmax_[ipair_].resize(nvtx,0.);
-		nchthr_.resize(ipair_+1); nchthr_[ipair_].resize(nvtx,0.);
-		nch_.resize(ipair_+1); nch_[ipair_].resize(nvtx,0.);
-		nchpho1_.resize(ipair_+1); nchpho1_[ipair_].resize(nvtx,0.);
-		nchpho2_.resize(ipair_+1); nchpho2_[ipair_].resize(nvtx,0.);
-		vtxP_.resize(ipair_+1); vtxP_[ipair_].resize(nvtx,0.);
-		tksPt_.resize(ipair_+1); tksPt_[ipair_].resize(nvtx, vector<float>(1));
-		sphers_.resize(ipair_+1); sphers_[ipair_].resize(nvtx,TMatrixDSym(3));
-		sumpr_.resize(ipair_+1); sumpr_[ipair_].resize(nvtx,0.);
-		spher_.resize(ipair_+1); spher_[ipair_].resize(nvtx,0.);
-		tspher_.resize(ipair_+1); tspher_[ipair_].resize(nvtx,0.);
-		aplan_.resize(ipair_+1); aplan_[ipair_].resize(nvtx,0.);
-		threejetC_.resize(ipair_+1); threejetC_[ipair_].resize(nvtx,0.);
-		fourjetD_.resize(ipair_+1); fourjetD_[ipair_].resize(nvtx,0.);
-		
-		diphopt_.resize(ipair_+1); diphopt_[ipair_].resize(nvtx);
-		diphopx_.resize(ipair_+1); diphopx_[ipair_].resize(nvtx);
-		diphopy_.resize(ipair_+1); diphopy_[ipair_].resize(nvtx);
-		diPhotonPt_.resize(ipair_+1); diPhotonPt_[ipair_].resize(nvtx);
-		vtxPt_.resize(ipair_+1); vtxPt_[ipair_].resize(nvtx);
-		ptvtx_.resize(ipair_+1); ptvtx_[ipair_].resize(nvtx);
-		pxvtx_.resize(ipair_+1); pxvtx_[ipair_].resize(nvtx);
-		pyvtx_.resize(ipair_+1); pyvtx_[ipair_].resize(nvtx);
-		diPhotonPz_.resize(ipair_+1); diPhotonPz_[ipair_].resize(nvtx);
-		
-		acosA_.resize(ipair_+1); acosA_[ipair_].resize(nvtx);
-		ptasym_.resize(ipair_+1); ptasym_[ipair_].resize(nvtx);
-		
-		ptmax3_.resize(ipair_+1); ptmax3_[ipair_].resize(nvtx);
-		thrust_.resize(ipair_+1); thrust_[ipair_].resize(nvtx);
-	
-		ptratio_.resize(ipair_+1); ptratio_[ipair_].resize(nvtx);
-		pzasym_.resize(ipair_+1); pzasym_[ipair_].resize(nvtx);
+		const pair_var_list_t & vars = pairVars();
+		for(pair_var_list_t::const_iterator ivar=vars.begin(); ivar!=vars.end(); ++ivar) {
+			newPairVar(this->*(ivar->first), ivar->second);
+		}
 		
-		awytwdasym_.resize(ipair_+1); awytwdasym_[ipair_].resize(nvtx);
-	
-		diPhoton_.resize(ipair_+1); diPhoton_[ipair_].resize(nvtx);
+		pairKin_.resize((ipair_+1)*nPairKinVars*nvtx, 0.);
+		double * dipho[4] = { pairKin(ipair_,kDiPhoPx), pairKin(ipair_,kDiPhoPy), pairKin(ipair_,kDiPhoPz), pairKin(ipair_,kDiPhoE) };
 		for(int i=0; i<nvtx; ++i) {
-			diPhoton_[ipair_][i] = 
+			TLorentzVector diPhoton = 
 				p1.p4(e.vtxx(i),e.vtxy(i),e.vtxz(i)) +
 				p2.p4(e.vtxx(i),e.vtxy(i),e.vtxz(i));
+			dipho[0][i] = diPhoton.Px(); dipho[1][i] = diPhoton.Py(); dipho[2][i] = diPhoton.Pz(); dipho[3][i] = diPhoton.E();
 		}
 	}
 
-	std::vector<unsigned short> vtxTracksBuf;
-	std::vector<int> vtxTracksSizeBuf;
+	std::vector<unsigned short> & vtxTracksBuf = vtxTracksBuf_;
+	std::vector<int> & vtxTracksSizeBuf = vtxTracksSizeBuf_;
 	if( ! e.hasVtxTracks() ) {
 		vtxTracksBuf.resize(nvtx*e.ntracks());
-		vtxTracksSizeBuf.resize(nvtx,0);
+		vtxTracksSizeBuf.assign(nvtx,0);
 		for(int it=0; it<e.ntracks(); ++it) {
 			int vid = e.tkVtxId(it);
 			int & ntks = vtxTracksSizeBuf[vid];
@@ -896,8 +918,16 @@ void HggVertexAnalyzer::analyze(const VertexInfoAdapter & e, const PhotonInfo &
     //if (p1.isAConversion()) cout << "Photon 1 NTracks: " << p1.nTracks() << " Z from Conversion: " << zconv << " Pull to Conversion: " << szconv << endl;
     //if (p2.isAConversion()) cout << "Photon 2 NTracks: " << p2.nTracks() << " Z from Conversion: " << zconv << " Pull to Conversion: " << szconv << endl;
 	// filling loop over vertexes
+	double * kin = pairKin(ipair_,0);
 	for(int vid=0; vid<e.nvtx(); ++vid) {
 		
+		double * vtxP = kin + kVtxPx*nvtx + vid;
+		double * sphers = kin + kSpher00*nvtx + vid;
+		const TVector3 diPhotonP(kin[kDiPhoPx*nvtx+vid],kin[kDiPhoPy*nvtx+vid],kin[kDiPhoPz*nvtx+vid]);
+		const TVector2 diPhotonPtUnit = diPhotonP.XYvector().Unit();
+		const TVector3 diPhotonPUnit = diPhotonP.Unit();
+		tksPt_.assign(1,0.);
+		
 		const unsigned short * vtxTracks = e.hasVtxTracks() ? e.vtxTracks(vid) : &vtxTracksBuf[ vid*e.ntracks() ];
 		int ntracks = e.hasVtxTracks() ? e.vtxNTracks(vid) : vtxTracksSizeBuf[ vid ];
 
@@ -972,8 +1002,8 @@ void HggVertexAnalyzer::analyze(const VertexInfoAdapter & e, const PhotonInfo &
 
 			sumpt2out_[ipair_][vid] += tkPtVec.Mod2();
 
-			ptbal_[ipair_][vid] -= tkPtVec * diPhoton_[ipair_][vid].Vect().XYvector().Unit();
-			float cosTk = tkPVec.Unit() * diPhoton_[ipair_][vid].Vect().Unit();
+			ptbal_[ipair_][vid] -= tkPtVec * diPhotonPtUnit;
+			float cosTk = tkPVec.Unit() * diPhotonPUnit;
 			float val = tkPtVec.Mod();
 			if ( cosTk < -0.5 )	{
 				sumawy_[ipair_][vid] += val;
@@ -983,23 +1013,26 @@ void HggVertexAnalyzer::analyze(const VertexInfoAdapter & e, const PhotonInfo &
 				sumtrv_[ipair_][vid] += val;
 			}
 			sumweight_[ipair_][vid] += tkWeight;
-			vtxP_[ipair_][vid] += tkPVec;
-			tksPt_[ipair_][vid].push_back(tkPt);
+			vtxP[0] += tkPVec.X();
+			vtxP[nvtx] += tkPVec.Y();
+			vtxP[2*nvtx] += tkPVec.Z();
+			tksPt_.push_back(tkPt);
 			
 			Float_t p[3] = {0.,0.,0.};
 			tkPVec.GetXYZ(p);
+			const double spherWei = pow(tkPVec.Mag(),spherPwr_-2.);
 			for(int j=3; j--;){
 				for(int k=j+1; k--;){
-					(sphers_[ipair_][vid])[j][k] += pow(tkPVec.Mag(),spherPwr_-2.) * p[j]*p[k];
+					sphers[(j*(j+1)/2+k)*nvtx] += spherWei * p[j]*p[k];
 				}
 			}
 			sumpr_[ipair_][vid] += pow(tkPVec.Mag(),spherPwr_);
 		}
 		
-		sphers_[ipair_][vid] *= 1./sumpr_[ipair_][vid];
-		
-		TVectorD eigVals(3);
-		eigVals = TMatrixDSymEigen(sphers_[ipair_][vid]).GetEigenValues();
+		SymMatrix3 spherTensor(sphers,nvtx);
+		spherTensor *= 1./sumpr_[ipair_][vid];
+		double eigVals[3];
+		spherTensor.eigenValues(eigVals);
 
 		spher_[ipair_][vid] = 1.5 * (eigVals[1]+eigVals[2]);
 		tspher_[ipair_][vid] = 2. * eigVals[1] / (eigVals[0]+eigVals[1]);
@@ -1009,27 +1042,28 @@ void HggVertexAnalyzer::analyze(const VertexInfoAdapter & e, const PhotonInfo &
 		fourjetD_[ipair_][vid] = 27. * eigVals[0]*eigVals[1]*eigVals[2];
 
 
-		diPhotonPt_[ipair_][vid] = diPhoton_[ipair_][vid].Vect().XYvector();
-		diphopt_[ipair_][vid]    = diPhotonPt_[ipair_][vid].Mod();
-		diphopx_[ipair_][vid]    = diPhotonPt_[ipair_][vid].X();
-		diphopy_[ipair_][vid]    = diPhotonPt_[ipair_][vid].Y();
-		vtxPt_[ipair_][vid]      = vtxP_[ipair_][vid].XYvector();
-		ptvtx_[ipair_][vid]      = vtxPt_[ipair_][vid].Mod();
-		pxvtx_[ipair_][vid]      = vtxPt_[ipair_][vid].X();
-		pyvtx_[ipair_][vid]      = vtxPt_[ipair_][vid].Y();
-		diPhotonPz_[ipair_][vid]   = diPhoton_[ipair_][vid].Vect().Pz();
+		const TVector2 diPhotonPt = diPhotonP.XYvector();
+		diphopt_[ipair_][vid]    = diPhotonPt.Mod();
+		diphopx_[ipair_][vid]    = diPhotonPt.X();
+		diphopy_[ipair_][vid]    = diPhotonPt.Y();
+		const TVector2 vtxPt(vtxP[0],vtxP[nvtx]);
+		ptvtx_[ipair_][vid]      = vtxPt.Mod();
+		pxvtx_[ipair_][vid]      = vtxPt.X();
+		pyvtx_[ipair_][vid]      = vtxPt.Y();
+		const float diPhotonPz   = diPhotonP.Pz();
+		const double vtxPz       = vtxP[2*nvtx];
 		
- 		sort(tksPt_[ipair_][vid].begin(), tksPt_[ipair_][vid].end(), greater<float>());
+ 		sort(tksPt_.begin(), tksPt_.end(), greater<float>());
 		
-		acosA_[ipair_][vid] =  	acos(vtxPt_[ipair_][vid].Unit() * diPhotonPt_[ipair_][vid].Unit());
-		ptasym_[ipair_][vid] = 	(vtxPt_[ipair_][vid].Mod() - diPhotonPt_[ipair_][vid].Mod())/(vtxPt_[ipair_][vid].Mod() + diPhotonPt_[ipair_][vid].Mod());
+		acosA_[ipair_][vid] =  	acos(vtxPt.Unit() * diPhotonPt.Unit());
+		ptasym_[ipair_][vid] = 	(vtxPt.Mod() - diPhotonPt.Mod())/(vtxPt.Mod() + diPhotonPt.Mod());
 
-		ptmax_ [ipair_][vid] = 	tksPt_[ipair_][vid][0];
-		ptmax3_[ipair_][vid] = 	accumulate(tksPt_[ipair_][vid].begin(),tksPt_[ipair_][vid].begin() + min(tksPt_[ipair_][vid].size(),(size_t)3), 0.0) ;
+		ptmax_ [ipair_][vid] = 	tksPt_[0];
+		ptmax3_[ipair_][vid] = 	accumulate(tksPt_.begin(),tksPt_.begin() + min(tksPt_.size(),(size_t)3), 0.0) ;
 		thrust_[ipair_][vid] = 	ptbal_[ipair_][vid]/sumpt_[ipair_][vid];
 		
-		ptratio_[ipair_][vid] = 	vtxPt_[ipair_][vid].Mod()/diPhotonPt_[ipair_][vid].Mod();
-		pzasym_[ipair_][vid] = 	fabs( (vtxP_[ipair_][vid].Pz() - diPhotonPz_[ipair_][vid])/(vtxP_[ipair_][vid].Pz() + diPhotonPz_[ipair_][vid]) );
+		ptratio_[ipair_][vid] = 	vtxPt.Mod()/diPhotonPt.Mod();
+		pzasym_[ipair_][vid] = 	fabs( (vtxPz - diPhotonPz)/(vtxPz + diPhotonPz) );
 		
 		awytwdasym_[ipair_][vid] = (sumawy_[ipair_][vid]-sumtwd_[ipair_][vid])/(sumawy_[ipair_][vid]+sumtwd_[ipair_][vid]);
 		